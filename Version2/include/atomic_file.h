@@ -0,0 +1,31 @@
+#ifndef ATOMIC_FILE_H
+#define ATOMIC_FILE_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Replace a file so readers see either the old or the new content, never a torn one
+ *
+ * The content goes to a uniquely named temporary file beside path, which is then
+ * renamed over it; concurrent writers to the same path never share a temporary.
+ * The temporary file is removed on every failure, including an exception from write.
+ * @param path Destination file
+ * @param write Writes the content to the (binary) temporary file stream
+ * @param what Description of the file for error messages, e.g. "checkpoint file"
+ * @throws std::runtime_error if the file cannot be written or renamed
+ */
+void writeFileAtomically(const std::string& path, const std::function<void(std::ostream&)>& write,
+                         const std::string& what);
+
+/**
+ * @brief Replace a file with the given bytes (see the streaming overload)
+ * @param path Destination file
+ * @param bytes Complete file content
+ * @param what Description of the file for error messages
+ * @throws std::runtime_error if the file cannot be written or renamed
+ */
+void writeFileAtomically(const std::string& path, const std::string& bytes, const std::string& what);
+
+#endif // ATOMIC_FILE_H
@@ -2,12 +2,25 @@
 #define BACKTRACKING_STRATEGY_H
 
 #include "partition_encryption.h"
+#include "candidate_model.h"
+#include "multiset.h"
+#include "reachability_index.h"
+#include "pair_sum_table.h"
+#include "search_checkpoint.h"
+#include "search_constraints.h"
+#include "work_stealing_pool.h"
+#include <chrono>
+#include <memory>
 #include <unordered_map>
 #include <string>
 #include <vector>
 #include <gmpxx.h>
 #include <set>
 
+// Per-search constants shared by the native kernels (see backtracking_strategy.cpp)
+template <typename Int>
+struct NativeSearch;
+
 /**
  * @class BacktrackingStrategy
  * @brief Implementation of the Backtracking with Pruning decryption strategy
@@ -29,17 +42,88 @@ public:
 
     /**
      * @brief Decrypt using Backtracking with Pruning approach
+     *
+     * Dispatches to a fixed-width integer kernel when the table's sums fit in
+     * 64 or 128 bits and falls back to GMP arithmetic otherwise.
+     * @param targetSum The K value (Z - C) to find partitioning for
+     * @param table Prepared lookup table
+     * @param minLength Minimum allowed password length
+     * @param maxLength Maximum allowed password length
+     * @param visit Called with every candidate; returns false to stop the search
+     * @return True if the search ran to completion, false if the visitor stopped it
+     */
+    bool decrypt(
+        const mpz_class& targetSum,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const SolutionVisitor& visit) override;
+
+    using DecryptionStrategy::decrypt;
+
+    /**
+     * @brief Decrypt reporting each multiset of characters once
+     *
+     * The sum does not depend on character order, so the search only places
+     * characters in table order (descending partition value) and reaches every
+     * multiset exactly once instead of once per ordering. maxSolutions counts
+     * multisets.
      * @param targetSum The K value (Z - C) to find partitioning for
-     * @param charToPartition Map of characters to their partition values
+     * @param table Prepared lookup table
      * @param minLength Minimum allowed password length
      * @param maxLength Maximum allowed password length
-     * @return Possible decryption results (may be multiple or none)
+     * @param visit Called with every multiset (in table order) and its number of
+     *              distinct orderings; returns false to stop the search
+     * @return True if the search ran to completion, false if the visitor stopped it
      */
-    std::vector<std::string> decrypt(
+    bool decryptMultisets(
         const mpz_class& targetSum,
-        const std::unordered_map<char, mpz_class>& charToPartition,
+        const LookupTable& table,
         unsigned int minLength,
-        unsigned int maxLength) override;
+        unsigned int maxLength,
+        const MultisetVisitor& visit);
+
+    /**
+     * @brief Count the passwords that encrypt to a target without listing them
+     *
+     * Sums the multinomial coefficient of every multiset found by decryptMultisets().
+     * @param targetSum The K value (Z - C)
+     * @param table Prepared lookup table
+     * @param minLength Minimum allowed password length
+     * @param maxLength Maximum allowed password length
+     * @return Number of distinct passwords (maxSolutions caps the multisets counted)
+     */
+    mpz_class countSolutions(
+        const mpz_class& targetSum,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength);
+
+    /**
+     * @brief Decrypt many targets, sharing the search between them
+     *
+     * With the exact reachability index each search already costs about as much
+     * as its output, so every distinct target gets its own search on the shared
+     * index and bounds. Without it, one traversal per length answers all targets:
+     * every node carries the slice of the sorted target set its prefix can still
+     * reach, and the last position probes that slice against the value list.
+     * maxSolutions applies to each target separately. The shared traversal runs
+     * on the calling thread; tables wider than 128 bits decrypt target by target.
+     * Batches never write or resume checkpoints, so an existing checkpoint file
+     * is left as it is.
+     * @param targetSums The K values (Z - C) to find partitionings for
+     * @param table Prepared lookup table
+     * @param minLength Minimum allowed password length
+     * @param maxLength Maximum allowed password length
+     * @param visit Called with the target's index and each candidate; returns false to stop
+     * @return True if the search ran to completion, false if the visitor stopped it
+     */
+    bool decryptBatch(
+        const std::vector<mpz_class>& targetSums,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const BatchSolutionVisitor& visit) override;
 
     /**
      * @brief Get the strategy name
@@ -47,6 +131,11 @@ public:
      */
     std::string getName() const override { return "Backtracking with Pruning"; }
 
+    /**
+     * @brief Name plus the solution limit and result order
+     */
+    std::string getCacheTag() const override;
+
     /**
      * @brief Set the maximum number of solutions to find
      * @param maxSols Maximum solutions (0 = unlimited)
@@ -59,91 +148,309 @@ public:
      */
     void setOptimizations(bool enable) { enableOptimizations = enable; }
 
+    /**
+     * @brief Enable or disable the exact reachability index
+     *
+     * When enabled (and optimizations are on), native 64-bit searches prune every
+     * node whose remaining sum cannot be written with the remaining characters,
+     * instead of only checking min/max bounds.
+     * @param enable Whether to build and consult the index
+     */
+    void setReachabilityIndex(bool enable) { useReachabilityIndex = enable; }
+
+    /**
+     * @brief Set the memory budget for the reachability index
+     * @param bytes Maximum index size; larger tables fall back to bounds pruning
+     */
+    void setReachabilityMemoryLimit(size_t bytes) { reachabilityMemoryLimit = bytes; }
+
+    /**
+     * @brief Close the last two positions with a pair-sum hash lookup
+     *
+     * Native 64-bit searches stop descending when two positions remain and look
+     * up every pair of characters with the required sum instead.
+     * @param enable Whether to use the pair lookup
+     */
+    void setPairLookupTail(bool enable) { usePairLookupTail = enable; }
+
+    /**
+     * @brief Set the number of search threads
+     *
+     * With more than one thread, native-width searches split the tree into prefix
+     * subtrees that run on a work-stealing pool. maxSolutions remains an exact
+     * global cutoff, but solutions are no longer returned in depth-first order.
+     * Workers hand solutions to the visitor in small batches; the visitor is
+     * never called concurrently.
+     * @param threads Thread count (1 = sequential, 0 = all hardware threads)
+     */
+    void setThreadCount(unsigned int threads) { threadCount = threads; }
+
+    /**
+     * @brief Search multisets and expand them into passwords lazily
+     *
+     * decrypt() then reaches each multiset once and hands its distinct orderings
+     * to the visitor one at a time. The candidates are the same as without it,
+     * but grouped by multiset instead of in depth-first order. Batches run target
+     * by target in this mode.
+     * @param enable Whether decrypt() searches multisets
+     */
+    void setMultisetSearch(bool enable) { multisetSearch = enable; }
+
+    /**
+     * @brief Search only passwords that satisfy known constraints
+     *
+     * Each position then only tries the symbols it allows, and subtrees are
+     * bounded by the smallest and largest sums the remaining positions allow, so
+     * the search costs about as much as the narrowed space. Constrained searches
+     * run sequentially and are not checkpointed; they cannot be combined with
+     * multiset search or resume(), and batches run target by target.
+     * @param searchConstraints Constraints to honour (empty = none)
+     */
+    void setConstraints(const SearchConstraints& searchConstraints) { constraints = searchConstraints; }
+
+    /**
+     * @brief Get the constraints searches honour
+     */
+    const SearchConstraints& getConstraints() const { return constraints; }
+
+    /**
+     * @brief Emit the candidates of decrypt() in descending probability under a model
+     *
+     * The search becomes best-first over prefixes: the most probable prefix whose
+     * sum can still reach the target with some allowed length is expanded next,
+     * and a password is emitted when it is the most probable entry left, so the
+     * output is in exactly descending model probability. With maxSolutions set,
+     * the search stops after the most plausible candidates instead of the first
+     * ones in table order. When more than maxFrontier prefixes are pending, the
+     * less probable half is dropped, which turns the search into a beam search
+     * that may miss improbable candidates (counted as prunes). Likelihood searches
+     * run sequentially, are not checkpointed, report no per-length progress and
+     * cannot be combined with multiset search or constraints; batches run target
+     * by target.
+     * @param model Scoring model (nullptr = depth-first order)
+     * @param maxFrontier Pending prefixes that trigger dropping (0 = never drop)
+     */
+    void setCandidateModel(std::shared_ptr<const CandidateModel> model,
+                           size_t maxFrontier = size_t(1) << 22) {
+        candidateModel = std::move(model);
+        frontierLimit = maxFrontier;
+    }
+
+    /**
+     * @brief Snapshot the search frontier of decrypt() to a file at an interval
+     *
+     * The file records the current length, the symbol index at each depth of the
+     * next node to visit, the counters and how many candidates were handed to the
+     * visitor. It is rewritten atomically at most once per interval, and once more
+     * with a completion mark when the search finishes. Checkpointed searches run
+     * sequentially, whatever the thread count.
+     * @param path Checkpoint file (empty disables checkpoints)
+     * @param interval Minimum time between two snapshots
+     */
+    void setCheckpoint(const std::string& path,
+                       std::chrono::milliseconds interval = std::chrono::seconds(60)) {
+        checkpointPath = path;
+        checkpointInterval = interval;
+    }
+
+    /**
+     * @brief Continue a decrypt() search from a checkpoint file
+     *
+     * The visitor receives exactly the candidates that come after the snapshot,
+     * in the order the original search would have produced them. Candidates the
+     * original visitor saw after the last snapshot are produced again; the
+     * snapshot's solution count tells how many to keep from an earlier output.
+     * Target, lengths and multiset mode come from the file. If a checkpoint path
+     * is set, the resumed search keeps writing snapshots to it.
+     * @param path Checkpoint file written by a search with setCheckpoint()
+     * @param table Prepared lookup table the search was started with
+     * @param visit Called with every remaining candidate; returns false to stop
+     * @return True if the search ran to completion, false if the visitor stopped it
+     * @throws std::runtime_error if the file cannot be read
+     * @throws std::invalid_argument if the file was written for another table
+     */
+    bool resume(const std::string& path, const LookupTable& table, const SolutionVisitor& visit);
+
 private:
     /**
-     * @brief Recursive backtracking function
-     * @param currentPassword Current partial password being built
-     * @param currentSum Current sum of partition values
+     * @brief Shared body of decrypt() and decryptMultisets()
      * @param targetSum Target sum to reach
-     * @param remainingSum Maximum possible sum from remaining positions
+     * @param table Prepared lookup table
      * @param minLength Minimum password length
      * @param maxLength Maximum password length
-     * @param charToPartition Character to partition mapping
-     * @param sortedChars Sorted characters for optimization
-     * @param results Vector to store found solutions
-     * @return True if should continue searching, false if max solutions reached
-     */
-    bool backtrackRecursive(
-        const std::string& currentPassword,
-        const mpz_class& currentSum,
+     * @param visit Receives passwords, or canonical multisets if canonical && !expand
+     * @param canonical Search non-decreasing symbol sequences only
+     * @param expand Expand each multiset into its distinct orderings
+     * @return True if the search ran to completion, false if the visitor stopped it
+     */
+    bool runSearch(
         const mpz_class& targetSum,
-        const mpz_class& remainingSum,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const SolutionVisitor& visit,
+        bool canonical,
+        bool expand);
+
+    /**
+     * @brief Body of decryptBatch(), run with checkpoints off
+     * @param targetSums Target sums of the batch
+     * @param table Prepared lookup table
+     * @param minLength Minimum password length
+     * @param maxLength Maximum password length
+     * @param visit Receives the target's index and each solution
+     * @return True if the search ran to completion, false if the visitor stopped it
+     */
+    bool runBatch(
+        const std::vector<mpz_class>& targetSums,
+        const LookupTable& table,
         unsigned int minLength,
         unsigned int maxLength,
-        const std::unordered_map<char, mpz_class>& charToPartition,
-        const std::vector<std::pair<char, mpz_class>>& sortedChars,
-        std::vector<std::string>& results);
-
-    /**
-     * @brief Calculate bounds for pruning
-     * @param charToPartition Character to partition mapping
-     * @param minVal Minimum partition value
-     * @param maxVal Maximum partition value
-     */
-    void calculateBounds(
-        const std::unordered_map<char, mpz_class>& charToPartition,
-        mpz_class& minVal,
-        mpz_class& maxVal);
-
-    /**
-     * @brief Check if current path can lead to a valid solution
-     * @param currentSum Current partial sum
-     * @param targetSum Target sum
-     * @param remainingPositions Remaining positions to fill
-     * @param minVal Minimum partition value
-     * @param maxVal Maximum partition value
-     * @param currentLength Current password length
-     * @param minLength Minimum required length
-     * @param maxLength Maximum allowed length
-     * @return True if path is viable, false if should be pruned
-     */
-    bool isViablePath(
-        const mpz_class& currentSum,
+        const BatchSolutionVisitor& visit);
+
+    /**
+     * @brief Write the frontier of the running search to the checkpoint file
+     * @param length Length being searched
+     * @param depth Depth of the next node to visit
+     * @param symbols Symbol indices on the path to that node
+     * @param nodes Nodes visited so far
+     * @param prunes Subtrees pruned so far
+     * @param complete Whether the search has finished
+     */
+    void saveCheckpoint(unsigned int length, unsigned int depth, const SymbolId* symbols,
+                        size_t nodes, size_t prunes, bool complete);
+
+    /**
+     * @brief Search all lengths with native integer arithmetic
+     * @param targetSum Target sum to reach
+     * @param table Prepared lookup table (must provide native values for Int)
+     * @param minLength Minimum password length
+     * @param maxLength Maximum password length
+     * @param emit Receives found solutions; returns false to stop the search
+     * @param recordLengths Record each searched length; batches record them once for all targets
+     */
+    template <typename Int>
+    void decryptNative(
         const mpz_class& targetSum,
-        unsigned int remainingPositions,
-        const mpz_class& minVal,
-        const mpz_class& maxVal,
-        unsigned int currentLength,
+        const LookupTable& table,
         unsigned int minLength,
-        unsigned int maxLength);
+        unsigned int maxLength,
+        const SolutionVisitor& emit,
+        bool recordLengths = true);
 
     /**
-     * @brief Create a sorted list of characters by partition value
-     * @param charToPartition Character to partition mapping
-     * @return Sorted vector of (character, partition_value) pairs
+     * @brief Batch traversal with native integer arithmetic
+     * @param targetSums Target sums of the batch
+     * @param table Prepared lookup table (must provide native values for Int)
+     * @param minLength Minimum password length
+     * @param maxLength Maximum password length
+     * @param visit Receives the target's index and each solution
+     * @return True if the search ran to completion, false if the visitor stopped it
      */
-    std::vector<std::pair<char, mpz_class>> createSortedCharacters(
-        const std::unordered_map<char, mpz_class>& charToPartition);
+    template <typename Int>
+    bool decryptBatchNative(
+        const std::vector<mpz_class>& targetSums,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const BatchSolutionVisitor& visit);
+
+    /**
+     * @brief Search all lengths over the symbols the constraints allow
+     * @param values Partition values in the table's (descending) sort order, as Int
+     * @param target Target sum as Int (at most maxLength times the largest value)
+     * @param table Prepared lookup table
+     * @param minLength Minimum password length
+     * @param maxLength Maximum password length
+     * @param emit Receives found solutions; returns false to stop the search
+     */
+    template <typename Int>
+    void decryptConstrained(
+        const std::vector<Int>& values,
+        const Int& target,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const SolutionVisitor& emit);
+
+    /**
+     * @brief Best-first search of all lengths in descending model probability
+     * @param values Partition values in the table's (descending) sort order, as Int
+     * @param target Target sum as Int (at most maxLength times the largest value)
+     * @param table Prepared lookup table
+     * @param minLength Minimum password length
+     * @param maxLength Maximum password length
+     * @param emit Receives found solutions; returns false to stop the search
+     */
+    template <typename Int>
+    void decryptLikely(
+        const std::vector<Int>& values,
+        const Int& target,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const SolutionVisitor& emit);
 
     /**
-     * @brief Calculate remaining sum potential from current position
+     * @brief Get the reachability index for a 64-bit table, building it if needed
+     * @param table Prepared lookup table
+     * @param maxLength Longest length the index must cover
+     * @return The index, or nullptr when disabled or over the memory budget
+     */
+    const ReachabilityIndex* prepareReachability(const LookupTable& table, unsigned int maxLength);
+
+    /**
+     * @brief Search one length on the work-stealing pool
+     * @param search Search parameters shared by all workers
+     * @param emit Receives found solutions; returns false to stop the search
+     * @return True if should continue searching, false if the search was stopped
+     */
+    template <typename Int>
+    bool searchParallel(const NativeSearch<Int>& search, const SolutionVisitor& emit);
+
+    /**
+     * @brief Search all lengths with GMP arithmetic (tables wider than 128 bits)
+     *
+     * Runs the same iterative kernel as the native path; its frames are
+     * allocated once, so the search does not allocate per node.
      * @param targetSum Target sum to reach
-     * @param currentSum Current partial sum
-     * @param remainingPositions Remaining positions
-     * @param maxVal Maximum partition value
-     * @return Maximum possible remaining sum
+     * @param table Prepared lookup table (sorted characters and values)
+     * @param minLength Minimum password length
+     * @param maxLength Maximum password length
+     * @param emit Receives found solutions; returns false to stop the search
      */
-    mpz_class calculateRemainingSum(
+    void searchArbitrary(
         const mpz_class& targetSum,
-        const mpz_class& currentSum,
-        unsigned int remainingPositions,
-        const mpz_class& maxVal);
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const SolutionVisitor& emit);
 
     bool enableOptimizations;     // Whether to use advanced pruning
     size_t maxSolutions;          // Maximum solutions to find (0 = unlimited)
     mpz_class minPartitionVal;    // Cached minimum partition value
     mpz_class maxPartitionVal;    // Cached maximum partition value
     size_t pruneCount;            // Count of pruned branches for statistics
+    size_t solutionsFound = 0;    // Solutions handed to the visitor by the current search
+    bool useReachabilityIndex = true;                        // Exact pruning for 64-bit tables
+    size_t reachabilityMemoryLimit = size_t(256) << 20;      // Index budget in bytes
+    std::shared_ptr<const ReachabilityIndex> reachability;   // Cached across decrypt calls
+    bool usePairLookupTail = false;                          // Finish with PairSumTable lookups
+    std::shared_ptr<const PairSumTable> pairTable;           // Cached across decrypt calls
+    unsigned int threadCount = 1;                            // 1 = sequential search
+    std::shared_ptr<WorkStealingPool> pool;                  // Reused while threadCount is unchanged
+    bool multisetSearch = false;                             // decrypt() expands multisets
+    SearchConstraints constraints;                           // Empty = unconstrained
+    std::shared_ptr<const CandidateModel> candidateModel;    // Null = depth-first order
+    size_t frontierLimit = size_t(1) << 22;                  // Pending prefixes before dropping (0 = never)
+    bool canonicalSearch = false;                            // Current search places symbols in table order
+    size_t parallelBytes = 0;                                // Peak worker buffers of the current search
+    std::string checkpointPath;                              // Empty = no checkpoints
+    std::chrono::milliseconds checkpointInterval{60000};     // Minimum time between snapshots
+    bool checkpointing = false;                              // Current search writes snapshots
+    SearchCheckpoint checkpointState;                        // Snapshot of the current search
+    const SearchCheckpoint* resumeFrom = nullptr;            // Set while resume() runs
+    bool batchRunning = false;                               // Set while decryptBatch() runs
 };
 
 #endif // BACKTRACKING_STRATEGY_H
\ No newline at end of file
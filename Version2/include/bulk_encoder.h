@@ -0,0 +1,148 @@
+#ifndef BULK_ENCODER_H
+#define BULK_ENCODER_H
+
+#include "work_stealing_pool.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <gmpxx.h>
+
+class LookupTable;
+
+/**
+ * @enum EncryptStatus
+ * @brief Validation result of one password in a batch
+ */
+enum class EncryptStatus : uint8_t {
+    Ok,                 // Encrypted; the output holds Z
+    TooShort,           // Shorter than the minimum password length
+    TooLong,            // Longer than the maximum password length
+    UnknownCharacter    // Contains a character missing from the lookup table
+};
+
+/**
+ * @struct EncodedLine
+ * @brief One line of text encrypted by BulkEncoder::encryptLines()
+ */
+struct EncodedLine {
+    uint64_t encrypted;     // Z if status is Ok
+    size_t begin;           // Offset of the line's first byte
+    size_t length;          // Bytes of the line, without its "\n" or "\r\n"
+    EncryptStatus status;
+};
+
+/**
+ * @class BulkEncoder
+ * @brief Allocation-free encryption of many passwords with native integers
+ *
+ * Every byte maps to its partition value through a dense 256-entry table.
+ * Characters missing from the lookup table map to a marker bit above any
+ * reachable sum, so one addition per character both sums and validates.
+ * Passwords are summed with AVX2 gathers when the CPU supports them and with
+ * a scalar loop otherwise.
+ *
+ * Tables with non-ASCII symbols take a scalar path instead that decodes UTF-8:
+ * ASCII bytes still use the dense table, other code points are found by binary
+ * search, and lengths are counted in code points.
+ */
+class BulkEncoder {
+public:
+    /**
+     * @brief Create an unavailable encoder
+     */
+    BulkEncoder() = default;
+
+    /**
+     * @brief Build the dense table
+     * @param table Prepared lookup table
+     * @param constantC Constant added to every sum
+     * @param minLength Minimum allowed password length
+     * @param maxLength Maximum allowed password length
+     */
+    BulkEncoder(const LookupTable& table,
+                const mpz_class& constantC,
+                unsigned int minLength,
+                unsigned int maxLength);
+
+    /**
+     * @brief Whether every Z fits in 64 bits, which the batch path requires
+     */
+    bool isAvailable() const { return available; }
+
+    /**
+     * @brief Whether the AVX2 kernel is used on this CPU
+     */
+    bool usesAvx2() const;
+
+    /**
+     * @brief Encrypt passwords stored back to back in one buffer
+     * @param data Concatenated password bytes (UTF-8)
+     * @param offsets count + 1 offsets; password i is data[offsets[i], offsets[i + 1])
+     * @param count Number of passwords
+     * @param out Receives Z of every password whose status is Ok (count entries)
+     * @param status Receives the validation result of every password (count entries)
+     * @param threads Worker threads (1 = calling thread only, 0 = all hardware threads)
+     * @return Number of passwords encrypted successfully
+     * @throws std::runtime_error if the encoder is unavailable
+     */
+    size_t encrypt(const char* data, const size_t* offsets, size_t count,
+                   uint64_t* out, EncryptStatus* status, unsigned int threads);
+
+    /**
+     * @brief Encrypt one password with the same kernels as encrypt()
+     *
+     * For scanners that find password boundaries themselves; the encoder must be
+     * available. Safe to call from several threads at once.
+     * @param bytes Password bytes (UTF-8)
+     * @param size Number of bytes
+     * @param out Receives Z if the status is Ok
+     * @return Validation result
+     */
+    EncryptStatus encryptOne(const char* bytes, size_t size, uint64_t& out) const;
+
+    /**
+     * @brief Encrypt the lines of newline-separated text
+     *
+     * Lines end in "\n" or "\r\n"; a last line without a newline counts too.
+     * With single-byte tables one branch-free pass sums every byte and records
+     * the sum at each newline, so words of varying length cost no mispredicted
+     * loop exits; a second pass validates the lines. Other tables encrypt line
+     * by line. The encoder must be available.
+     * @param data Text
+     * @param size Number of bytes
+     * @param lines Receives the lines, in order
+     * @param capacity Entries of lines (more than maxLength + 2)
+     * @param consumed Receives the bytes covered by the returned lines, newlines included
+     * @return Number of lines written (0 only for empty text)
+     * @throws std::invalid_argument if capacity is too small
+     */
+    size_t encryptLines(const char* data, size_t size, EncodedLine* lines, size_t capacity,
+                        size_t& consumed) const;
+
+private:
+    /**
+     * @brief Encrypt the passwords in [begin, end) on the calling thread
+     * @return Number of passwords encrypted successfully
+     */
+    size_t encryptRange(const char* data, const size_t* offsets, size_t begin, size_t end,
+                        uint64_t* out, EncryptStatus* status) const;
+
+    /**
+     * @brief Sum a password symbol by symbol, decoding UTF-8
+     * @return Sum, or invalidMark for malformed text or unknown code points
+     */
+    uint64_t sumUtf8(const char* bytes, size_t size, size_t& symbols) const;
+
+    uint64_t values[256] = {};       // Partition value per byte, invalidMark if unknown
+    std::vector<std::pair<uint32_t, uint64_t>> wideValues; // Non-ASCII code points, ascending
+    uint64_t invalidMark = 0;        // Power of two above every valid sum
+    uint64_t constant = 0;           // Constant C
+    unsigned int minLength = 0;
+    unsigned int maxLength = 0;
+    bool available = false;          // False when sums or Z exceed 64 bits
+    std::shared_ptr<WorkStealingPool> pool; // Reused while the thread count is unchanged
+};
+
+#endif // BULK_ENCODER_H
@@ -0,0 +1,125 @@
+#ifndef CANDIDATE_MODEL_H
+#define CANDIDATE_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class CandidateModel
+ * @brief Scores how likely a password is, one symbol at a time
+ *
+ * A password's score is the sum of the log-probabilities of its symbols, each
+ * given the symbols before it, plus the log-probability of ending after the
+ * last one. BacktrackingStrategy::setCandidateModel() uses it to emit
+ * candidates in descending probability instead of table order. Implementations
+ * must be safe to call concurrently once built.
+ */
+class CandidateModel {
+public:
+    virtual ~CandidateModel() = default;
+
+    /**
+     * @brief Log-probabilities of the possible next symbols
+     * @param history Symbols (UTF-8 code points) chosen so far
+     * @param symbols Candidate next symbols
+     * @param out Receives one natural-log probability (at most 0) per symbol
+     */
+    virtual void nextLogProbabilities(const std::vector<std::string>& history,
+                                      const std::vector<std::string>& symbols,
+                                      std::vector<double>& out) const = 0;
+
+    /**
+     * @brief Log-probability that the password ends after its history
+     * @param history Symbols of the complete password
+     */
+    virtual double endLogProbability(const std::vector<std::string>& history) const = 0;
+
+    /**
+     * @brief Identify the model and its training data, for result cache tags
+     */
+    virtual std::string getTag() const = 0;
+};
+
+/**
+ * @class MarkovModel
+ * @brief Character n-gram model trained from a password corpus
+ *
+ * Each symbol is predicted from the previous order - 1 symbols, with the start
+ * of the password padded by a begin marker and its end predicted as a symbol of
+ * its own. Counts are smoothed with Witten-Bell interpolation down to add-one
+ * unigrams, so symbols the corpus never used keep a small probability.
+ */
+class MarkovModel : public CandidateModel {
+public:
+    /**
+     * @brief Create an empty model
+     * @param order Symbols per n-gram, context included (at least 1)
+     * @throws std::invalid_argument if order is 0
+     */
+    explicit MarkovModel(unsigned int order = 3);
+
+    /**
+     * @brief Count the n-grams of one password
+     * @param password Training password; invalid UTF-8 is skipped
+     * @return False if the password was skipped
+     */
+    bool add(const std::string& password);
+
+    /**
+     * @brief Train from a corpus file with one password per line
+     *
+     * Empty lines and lines that are not valid UTF-8 are skipped.
+     * @param path Corpus file
+     * @return Number of passwords added
+     * @throws std::runtime_error if the file cannot be read
+     */
+    size_t loadCorpus(const std::string& path);
+
+    void nextLogProbabilities(const std::vector<std::string>& history,
+                              const std::vector<std::string>& symbols,
+                              std::vector<double>& out) const override;
+
+    double endLogProbability(const std::vector<std::string>& history) const override;
+
+    /**
+     * @brief Order, number of passwords and a hash of the training data
+     */
+    std::string getTag() const override;
+
+    /**
+     * @brief Number of passwords trained on
+     */
+    size_t getPasswordCount() const { return passwordCount; }
+
+    unsigned int getOrder() const { return order; }
+
+private:
+    /**
+     * @struct Context
+     * @brief Counts of the symbols that followed one context
+     */
+    struct Context {
+        uint64_t total = 0;                                 // Occurrences of the context
+        std::unordered_map<std::string, uint64_t> next;     // Follower -> count ("" = end)
+    };
+
+    /**
+     * @brief Look up the contexts of every order for a history (nullptr = unseen)
+     */
+    void findContexts(const std::vector<std::string>& history, std::vector<const Context*>& out) const;
+
+    /**
+     * @brief Smoothed probability of a follower given the contexts of a history
+     */
+    double probability(const std::vector<const Context*>& contexts, const std::string& symbol) const;
+
+    unsigned int order;
+    std::unordered_map<std::string, Context> contexts;  // Joined context symbols -> counts
+    size_t passwordCount = 0;
+    uint64_t fingerprint = 14695981039346656037ull;     // FNV-1a of the training passwords
+};
+
+#endif // CANDIDATE_MODEL_H
@@ -0,0 +1,265 @@
+#ifndef DECRYPT_SERVICE_H
+#define DECRYPT_SERVICE_H
+
+#include "partition_encryption.h"
+#include "search_control.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gmpxx.h>
+
+/**
+ * @enum JobPriority
+ * @brief Queue a decrypt job is served from
+ */
+enum class JobPriority {
+    Interactive,    // Single lookups someone is waiting for; always served first
+    Batch           // Long-running work; only runs on workers not reserved for interactive jobs
+};
+
+/**
+ * @enum JobStatus
+ * @brief Life cycle of a decrypt job
+ */
+enum class JobStatus {
+    Queued,         // Waiting for a worker
+    Running,        // Being searched
+    Completed,      // Searched completely, or stopped at maxCandidates
+    Cancelled,      // cancel() was called; candidates found until then are kept
+    TimedOut,       // The deadline passed; candidates found until then are kept
+    Failed          // The search threw; see getError()
+};
+
+/**
+ * @struct JobOptions
+ * @brief Scheduling and limits of one decrypt job
+ */
+struct JobOptions {
+    JobPriority priority = JobPriority::Batch;
+    std::chrono::milliseconds timeout{0};   // Deadline measured from submission, 0 = none
+    size_t maxCandidates = 0;               // Stop after this many candidates, 0 = all
+};
+
+/**
+ * @struct JobProgress
+ * @brief Snapshot of a job's progress
+ */
+struct JobProgress {
+    double fraction = 0.0;          // Share of the search space covered, in [0, 1]
+    uint64_t nodes = 0;             // Nodes (or records) visited so far
+    double nodesPerSecond = 0.0;    // Average rate since the job started running
+    size_t candidates = 0;          // Candidates found so far
+    double elapsedSeconds = 0.0;    // Time spent running (0 while queued)
+    unsigned int finishedLength = 0; // Longest password length searched completely
+};
+
+/**
+ * @class DecryptJob
+ * @brief Handle of one asynchronous decryption submitted to a DecryptService
+ *
+ * All methods may be called from any thread while the job is queued, running or
+ * done. Candidates are available as they are found, so a job that was cancelled
+ * or timed out still returns everything it found before it stopped.
+ */
+class DecryptJob {
+public:
+    /**
+     * @brief Get the current status
+     *
+     * A queued job whose deadline has passed is reported (and stays) TimedOut.
+     */
+    JobStatus getStatus();
+
+    /**
+     * @brief Whether the job has reached a final status
+     */
+    bool isDone();
+
+    /**
+     * @brief Block until the job is done
+     */
+    void wait();
+
+    /**
+     * @brief Block until the job is done or a timeout elapses
+     * @param timeout Longest time to wait
+     * @return True if the job is done
+     */
+    bool waitFor(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Stop the job
+     *
+     * A queued job is dropped at once; a running search stops at its next poll of
+     * the search control (every SearchControl::pollInterval nodes).
+     */
+    void cancel();
+
+    /**
+     * @brief Get a snapshot of the job's progress
+     */
+    JobProgress getProgress();
+
+    /**
+     * @brief Get the candidates found so far, in the order they were found
+     */
+    std::vector<std::string> getCandidates();
+
+    /**
+     * @brief Get the message of the exception that failed the job (empty otherwise)
+     */
+    std::string getError();
+
+    /**
+     * @brief Get the encrypted value Z of the job
+     */
+    const mpz_class& getEncryptedValue() const { return encryptedValue; }
+
+    /**
+     * @brief Get the options the job was submitted with
+     */
+    const JobOptions& getOptions() const { return options; }
+
+    /**
+     * @brief Human-readable status name
+     */
+    static std::string getStatusName(JobStatus status);
+
+private:
+    friend class DecryptService;
+
+    DecryptJob(const mpz_class& encryptedValue, std::shared_ptr<DecryptionStrategy> strategy,
+               const JobOptions& options, unsigned int minLength, unsigned int maxLength,
+               size_t symbolCount);
+
+    /**
+     * @brief Time a queued job out if its deadline has passed (mutex held)
+     */
+    void expireIfQueued();
+
+    /**
+     * @brief Move from Queued to Running
+     * @return False if the job was cancelled or timed out while queued
+     */
+    bool start();
+
+    /**
+     * @brief Record the outcome of the search and wake every waiter
+     * @param finalStatus Status the job ends in
+     * @param complete Whether every length was searched to the end
+     * @param message Error message of a failed job
+     */
+    void finish(JobStatus finalStatus, bool complete, const std::string& message);
+
+    /**
+     * @brief Share of the search space covered according to the search control
+     */
+    double coveredFraction() const;
+
+    const mpz_class encryptedValue;
+    const std::shared_ptr<DecryptionStrategy> strategy;
+    const JobOptions options;
+    const unsigned int minLength;              // Length range, for the progress estimate
+    const unsigned int maxLength;
+    const double symbolCount;                  // Weighs lengths by their number of passwords
+    const std::chrono::steady_clock::time_point deadline; // time_point::max() without a timeout
+    SearchControl control;                     // Polled by the strategy while the job runs
+
+    std::mutex mutex;                          // Guards everything below
+    std::condition_variable doneCondition;
+    JobStatus status = JobStatus::Queued;
+    bool started = false;                      // Whether a worker picked the job up
+    bool searchedAll = false;                  // Whether the search ran to its end
+    std::vector<std::string> candidates;
+    std::string error;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point endTime;
+};
+
+/**
+ * @class DecryptService
+ * @brief Runs decrypt jobs asynchronously on its own worker threads
+ *
+ * Jobs are served interactive first, then in submission order. Part of the
+ * workers is reserved for interactive jobs, so a lookup someone is waiting for
+ * never queues behind long batch searches. Each job bounds its search with its
+ * own SearchControl: cancellation and deadlines take effect within one poll
+ * interval, and progress is readable while the search runs.
+ *
+ * Jobs decrypt through PartitionEncryption::decrypt(), so the system's result
+ * cache answers repeated queries and stores the results of completed jobs.
+ * Strategies are not thread-safe: a strategy shared by several jobs runs one of
+ * them at a time, and must not be used outside the service meanwhile. The
+ * system must not be modified while jobs are queued or running.
+ */
+class DecryptService {
+public:
+    /**
+     * @brief Start the worker threads
+     * @param system Encryption system whose table, C and cache the jobs use
+     * @param threads Number of workers (0 = hardware concurrency)
+     * @param interactiveWorkers Workers that only run interactive jobs; at most
+     *        threads - 1, so batch jobs always have a worker
+     */
+    DecryptService(PartitionEncryption& system, unsigned int threads = 0, unsigned int interactiveWorkers = 1);
+
+    /**
+     * @brief Cancel every queued and running job and join the workers
+     */
+    ~DecryptService();
+
+    DecryptService(const DecryptService&) = delete;
+    DecryptService& operator=(const DecryptService&) = delete;
+
+    /**
+     * @brief Queue a decryption
+     * @param encryptedValue The Z value to decrypt
+     * @param strategy The decryption strategy to use
+     * @param options Priority, deadline and candidate limit
+     * @return Handle to wait on, watch and cancel the job
+     * @throws std::invalid_argument if the strategy is null
+     */
+    std::shared_ptr<DecryptJob> submit(const mpz_class& encryptedValue,
+                                       std::shared_ptr<DecryptionStrategy> strategy,
+                                       const JobOptions& options = JobOptions());
+
+    /**
+     * @brief Number of jobs waiting for a worker
+     */
+    size_t getQueuedCount();
+
+    /**
+     * @brief Number of worker threads
+     */
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+private:
+    void workerLoop(bool interactiveOnly);
+
+    /**
+     * @brief Pop the first job the worker may run whose strategy is idle (mutex held)
+     */
+    std::shared_ptr<DecryptJob> takeJob(bool interactiveOnly);
+
+    void run(DecryptJob& job);
+
+    PartitionEncryption& system;
+    std::vector<std::thread> workers;
+    std::mutex mutex;                                   // Guards the queues, busy and stopping
+    std::condition_variable wakeCondition;
+    std::deque<std::shared_ptr<DecryptJob>> interactiveQueue;
+    std::deque<std::shared_ptr<DecryptJob>> batchQueue;
+    std::vector<std::shared_ptr<DecryptJob>> running;
+    std::set<const DecryptionStrategy*> busy;           // Strategies of running jobs
+    bool stopping = false;
+};
+
+#endif // DECRYPT_SERVICE_H
@@ -0,0 +1,141 @@
+#ifndef EXTERNAL_RUNS_H
+#define EXTERNAL_RUNS_H
+
+#include "partial_sums.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @class SortedRun
+ * @brief A spill file of PartialSum records in sum order, removed on destruction
+ *
+ * Records are stored raw (16 bytes each). Runs are only created by RunWriter.
+ */
+class SortedRun {
+public:
+    ~SortedRun();
+    SortedRun(const SortedRun&) = delete;
+    SortedRun& operator=(const SortedRun&) = delete;
+
+    const std::string& getPath() const { return path; }
+    uint64_t size() const { return records; }
+
+private:
+    friend class RunWriter;
+    SortedRun(const std::string& path, uint64_t records) : path(path), records(records) {}
+
+    std::string path;
+    uint64_t records;
+};
+
+/**
+ * @class RunWriter
+ * @brief Writes one run file through a fixed-size buffer
+ */
+class RunWriter {
+public:
+    /**
+     * @brief Create a new, uniquely named file in a directory
+     * @param directory Spill directory
+     * @param bufferRecords Records buffered before each write
+     * @throws std::runtime_error if the file cannot be created
+     */
+    RunWriter(const std::string& directory, size_t bufferRecords);
+    ~RunWriter();
+    RunWriter(const RunWriter&) = delete;
+    RunWriter& operator=(const RunWriter&) = delete;
+
+    void push(const PartialSum& record) {
+        buffer.push_back(record);
+        if (buffer.size() == buffer.capacity()) {
+            flush();
+        }
+    }
+
+    /**
+     * @brief Write a block of records directly, bypassing the buffer
+     */
+    void append(const PartialSum* data, size_t count);
+
+    /**
+     * @brief Close the file and hand it over as a run
+     * @throws std::runtime_error on a write error (e.g. a full disk)
+     */
+    std::unique_ptr<SortedRun> finish();
+
+    size_t memoryBytes() const { return buffer.capacity() * sizeof(PartialSum); }
+
+private:
+    void flush();
+
+    std::string path;
+    std::FILE* file = nullptr;
+    std::vector<PartialSum> buffer;
+    uint64_t written = 0;
+};
+
+/**
+ * @class RunMerger
+ * @brief Streams the records of several runs as one sorted sequence (k-way merge)
+ *
+ * Every run is read sequentially in large blocks; a heap of the runs' current
+ * records picks the next one. All runs must be sorted in the same direction.
+ */
+class RunMerger {
+public:
+    /**
+     * @param runs Runs to merge (must outlive the merger)
+     * @param descending True if the runs, and so the output, are sorted by descending sum
+     * @param bufferRecords Records read per block and run
+     * @throws std::runtime_error if a run cannot be opened
+     */
+    RunMerger(const std::vector<const SortedRun*>& runs, bool descending, size_t bufferRecords);
+    ~RunMerger();
+    RunMerger(const RunMerger&) = delete;
+    RunMerger& operator=(const RunMerger&) = delete;
+
+    bool valid() const { return !heap.empty(); }
+    const PartialSum& current() const { return cursors[heap.front()].head(); }
+
+    /**
+     * @brief Move to the next record of the merged sequence
+     */
+    void advance();
+
+    size_t memoryBytes() const;
+
+private:
+    struct Cursor {
+        std::FILE* file = nullptr;
+        std::vector<PartialSum> buffer;
+        size_t position = 0;
+        size_t filled = 0;
+
+        const PartialSum& head() const { return buffer[position]; }
+        bool refill();
+    };
+
+    bool before(size_t a, size_t b) const;
+
+    std::vector<Cursor> cursors;
+    std::vector<size_t> heap;  // Cursor indices; the front holds the next record
+    bool descending;
+};
+
+/**
+ * @brief Merge runs into fewer, longer runs until at most maxRuns remain
+ * @param runs Runs to reduce; replaced by the merged runs
+ * @param directory Spill directory for the new runs
+ * @param descending Sort direction of the runs
+ * @param maxRuns Largest run count the caller can merge at once (at least 2)
+ * @param bufferRecords Records per read or write buffer
+ * @return Bytes written by the extra passes
+ */
+uint64_t reduceRuns(std::vector<std::unique_ptr<SortedRun>>& runs, const std::string& directory,
+                    bool descending, size_t maxRuns, size_t bufferRecords);
+
+#endif // EXTERNAL_RUNS_H
@@ -0,0 +1,123 @@
+#ifndef HYBRID_STRATEGY_H
+#define HYBRID_STRATEGY_H
+
+#include "partition_encryption.h"
+#include "backtracking_strategy.h"
+#include "mitm_strategy.h"
+#include "schroeppel_shamir_strategy.h"
+#include <string>
+#include <vector>
+#include <gmpxx.h>
+
+/**
+ * @class HybridStrategy
+ * @brief Picks the cheapest decryption engine for every password length
+ *
+ * Before searching, a dynamic-programming count of how many r-character sums
+ * hit each value (dp[r][s] += dp[r-1][s - v], the same recurrence as InvPart.c,
+ * evaluated on a binned sum axis) estimates for each length:
+ * - the number of solutions,
+ * - the nodes backtracking would expand,
+ * - the record counts and memory of the MITM half tables,
+ * - the pair-sum stream length of the Schroeppel-Shamir variant.
+ * Each length is then solved by the engine with the lowest estimated cost:
+ * plain backtracking, backtracking that closes its last two positions with a
+ * pair-sum hash lookup, two-list MITM, or four-list MITM.
+ */
+class HybridStrategy : public DecryptionStrategy {
+public:
+    /**
+     * @enum Engine
+     * @brief Engines the hybrid strategy can dispatch a length to
+     */
+    enum class Engine {
+        Backtracking,
+        PairLookupTail,
+        MeetInTheMiddle,
+        SchroeppelShamir
+    };
+
+    /**
+     * @struct LengthPlan
+     * @brief Cost estimates and chosen engine for one password length
+     *
+     * Costs are in abstract units of roughly one search node each.
+     */
+    struct LengthPlan {
+        unsigned int length;
+        Engine engine;
+        double estimatedSolutions;
+        double backtrackingCost;
+        double pairLookupCost;
+        double mitmCost;
+        double schroeppelShamirCost;
+        double mitmBytes;
+    };
+
+    /**
+     * @brief Constructor
+     * @param maxMemoryGB Memory budget handed to the MITM engine
+     */
+    HybridStrategy(double maxMemoryGB = 4.0);
+
+    /**
+     * @brief Decrypt each length with the engine the cost model prefers
+     * @param targetSum The K value (Z - C) to find partitioning for
+     * @param table Prepared lookup table
+     * @param minLength Minimum allowed password length
+     * @param maxLength Maximum allowed password length
+     * @param visit Called with every candidate; returns false to stop the search
+     * @return True if the search ran to completion, false if the visitor stopped it
+     */
+    bool decrypt(
+        const mpz_class& targetSum,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const SolutionVisitor& visit) override;
+
+    using DecryptionStrategy::decrypt;
+
+    /**
+     * @brief Get the strategy name
+     * @return Strategy name
+     */
+    std::string getName() const override { return "Hybrid"; }
+
+    /**
+     * @brief Hand the search control to every engine as well
+     */
+    void setSearchControl(SearchControl* searchControl) override;
+
+    /**
+     * @brief Estimate costs and choose an engine for every feasible length
+     * @param targetSum The K value (Z - C) to find partitioning for
+     * @param table Prepared lookup table
+     * @param minLength Minimum allowed password length
+     * @param maxLength Maximum allowed password length
+     * @return One plan per length that can reach the target
+     */
+    std::vector<LengthPlan> plan(
+        const mpz_class& targetSum,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength) const;
+
+    /**
+     * @brief Get the plan used by the last decryption
+     */
+    const std::vector<LengthPlan>& getLastPlan() const { return lastPlan; }
+
+    /**
+     * @brief Human-readable engine name
+     */
+    static std::string getEngineName(Engine engine);
+
+private:
+    BacktrackingStrategy backtracking;     // Also runs the pair-lookup variant; caches are shared
+    MeetInTheMiddleStrategy mitm;
+    SchroeppelShamirStrategy schroeppelShamir;
+    std::vector<LengthPlan> lastPlan;
+};
+
+#endif // HYBRID_STRATEGY_H
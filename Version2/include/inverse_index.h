@@ -0,0 +1,131 @@
+#ifndef INVERSE_INDEX_H
+#define INVERSE_INDEX_H
+
+#include "lookup_table.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @class InverseIndex
+ * @brief Read-only, memory-mapped file mapping every sum of short passwords to the passwords
+ *
+ * The file holds one section per length 1..maxLength. A section lists its distinct
+ * sums in ascending order, delta- and varint-coded in blocks of 64, behind a
+ * directory of each block's first sum; the symbol tuples of every sum follow as
+ * fixed-width base-c packed integers, in table order. A lookup binary-searches the
+ * directory, decodes one block and reads the tuples in place.
+ *
+ * The file is mapped, not read, so opening it is immediate and every process using
+ * the same file shares one copy in the page cache. The header carries the table
+ * fingerprint (LookupTable::getFingerprint), and opening an index against another
+ * table is refused.
+ */
+class InverseIndex {
+public:
+    /**
+     * @brief Receives the packed symbol tuples of a sum
+     *
+     * Symbol k of a tuple is (packed / c^k) % c. Returning false stops the lookup.
+     */
+    using TupleVisitor = std::function<bool(uint64_t packed)>;
+
+    /**
+     * @brief Enumerate, sort and write the index of a table
+     *
+     * Builds one length at a time in memory: length L needs 32 * c^L bytes
+     * (about 470 MB for L = 4 and the default table). The file is written
+     * beside its destination and renamed into place.
+     * @param table Prepared lookup table
+     * @param maxLength Longest password length to index
+     * @param path Destination file
+     * @throws std::invalid_argument if the sums or packed tuples need more than 64 bits
+     * @throws std::runtime_error if the file cannot be written
+     */
+    static void build(const LookupTable& table, unsigned int maxLength, const std::string& path);
+
+    /**
+     * @brief Map an index file and check it belongs to a table
+     * @param path Index file written by build()
+     * @param table Prepared lookup table queries will use
+     * @throws std::runtime_error if the file is missing, truncated or of another version
+     * @throws std::invalid_argument if the file was built for another table
+     */
+    InverseIndex(const std::string& path, const LookupTable& table);
+    ~InverseIndex();
+    InverseIndex(const InverseIndex&) = delete;
+    InverseIndex& operator=(const InverseIndex&) = delete;
+
+    /**
+     * @brief Hand every tuple of the given length and sum to a visitor
+     * @param length Password length (1..getMaxLength())
+     * @param sum Target sum
+     * @param visit Called with each packed tuple, in table order
+     * @return False if the visitor stopped the lookup
+     */
+    bool lookup(unsigned int length, uint64_t sum, const TupleVisitor& visit) const;
+
+    /**
+     * @brief Number of tuples of the given length and sum
+     */
+    uint64_t count(unsigned int length, uint64_t sum) const;
+
+    unsigned int getMaxLength() const { return maxLength; }
+    uint64_t getTableFingerprint() const { return tableFingerprint; }
+    const std::string& getPath() const { return path; }
+    size_t getFileBytes() const { return size; }
+
+private:
+    /**
+     * @struct Section
+     * @brief Location and shape of one length's data in the file (stored in the header)
+     */
+    struct Section {
+        uint64_t sumCount;       // Distinct sums
+        uint64_t tupleCount;
+        uint64_t blockCount;
+        uint64_t blocksOffset;   // Block directory: blockCount Block records
+        uint64_t sumsOffset;     // Varint-coded (sum delta, tuple count) pairs
+        uint64_t tuplesOffset;   // tupleCount tuples of tupleBytes bytes
+        uint64_t tupleBytes;
+    };
+
+    /**
+     * @struct Block
+     * @brief Directory entry of 64 consecutive sums
+     */
+    struct Block {
+        uint64_t firstSum;
+        uint64_t firstTuple;     // Index of the first sum's first tuple
+        uint64_t sumsOffset;     // Byte offset of the block in the sums stream
+    };
+
+    /**
+     * @brief Check the header and section records of the mapped file
+     * @throws std::runtime_error or std::invalid_argument as the constructor
+     */
+    void validate(const LookupTable& table);
+
+    /**
+     * @brief Unmap the file
+     */
+    void release();
+
+    /**
+     * @brief Find the tuples of a sum
+     * @return False if no tuple has this sum
+     */
+    bool find(unsigned int length, uint64_t sum, uint64_t& firstTuple, uint64_t& tupleCount) const;
+
+    std::string path;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    std::vector<unsigned char> copy;   // Holds the file where it cannot be mapped
+    unsigned int maxLength = 0;
+    uint64_t tableFingerprint = 0;
+    std::vector<Section> sections;     // Indexed by length - 1
+};
+
+#endif // INVERSE_INDEX_H
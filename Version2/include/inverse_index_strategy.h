@@ -0,0 +1,70 @@
+#ifndef INVERSE_INDEX_STRATEGY_H
+#define INVERSE_INDEX_STRATEGY_H
+
+#include "partition_encryption.h"
+#include "backtracking_strategy.h"
+#include "inverse_index.h"
+#include <memory>
+#include <string>
+
+/**
+ * @class InverseIndexStrategy
+ * @brief Answers short lengths from a prebuilt InverseIndex file, longer ones by search
+ *
+ * Lengths covered by the index cost one binary search and the output; lengths
+ * beyond it are handed to the backtracking strategy. Candidates come in the same
+ * order as a sequential backtracking search: by length, then in table order.
+ */
+class InverseIndexStrategy : public DecryptionStrategy {
+public:
+    /**
+     * @brief Constructor
+     * @param indexPath Index file written by InverseIndex::build() (tools/build_index)
+     *
+     * The file is mapped on the first decryption and checked against its table.
+     */
+    explicit InverseIndexStrategy(const std::string& indexPath);
+
+    /**
+     * @brief Decrypt from the index, falling back to backtracking for longer lengths
+     * @param targetSum The K value (Z - C) to find partitioning for
+     * @param table Prepared lookup table
+     * @param minLength Minimum allowed password length
+     * @param maxLength Maximum allowed password length
+     * @param visit Called with every candidate; returns false to stop the search
+     * @return True if the search ran to completion, false if the visitor stopped it
+     * @throws std::runtime_error if the index file cannot be mapped
+     * @throws std::invalid_argument if the index was built for another table
+     */
+    bool decrypt(
+        const mpz_class& targetSum,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const SolutionVisitor& visit) override;
+
+    using DecryptionStrategy::decrypt;
+
+    /**
+     * @brief Get the strategy name
+     * @return Strategy name
+     */
+    std::string getName() const override { return "Inverse Index"; }
+
+    /**
+     * @brief Hand the search control to the backtracking fallback as well
+     */
+    void setSearchControl(SearchControl* searchControl) override;
+
+private:
+    /**
+     * @brief Map the index if needed; remap it when the table changed
+     */
+    const InverseIndex& openIndex(const LookupTable& table);
+
+    std::string indexPath;
+    std::unique_ptr<InverseIndex> index;
+    BacktrackingStrategy backtracking;     // Longer lengths; keeps its caches between calls
+};
+
+#endif // INVERSE_INDEX_STRATEGY_H
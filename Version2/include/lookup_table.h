@@ -0,0 +1,262 @@
+#ifndef LOOKUP_TABLE_H
+#define LOOKUP_TABLE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <gmpxx.h>
+
+#if defined(__SIZEOF_INT128__)
+#define PARTITION_HAVE_INT128 1
+typedef unsigned __int128 uint128_t;
+#endif
+
+/**
+ * @enum ValueWidth
+ * @brief Narrowest integer type that can hold every sum a search may produce
+ */
+enum class ValueWidth {
+    Native64,   // maxValue * maxLength fits in uint64_t
+    Native128,  // maxValue * maxLength fits in unsigned __int128
+    Arbitrary   // Only GMP can represent the sums
+};
+
+/**
+ * @brief Convert a non-negative GMP integer to a native unsigned integer
+ * @param value Value to convert (caller guarantees it fits in Int)
+ * @return The value as Int
+ */
+template <typename Int>
+Int toNative(const mpz_class& value) {
+    unsigned char bytes[sizeof(Int)] = {0};
+    size_t count = 0;
+    mpz_export(bytes, &count, -1, 1, 0, 0, value.get_mpz_t());
+
+    Int result = 0;
+    for (size_t i = count; i > 0; --i) {
+        result = (result << 8) | bytes[i - 1];
+    }
+    return result;
+}
+
+/**
+ * @brief Convert a native unsigned integer back to a GMP integer
+ * @param value Value to convert
+ * @return The value as mpz_class
+ */
+template <typename Int>
+mpz_class fromNative(Int value) {
+    unsigned char bytes[sizeof(Int)];
+    for (size_t i = 0; i < sizeof(Int); ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+
+    mpz_class result;
+    mpz_import(result.get_mpz_t(), sizeof(Int), -1, 1, 0, 0, bytes);
+    return result;
+}
+
+/**
+ * @brief Dense id of a symbol: its position in the table's sort order
+ *
+ * Search kernels work on arrays of ids and only spell them out as text when a
+ * candidate is reported (LookupTable::spell()).
+ */
+typedef uint16_t SymbolId;
+
+const size_t maxSymbolCount = 0xffff; // Ids 0..0xfffe; 0xffff marks "no symbol"
+
+/**
+ * @class LookupTable
+ * @brief Symbol-to-partition mapping plus the derived data every strategy needs
+ *
+ * Symbols are Unicode code points, stored as their UTF-8 encoding. Built once
+ * when the lookup table is loaded so that strategies do not have to re-sort
+ * symbols or re-derive bounds on every decrypt call:
+ * - Symbols sorted by descending partition value (the order used for pruning);
+ *   a symbol's position in this order is its SymbolId
+ * - Minimum and maximum partition values
+ * - The narrowest integer width able to hold maxValue * maxLength, together with
+ *   the sorted values in that native width so hot loops can avoid GMP entirely
+ * - Hash-free conversion between text and ids: a direct table for ASCII and a
+ *   sorted code point array for everything else
+ * - A fingerprint of the sorted symbols and values, which files derived from
+ *   the table (checkpoints, caches, indexes) record to detect a different table
+ *
+ * All of it can be saved as a compiled binary table and loaded back without
+ * parsing or sorting (save() / load()).
+ */
+class LookupTable {
+public:
+    LookupTable() = default;
+
+    /**
+     * @brief Build the derived data for a symbol mapping
+     * @param symbolToPartition Map of symbols (one UTF-8 code point each) to their partition values
+     * @param maxLength Longest password length searches will use
+     * @throws std::invalid_argument if a key is not exactly one code point or
+     *         there are more than maxSymbolCount symbols
+     */
+    LookupTable(const std::unordered_map<std::string, mpz_class>& symbolToPartition,
+                unsigned int maxLength);
+
+    /**
+     * @brief Write the table and its derived data as a compiled binary table
+     *
+     * The file holds the symbols in sort order (dense symbol ids are their
+     * positions), each value as raw bytes, the native-width values, the width,
+     * the maximum length, the fingerprint and a checksum of all of it.
+     * @param path Destination file (written beside it and renamed into place)
+     * @throws std::runtime_error if the file cannot be written
+     */
+    void save(const std::string& path) const;
+
+    /**
+     * @brief Load a table written by save()
+     *
+     * Values are imported from their bytes and the precomputed order, width and
+     * fingerprint are taken as stored, so nothing is parsed or sorted.
+     * @param path Compiled table file
+     * @return The table
+     * @throws std::runtime_error if the file is missing, corrupt or of another version
+     */
+    static LookupTable load(const std::string& path);
+
+    /**
+     * @brief Whether a file starts like a compiled table (as opposed to CSV)
+     * @param path File to check
+     */
+    static bool isCompiled(const std::string& path);
+
+    /**
+     * @brief Get the underlying symbol mapping
+     * @return Map of symbols (UTF-8) to their partition values
+     */
+    const std::unordered_map<std::string, mpz_class>& getSymbolToPartition() const { return symbolToPartition; }
+
+    size_t size() const { return sortedSymbols.size(); }
+    bool empty() const { return sortedSymbols.empty(); }
+
+    /**
+     * @brief Symbols (UTF-8) sorted by descending partition value; index = SymbolId
+     */
+    const std::vector<std::string>& getSymbols() const { return sortedSymbols; }
+
+    /**
+     * @brief Partition values in the same order as getSymbols()
+     */
+    const std::vector<mpz_class>& getSortedValues() const { return sortedValues; }
+
+    /**
+     * @brief Whether every symbol is a single byte (ASCII), so text length equals symbol count
+     */
+    bool isSingleByte() const { return singleByte; }
+
+    /**
+     * @brief Spell out a sequence of symbol ids as UTF-8 text
+     * @param symbols Ids to spell
+     * @param count Number of ids
+     * @param out Receives the text (replaced)
+     */
+    void spell(const SymbolId* symbols, size_t count, std::string& out) const {
+        if (singleByte) {
+            out.resize(count);
+            for (size_t k = 0; k < count; ++k) {
+                out[k] = symbolBytes[symbols[k]];
+            }
+            return;
+        }
+        out.clear();
+        for (size_t k = 0; k < count; ++k) {
+            uint32_t begin = symbolOffsets[symbols[k]];
+            out.append(symbolBytes, begin, symbolOffsets[symbols[k] + 1] - begin);
+        }
+    }
+
+    /**
+     * @brief Convert UTF-8 text to symbol ids
+     * @param text Text to convert
+     * @param symbols Receives one id per code point (cleared first)
+     * @return False if the text is not well-formed UTF-8 or has a code point missing from the table
+     */
+    bool parse(const std::string& text, std::vector<SymbolId>& symbols) const;
+
+    /**
+     * @brief Id of a single symbol
+     * @param symbol One UTF-8 code point
+     * @return The id, or maxSymbolCount if the symbol is not in the table
+     */
+    size_t findSymbol(const std::string& symbol) const;
+
+    const mpz_class& getMinValue() const { return minValue; }
+    const mpz_class& getMaxValue() const { return maxValue; }
+    unsigned int getMaxLength() const { return maxLength; }
+
+    /**
+     * @brief 64-bit FNV-1a hash of the symbols and values in sort order
+     */
+    uint64_t getFingerprint() const { return fingerprint; }
+
+    /**
+     * @brief Width detected for the table's own maximum length
+     */
+    ValueWidth getValueWidth() const { return valueWidth; }
+
+    /**
+     * @brief Width needed for sums of up to the given length
+     * @param length Longest password length of the search
+     * @return Cached width when length is within the prepared maximum
+     */
+    ValueWidth widthFor(unsigned int length) const;
+
+    /**
+     * @brief Sorted values as native integers
+     *
+     * Only valid when widthFor(length) selects Int (or a narrower type);
+     * otherwise the returned vector is empty.
+     */
+    template <typename Int>
+    const std::vector<Int>& getNativeValues() const;
+
+private:
+    ValueWidth selectWidth(unsigned int length) const;
+
+    /**
+     * @brief Build the spelling buffer and the text-to-id tables from sortedSymbols
+     */
+    void indexSymbols();
+
+    std::unordered_map<std::string, mpz_class> symbolToPartition;
+    std::vector<std::string> sortedSymbols; // Descending by partition value
+    std::vector<mpz_class> sortedValues;    // Parallel to sortedSymbols
+    std::vector<uint64_t> nativeValues64;   // Filled when sums fit in 64 bits
+#ifdef PARTITION_HAVE_INT128
+    std::vector<uint128_t> nativeValues128; // Filled when sums fit in 128 bits
+#endif
+    std::string symbolBytes;                // Sorted symbols back to back
+    std::vector<uint32_t> symbolOffsets;    // Symbol i is symbolBytes[offsets[i], offsets[i + 1])
+    std::vector<SymbolId> asciiSymbols;     // Id per ASCII byte, 0xffff if absent
+    std::vector<std::pair<uint32_t, SymbolId>> wideSymbols; // Non-ASCII code points, ascending
+    bool singleByte = true;
+    mpz_class minValue = 0;
+    mpz_class maxValue = 0;
+    unsigned int maxLength = 0;
+    ValueWidth valueWidth = ValueWidth::Arbitrary;
+    uint64_t fingerprint = 14695981039346656037ull; // FNV-1a offset basis: hash of no symbols
+};
+
+template <>
+inline const std::vector<uint64_t>& LookupTable::getNativeValues<uint64_t>() const {
+    return nativeValues64;
+}
+
+#ifdef PARTITION_HAVE_INT128
+template <>
+inline const std::vector<uint128_t>& LookupTable::getNativeValues<uint128_t>() const {
+    return nativeValues128;
+}
+#endif
+
+#endif // LOOKUP_TABLE_H
@@ -2,7 +2,9 @@
 #define MITM_STRATEGY_H
 
 #include "partition_encryption.h"
-#include <unordered_map>
+#include "partial_sums.h"
+#include "search_constraints.h"
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <gmpxx.h>
@@ -10,11 +12,25 @@
 /**
  * @class MeetInTheMiddleStrategy
  * @brief Implementation of the Meet-in-the-Middle decryption strategy
- * 
+ *
  * This strategy reduces complexity from O(c^n) to O(c^(n/2)) by splitting the problem in half:
     - Generate all possible sums for the first half of positions
     - Generate all possible sums for the second half of positions
     - Find matching pairs that sum to the target value
+ *
+ * Each half is a flat array of 16-byte (sum, packed symbol index) records that is
+ * radix-sorted and matched with a two-pointer merge. When both halves would not
+ * fit in maxMemoryGB, the first half's sum window is split into ranges of about
+ * equal record counts, and each range is solved with the second-half sums that
+ * complete it. The generators prune every subtree outside a range, so a record
+ * is generated once whatever the number of buckets. With a spill directory set,
+ * such lengths run out of core instead: each half is generated once, in partitions
+ * by leading symbols, and written as sorted run files that a streaming k-way merge
+ * matches.
+ *
+ * With constraints set, each half only enumerates the symbols its positions
+ * allow and its sum window is derived from those symbols' values; required sets
+ * are checked when a pair matches.
  */
 class MeetInTheMiddleStrategy : public DecryptionStrategy {
 public:
@@ -26,17 +42,44 @@ public:
 
     /**
      * @brief Decrypt using Meet-in-the-Middle approach
+     *
+     * Tables whose sums do not fit in 64 bits are handed to the backtracking
+     * strategy, which has 128-bit and GMP kernels.
      * @param targetSum The K value (Z - C) to find partitioning for
-     * @param charToPartition Map of characters to their partition values
+     * @param table Prepared lookup table
      * @param minLength Minimum allowed password length
      * @param maxLength Maximum allowed password length
-     * @return Possible decryption results (may be multiple or none)
+     * @param visit Called with every candidate; returns false to stop the search
+     * @return True if the search ran to completion, false if the visitor stopped it
      */
-    std::vector<std::string> decrypt(
+    bool decrypt(
         const mpz_class& targetSum,
-        const std::unordered_map<char, mpz_class>& charToPartition,
+        const LookupTable& table,
         unsigned int minLength,
-        unsigned int maxLength) override;
+        unsigned int maxLength,
+        const SolutionVisitor& visit) override;
+
+    using DecryptionStrategy::decrypt;
+
+    /**
+     * @brief Decrypt many targets from one pair of half tables per length
+     *
+     * The half tables are generated for the union of the targets' sum windows,
+     * sorted once, and merged against each distinct target. When they would
+     * exceed maxMemoryGB the length is solved target by target with bucketing.
+     * @param targetSums The K values (Z - C) to find partitionings for
+     * @param table Prepared lookup table
+     * @param minLength Minimum allowed password length
+     * @param maxLength Maximum allowed password length
+     * @param visit Called with the target's index and each candidate; returns false to stop
+     * @return True if the search ran to completion, false if the visitor stopped it
+     */
+    bool decryptBatch(
+        const std::vector<mpz_class>& targetSums,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const BatchSolutionVisitor& visit) override;
 
     /**
      * @brief Get the strategy name
@@ -44,49 +87,166 @@ public:
      */
     std::string getName() const override { return "Meet-in-the-Middle"; }
 
-private:
     /**
-     * @brief Generate all possible partition sums for a subset of positions
-     * @param charToPartition Map of characters to their partition values
-     * @param length Length of password to consider
-     * @param isFirstHalf Whether this is the first or second half
-     * @return Map of sums to corresponding partial passwords
+     * @brief Cache tag: the name, plus the constraints if any
      */
-    std::unordered_map<mpz_class, std::vector<std::string>> generatePartialSums(
-        const std::unordered_map<char, mpz_class>& charToPartition,
-        unsigned int length,
-        bool isFirstHalf);
+    std::string getCacheTag() const override;
+
+    /**
+     * @brief Set the memory budget
+     * @param gb Maximum memory usage in GB
+     */
+    void setMaxMemoryGB(double gb) { maxMemoryGB = gb; }
+
+    /**
+     * @brief Spill half tables that exceed the memory budget to disk
+     *
+     * Lengths whose halves do not fit in maxMemoryGB are then solved out of core
+     * instead of by sum-range bucketing: every half record is generated once, and
+     * sorted runs in this directory are matched with sequential reads. Generation
+     * buffers and read buffers together stay within maxMemoryGB. Run files are
+     * removed as soon as they have been merged.
+     * @param directory Directory for run files (empty = bucket in memory)
+     */
+    void setSpillDirectory(const std::string& directory) { spillDirectory = directory; }
 
     /**
-     * @brief Recursive helper for generating partial sums
-     * @param charToPartition Map of characters to their partition values
-     * @param currentSum Current partial sum
-     * @param currentPassword Current partial password
-     * @param depth Current recursion depth
-     * @param maxDepth Maximum recursion depth
-     * @param results Map to store results
+     * @brief Search only passwords that satisfy known constraints
+     *
+     * Constrained lengths that exceed maxMemoryGB are bucketed in memory even with
+     * a spill directory, and batches run target by target.
+     * @param searchConstraints Constraints to honour (empty = none)
      */
-    void generatePartialSumsRecursive(
-        const std::unordered_map<char, mpz_class>& charToPartition,
-        const mpz_class& currentSum,
-        const std::string& currentPassword,
-        unsigned int depth,
-        unsigned int maxDepth,
-        std::unordered_map<mpz_class, std::vector<std::string>>& results);
+    void setConstraints(const SearchConstraints& searchConstraints) { constraints = searchConstraints; }
+
+private:
+    /**
+     * @struct HalfSplit
+     * @brief Positions and sum window of one half of a MITM split
+     */
+    struct HalfSplit {
+        unsigned int positions;
+        uint64_t low;
+        uint64_t high;
+    };
 
     /**
      * @brief Find matching pairs between first and second half
-     * @param firstHalfSums Sums from first half
-     * @param secondHalfSums Sums from second half
+     * @param firstHalf Sorted records of the first half
+     * @param secondHalf Sorted records of the second half
      * @param targetSum Total target sum
-     * @return Vector of complete passwords
+     * @param table Lookup table used to turn symbol indices into characters
+     * @param firstPositions Number of positions in the first half
+     * @param secondPositions Number of positions in the second half
+     * @param visit Receives complete passwords
+     * @param required Required sets every match must contain (nullptr = none)
+     * @return False if the visitor stopped the search
+     */
+    bool findMatches(
+        const std::vector<PartialSum>& firstHalf,
+        const std::vector<PartialSum>& secondHalf,
+        uint64_t targetSum,
+        const LookupTable& table,
+        unsigned int firstPositions,
+        unsigned int secondPositions,
+        const SolutionVisitor& visit,
+        const PositionConstraints* required = nullptr);
+
+    /**
+     * @brief Solve one password length with (possibly bucketed) MITM
+     * @param targetSum Target sum
+     * @param table Prepared lookup table
+     * @param length Password length
+     * @param visit Receives complete passwords
+     * @param positions Constraints resolved for this length (nullptr = unconstrained)
+     * @return False if the visitor stopped the search
+     */
+    bool decryptLength(
+        uint64_t targetSum,
+        const LookupTable& table,
+        unsigned int length,
+        const SolutionVisitor& visit,
+        const PositionConstraints* positions = nullptr);
+
+    /**
+     * @brief Solve one password length with disk-spilled sorted runs
+     * @param targetSum Target sum
+     * @param table Prepared lookup table
+     * @param first Split of the first half
+     * @param second Split of the second half
+     * @param visit Receives complete passwords
+     * @return False if the visitor stopped the search
+     * @throws std::runtime_error if the budget cannot hold a single partition or a run file fails
+     */
+    bool decryptLengthExternal(
+        uint64_t targetSum,
+        const LookupTable& table,
+        const HalfSplit& first,
+        const HalfSplit& second,
+        const SolutionVisitor& visit);
+
+    /**
+     * @brief Solve one password length for a sorted set of targets
+     * @param requests (target, batch index) pairs sorted by target
+     * @param table Prepared lookup table
+     * @param length Password length
+     * @param visit Receives the batch index and each complete password
+     * @return False if the visitor stopped the search
+     */
+    bool decryptBatchLength(
+        const std::vector<std::pair<uint64_t, size_t>>& requests,
+        const LookupTable& table,
+        unsigned int length,
+        const BatchSolutionVisitor& visit);
+
+    /**
+     * @brief Estimate the bucket count keeping one length within maxMemoryGB
+     * @param symbolCount Number of characters in the table
+     * @param firstPositions Number of positions in the first half
+     * @param secondPositions Number of positions in the second half
+     * @return Number of sum-range buckets (1 = no bucketing)
+     */
+    uint64_t bucketCount(size_t symbolCount, unsigned int firstPositions,
+                         unsigned int secondPositions) const;
+
+    /**
+     * @brief Estimate the bucket count for halves of known record counts
+     * @param firstCount Records of the first half before windowing
+     * @param secondCount Records of the second half before windowing
+     * @return Number of sum-range buckets (1 = no bucketing)
+     */
+    uint64_t bucketCount(double firstCount, double secondCount) const;
+
+    /**
+     * @brief Split the first half's sum window into ranges of about equal memory
+     *
+     * Cut points come from binned count DPs of both halves, weighted like
+     * bucketCount(): a range's first-half records plus twice the second-half
+     * records that complete them.
+     * @param values Partition values in the table's sort order
+     * @param firstAllowed Allowed ids per first-half position (empty = unconstrained)
+     * @param secondAllowed Allowed ids per second-half position (empty = unconstrained)
+     * @param firstPositions Number of positions in the first half
+     * @param secondPositions Number of positions in the second half
+     * @param targetSum Target sum of the length
+     * @param firstLow Smallest first-half sum worth keeping
+     * @param firstHigh Largest first-half sum worth keeping
+     * @param buckets Number of ranges
+     * @param firstPeak Receives the estimated first-half records of the largest bucket
+     *                  (left unchanged with a single bucket)
+     * @param secondPeak Same for the second half
+     * @return buckets + 1 ascending bounds; bucket b covers [bounds[b], bounds[b + 1])
      */
-    std::vector<std::string> findMatches(
-        const std::unordered_map<mpz_class, std::vector<std::string>>& firstHalfSums,
-        const std::unordered_map<mpz_class, std::vector<std::string>>& secondHalfSums,
-        const mpz_class& targetSum);
+    std::vector<uint64_t> bucketBounds(const std::vector<uint64_t>& values,
+                                       const std::vector<std::vector<SymbolId>>& firstAllowed,
+                                       const std::vector<std::vector<SymbolId>>& secondAllowed,
+                                       unsigned int firstPositions, unsigned int secondPositions,
+                                       uint64_t targetSum, uint64_t firstLow, uint64_t firstHigh,
+                                       uint64_t buckets, double& firstPeak, double& secondPeak) const;
 
     double maxMemoryGB; // Maximum memory usage limit in GB
+    std::string spillDirectory; // Run files of out-of-core lengths (empty = bucketing)
+    SearchConstraints constraints; // Empty = unconstrained
 };
 
 #endif // MITM_STRATEGY_H
@@ -0,0 +1,42 @@
+#ifndef MULTISET_H
+#define MULTISET_H
+
+#include "partition_encryption.h"
+#include <functional>
+#include <string>
+#include <gmpxx.h>
+
+/**
+ * @brief Receives one multiset of characters whose partition values add up to the target
+ *
+ * Every ordering of the multiset encrypts to the same value. permutations is the
+ * number of distinct orderings. Both arguments are only valid for the duration
+ * of the call. Returning false stops the search.
+ */
+using MultisetVisitor = std::function<bool(const std::string& multiset, const mpz_class& permutations)>;
+
+/**
+ * @brief Number of distinct orderings of a multiset
+ *
+ * The multinomial coefficient n! / (m1! * m2! * ...), where mi are the
+ * multiplicities of the characters. Characters are UTF-8 code points.
+ * @param multiset Characters in any order
+ * @return Count of distinct strings with exactly these characters
+ * @throws std::invalid_argument if the multiset is not valid UTF-8
+ */
+mpz_class permutationCount(const std::string& multiset);
+
+/**
+ * @brief Visit every distinct ordering of a multiset in lexicographic order
+ *
+ * Orderings are produced one at a time, so a visitor that stops early never
+ * pays for the rest. Multi-byte UTF-8 characters are moved as a whole and
+ * ordered by code point.
+ * @param multiset Characters in any order
+ * @param visit Called with each ordering; returns false to stop
+ * @return True if every ordering was visited, false if visit stopped the expansion
+ * @throws std::invalid_argument if the multiset is not valid UTF-8
+ */
+bool forEachPermutation(const std::string& multiset, const SolutionVisitor& visit);
+
+#endif // MULTISET_H
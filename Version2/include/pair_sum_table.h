@@ -0,0 +1,68 @@
+#ifndef PAIR_SUM_TABLE_H
+#define PAIR_SUM_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class PairSumTable
+ * @brief Hash index from a sum to every ordered pair of symbols producing it
+ *
+ * Lets a search close its last two positions with one lookup instead of two
+ * more levels of recursion. Pairs are stored grouped by sum in a flat array and
+ * the hash map only holds the [begin, end) range of each sum.
+ */
+class PairSumTable {
+public:
+    /**
+     * @struct Pair
+     * @brief Two symbol indices (into the table's sort order) in password order
+     */
+    struct Pair {
+        uint32_t first;
+        uint32_t second;
+    };
+
+    /**
+     * @brief Build the table for a set of values
+     * @param values Partition values in the lookup table's sort order
+     * @return The pair table
+     */
+    static std::shared_ptr<const PairSumTable> build(const std::vector<uint64_t>& values);
+
+    /**
+     * @brief All pairs whose values add up to sum
+     * @param sum Sum of the two values
+     * @return [begin, end) range of pairs (empty if none)
+     */
+    std::pair<const Pair*, const Pair*> find(uint64_t sum) const {
+        auto it = ranges.find(sum);
+        if (it == ranges.end()) {
+            return {nullptr, nullptr};
+        }
+        return {pairs.data() + it->second.first, pairs.data() + it->second.second};
+    }
+
+    /**
+     * @brief Check whether this table was built for the given values
+     */
+    bool covers(const std::vector<uint64_t>& otherValues) const { return otherValues == values; }
+
+    /**
+     * @brief Approximate heap memory held by the table
+     */
+    size_t getMemoryBytes() const;
+
+private:
+    PairSumTable() = default;
+
+    std::vector<uint64_t> values;                                        // Values the table was built from
+    std::vector<Pair> pairs;                                             // Grouped by sum
+    std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> ranges; // Sum -> [begin, end) in pairs
+};
+
+#endif // PAIR_SUM_TABLE_H
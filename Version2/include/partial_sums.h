@@ -0,0 +1,113 @@
+#ifndef PARTIAL_SUMS_H
+#define PARTIAL_SUMS_H
+
+#include "lookup_table.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @struct PartialSum
+ * @brief One partial password: its sum and its symbols packed in base c
+ *
+ * Symbol k of the partial password is (packed / c^k) % c, where symbols are
+ * indices into the lookup table's descending sort order.
+ */
+struct PartialSum {
+    uint64_t sum;
+    uint64_t packed;
+};
+
+/**
+ * @brief Check whether base-c packed indices of the given length fit in 64 bits
+ * @param symbolCount Alphabet size c
+ * @param positions Number of symbols to pack
+ * @return True if c^positions - 1 fits in uint64_t
+ */
+bool packedIndexFits(size_t symbolCount, unsigned int positions);
+
+/**
+ * @brief Enumerate every sequence of `positions` symbols whose sum lies in a window
+ *
+ * Subtrees that cannot reach the window are pruned, so a narrow window costs
+ * about as much as the records it yields.
+ * @param values Partition values in the table's (descending) sort order
+ * @param positions Number of symbols per sequence
+ * @param lowSum Smallest sum worth keeping
+ * @param highSum Largest sum worth keeping
+ * @param out Array to append the records to
+ */
+void generatePartialSums(
+    const std::vector<uint64_t>& values,
+    unsigned int positions,
+    uint64_t lowSum,
+    uint64_t highSum,
+    std::vector<PartialSum>& out);
+
+/**
+ * @brief Enumerate the sequences of allowed symbols whose sum lies in a window
+ *
+ * Records are packed like those of generatePartialSums(), in base c of the whole
+ * table, so both kinds unpack the same way.
+ * @param values Partition values in the table's (descending) sort order
+ * @param allowed allowed[k] = ids allowed at position k, ascending; one entry per position
+ * @param lowSum Smallest sum worth keeping
+ * @param highSum Largest sum worth keeping
+ * @param out Array to append the records to
+ */
+void generateConstrainedPartialSums(
+    const std::vector<uint64_t>& values,
+    const std::vector<std::vector<SymbolId>>& allowed,
+    uint64_t lowSum,
+    uint64_t highSum,
+    std::vector<PartialSum>& out);
+
+/**
+ * @brief Enumerate the sequences that start with a fixed prefix and whose sum lies in a window
+ *
+ * Lets a half table be produced in partitions (one per prefix) that each fit in memory.
+ * @param values Partition values in the table's (descending) sort order
+ * @param positions Number of symbols per sequence, prefix included
+ * @param prefix Symbol indices of the first positions
+ * @param lowSum Smallest sum worth keeping
+ * @param highSum Largest sum worth keeping
+ * @param out Array to append the records to
+ */
+void generatePartialSumsWithPrefix(
+    const std::vector<uint64_t>& values,
+    unsigned int positions,
+    const std::vector<uint32_t>& prefix,
+    uint64_t lowSum,
+    uint64_t highSum,
+    std::vector<PartialSum>& out);
+
+/**
+ * @brief LSD radix sort of records by sum (ascending)
+ * @param entries Records to sort (sums must lie in [minSum, maxSum])
+ * @param scratch Buffer reused between calls
+ * @param minSum Lower bound of the sums
+ * @param maxSum Upper bound of the sums
+ */
+void radixSortPartialSums(
+    std::vector<PartialSum>& entries,
+    std::vector<PartialSum>& scratch,
+    uint64_t minSum,
+    uint64_t maxSum);
+
+/**
+ * @brief Write the symbol ids of a packed partial password into a buffer
+ *
+ * Ids are spelled out as text with LookupTable::spell() once a candidate is complete.
+ * @param packed Base-c packed symbol indices
+ * @param positions Number of symbols packed
+ * @param symbolCount Alphabet size c
+ * @param out Destination (must hold positions ids)
+ */
+inline void unpackSymbols(uint64_t packed, unsigned int positions, uint64_t symbolCount, SymbolId* out) {
+    for (unsigned int k = 0; k < positions; ++k) {
+        out[k] = static_cast<SymbolId>(packed % symbolCount);
+        packed /= symbolCount;
+    }
+}
+
+#endif // PARTIAL_SUMS_H
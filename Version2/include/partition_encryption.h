@@ -10,11 +10,36 @@
 
 #include <string>
 #include <unordered_map>
+#include <map>
 #include <vector>
+#include <functional>
 #include <chrono>
 #include <iostream>
 #include <memory>
 #include <gmpxx.h> // For GMP library
+#include "lookup_table.h"
+#include "bulk_encoder.h"
+#include "search_control.h"
+#include "search_metrics.h"
+
+class DecryptionStrategy;
+class ResultCache;
+
+/**
+ * @brief Receives decryption candidates one at a time as they are found
+ *
+ * The string is only valid for the duration of the call. Returning false
+ * stops the search.
+ */
+using SolutionVisitor = std::function<bool(const std::string& candidate)>;
+
+/**
+ * @brief Receives the candidates of a batch decryption
+ *
+ * index is the position of the target the candidate belongs to in the batch.
+ * Returning false stops the whole batch.
+ */
+using BatchSolutionVisitor = std::function<bool(size_t index, const std::string& candidate)>;
 
 /**
  * @class PartitionEncryption
@@ -24,7 +49,7 @@ class PartitionEncryption {
   public:
   /**
     @brief Constructor for encryption system
-    @param lookuptablePath to the lookup table file
+    @param lookuptablePath to the lookup table file (CSV, or a table compiled by tools/compile_table)
   */
     PartitionEncryption(const std::string& lookuptablePath);
 
@@ -36,6 +61,24 @@ class PartitionEncryption {
 
     mpz_class encrypt(const std::string& password);
 
+    /**
+     * @brief Encrypt many passwords stored back to back in one buffer
+     *
+     * Meant for bulk jobs: characters are looked up in a dense native table,
+     * nothing is logged, and invalid passwords are reported per item instead
+     * of throwing.
+     * @param data Concatenated password bytes (UTF-8)
+     * @param offsets count + 1 offsets; password i is data[offsets[i], offsets[i + 1])
+     * @param count Number of passwords
+     * @param out Receives Z of every valid password (count entries, preallocated)
+     * @param status Receives the validation result of every password (count entries)
+     * @param threads Worker threads (1 = calling thread only, 0 = all hardware threads)
+     * @return Number of passwords encrypted successfully
+     * @throws std::runtime_error if encrypted values of this table do not fit in 64 bits
+     */
+    size_t encryptBatch(const char* data, const size_t* offsets, size_t count,
+                        uint64_t* out, EncryptStatus* status, unsigned int threads = 1);
+
     /**
      * @brief Decrypt an encrypted value using the specified strategy
      * @param encryptedValue The Z value to decrypt
@@ -45,11 +88,72 @@ class PartitionEncryption {
     std::vector<std::string> decrypt(const mpz_class& encryptedValue, 
                                     std::shared_ptr<DecryptionStrategy> strategy);
 
+    /**
+     * @brief Stream the candidates of an encrypted value to a visitor
+     *
+     * Nothing is printed and no candidate is stored, so memory stays constant
+     * regardless of how many candidates the value has.
+     * @param encryptedValue The Z value to decrypt
+     * @param strategy The decryption strategy to use
+     * @param visit Called with every candidate; returns false to stop the search
+     * @return True if the search ran to completion, false if the visitor stopped it
+     */
+    bool decrypt(const mpz_class& encryptedValue,
+                 std::shared_ptr<DecryptionStrategy> strategy,
+                 const SolutionVisitor& visit);
+
+    /**
+     * @brief Decrypt many encrypted values in one search pass
+     *
+     * The strategy shares its precomputation across all values and, where it
+     * supports it, answers every target from a single traversal or half table.
+     * @param encryptedValues The Z values to decrypt
+     * @param strategy The decryption strategy to use
+     * @return Candidates of each value, in the order of encryptedValues
+     */
+    std::vector<std::vector<std::string>> decryptBatch(
+        const std::vector<mpz_class>& encryptedValues,
+        std::shared_ptr<DecryptionStrategy> strategy);
+
+    /**
+     * @brief Stream the candidates of many encrypted values to a visitor
+     * @param encryptedValues The Z values to decrypt
+     * @param strategy The decryption strategy to use
+     * @param visit Called with the value's index and each candidate; returns false to stop
+     * @return True if the search ran to completion, false if the visitor stopped it
+     */
+    bool decryptBatch(const std::vector<mpz_class>& encryptedValues,
+                      std::shared_ptr<DecryptionStrategy> strategy,
+                      const BatchSolutionVisitor& visit);
+
+    /**
+     * @brief Answer repeated queries from a result cache
+     *
+     * decrypt() and decryptBatch() then look every K up first and replay cached
+     * candidates to the visitor without searching. Results of searches that run
+     * to completion are stored; stopped searches are not. Keys include the table
+     * fingerprint, C, K, the length range and the strategy's cache tag. The cache
+     * may be shared by several systems and threads.
+     * @param cache Cache to use (nullptr disables caching)
+     */
+    void setResultCache(std::shared_ptr<ResultCache> cache) { resultCache = std::move(cache); }
+
+    /**
+     * @brief Get the result cache, if any
+     */
+    const std::shared_ptr<ResultCache>& getResultCache() const { return resultCache; }
+
     /**
      * @brief Get the lookup table
-     * @return Reference to the lookup table
+     * @return Reference to the symbol (UTF-8 code point) to partition value mapping
      */
-    const std::unordered_map<char, mpz_class>& getLookupTable() const { return charToPartition; }
+    const std::unordered_map<std::string, mpz_class>& getLookupTable() const { return symbolToPartition; }
+
+    /**
+     * @brief Get the lookup table with its precomputed derived data
+     * @return Reference to the prepared table handed to strategies
+     */
+    const LookupTable& getPreparedTable() const { return preparedTable; }
 
     /**
      * @brief Get the constant C used in encryption
@@ -57,22 +161,55 @@ class PartitionEncryption {
      */
     mpz_class getConstantC() const { return constantC; }
 
+    /**
+     * @brief Get the shortest password length searched by decryption
+     */
+    unsigned int getMinPasswordLength() const { return minPasswordLength; }
+
+    /**
+     * @brief Get the longest password length searched by decryption
+     */
+    unsigned int getMaxPasswordLength() const { return maxPasswordLength; }
+
+    /**
+     * @brief Get the dense-table encoder behind encryptBatch()
+     */
+    const BulkEncoder& getBulkEncoder() const { return bulkEncoder; }
+
 protected:
     /**
      * @brief Load the lookup table from file
+     *
+     * Also prepares the derived table data, including whether every sum up to
+     * maxPasswordLength characters fits in a native integer width. Compiled
+     * tables (LookupTable::save()) are recognised by their header and loaded
+     * with their derived data as stored.
      * @param filePath Path to the lookup table file
      */
     void loadLookupTable(const std::string& filePath);
 
     /**
      * @brief Validate input password
-     * @param password The password to validate
+     *
+     * Lengths count code points, not bytes.
+     * @param password The password to validate (UTF-8)
+     * @return Symbol ids of the password
      * @throws std::invalid_argument if password doesn't meet requirements
      */
-    void validatePassword(const std::string& password) const;
+    std::vector<SymbolId> validatePassword(const std::string& password) const;
+
+    /**
+     * @brief Result cache key of a query
+     * @param K Target value (Z - C)
+     * @param strategy Strategy answering the query
+     */
+    std::string cacheKey(const mpz_class& K, const DecryptionStrategy& strategy) const;
 
-    std::unordered_map<char, mpz_class> charToPartition; // Maps characters to partition values
-    std::unordered_map<mpz_class, char> partitionToChar; // Reverse mapping for decryption
+    std::unordered_map<std::string, mpz_class> symbolToPartition; // Maps symbols (UTF-8) to partition values
+    std::map<mpz_class, std::string> partitionToSymbol; // Reverse mapping for decryption
+    LookupTable preparedTable; // Sorted values, bounds and native-width views
+    BulkEncoder bulkEncoder; // Dense 256-entry table (plus code points) for encryptBatch
+    std::shared_ptr<ResultCache> resultCache; // Optional cache of complete results
     mpz_class constantC; // The constant C value
     unsigned int minPasswordLength; // Minimum allowed password length
     unsigned int maxPasswordLength; // Maximum allowed password length
@@ -91,17 +228,55 @@ public:
     
     /**
      * @brief Decrypt function to be implemented by concrete strategies
+     *
+     * Candidates are handed to the visitor as soon as they are found and are
+     * not retained by the strategy.
      * @param targetSum The K value (Z - C) to find partitioning for
-     * @param charToPartition Map of characters to their partition values
+     * @param table Prepared lookup table (characters, values and derived data)
+     * @param minLength Minimum allowed password length
+     * @param maxLength Maximum allowed password length
+     * @param visit Called with every candidate; returns false to stop the search
+     * @return True if the search ran to completion, false if the visitor stopped it
+     */
+    virtual bool decrypt(
+        const mpz_class& targetSum,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const SolutionVisitor& visit) = 0;
+
+    /**
+     * @brief Collect every candidate into a vector
+     * @param targetSum The K value (Z - C) to find partitioning for
+     * @param table Prepared lookup table (characters, values and derived data)
      * @param minLength Minimum allowed password length
      * @param maxLength Maximum allowed password length
      * @return Possible decryption results (may be multiple or none)
      */
-    virtual std::vector<std::string> decrypt(
+    std::vector<std::string> decrypt(
         const mpz_class& targetSum,
-        const std::unordered_map<char, mpz_class>& charToPartition,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength);
+
+    /**
+     * @brief Decrypt many targets, sharing work between them
+     *
+     * The default implementation decrypts the targets one after another;
+     * strategies override it to answer all targets in one pass.
+     * @param targetSums The K values (Z - C) to find partitionings for
+     * @param table Prepared lookup table (characters, values and derived data)
+     * @param minLength Minimum allowed password length
+     * @param maxLength Maximum allowed password length
+     * @param visit Called with the target's index and each candidate; returns false to stop
+     * @return True if the search ran to completion, false if the visitor stopped it
+     */
+    virtual bool decryptBatch(
+        const std::vector<mpz_class>& targetSums,
+        const LookupTable& table,
         unsigned int minLength,
-        unsigned int maxLength) = 0;
+        unsigned int maxLength,
+        const BatchSolutionVisitor& visit);
     
     /**
      * @brief Get the name of the strategy for display and benchmarking
@@ -109,17 +284,99 @@ public:
      */
     virtual std::string getName() const = 0;
 
+    /**
+     * @brief Identify the strategy and every option that changes its results
+     *
+     * Part of the result cache key: two strategies with the same tag must find the
+     * same candidates for the same query. Strategies with options that limit or
+     * reorder their output override it.
+     * @return Cache tag (the name by default)
+     */
+    virtual std::string getCacheTag() const { return getName(); }
+
     /**
      * @brief Get performance metrics from the last decryption
      * @return String with performance information
      */
     std::string getPerformanceMetrics() const;
 
+    /**
+     * @brief Get the number of combinations checked by the last decryption
+     */
+    size_t getCombinationsChecked() const { return combinationsChecked; }
+
+    /**
+     * @brief Get the peak working memory of the last decryption in bytes
+     */
+    size_t getMemoryUsed() const { return memoryUsed; }
+
+    /**
+     * @brief Get structured metrics of the last decryption
+     * @return Counters, timings and memory, exportable as JSON or Prometheus text
+     */
+    const SearchMetrics& getMetrics() const { return metrics; }
+
+    /**
+     * @brief Let another thread cancel the search, bound it by a deadline and watch its progress
+     *
+     * The control is polled from the inner loops of every decryption until it is
+     * replaced; a stopped search returns false. Composite strategies hand it on
+     * to the strategies they delegate to.
+     * @param searchControl Control to poll (nullptr = none); must outlive the searches
+     */
+    virtual void setSearchControl(SearchControl* searchControl) { control = searchControl; }
+
 protected:
+    /**
+     * @brief Copy duration, combinationsChecked and memoryUsed into metrics
+     */
+    void finishMetrics();
+
+    /**
+     * @brief Add the per-length entry of a finished length to the metrics
+     *
+     * Also marks the length finished on the search control, unless it stopped the search.
+     * @param length Password length that was searched
+     * @param lengthStart When the search of this length started
+     * @param nodes Nodes (or records) visited for this length
+     * @param solutions Solutions found for this length
+     */
+    void recordLength(unsigned int length,
+                      std::chrono::high_resolution_clock::time_point lengthStart,
+                      size_t nodes,
+                      size_t solutions);
+
+    /**
+     * @brief Fold the counters of a strategy that searched on this one's behalf
+     * @param delegate Fallback or engine strategy after its decryption
+     * @param withLengths Whether to copy its per-length entries as well
+     */
+    void absorbMetrics(const DecryptionStrategy& delegate, bool withLengths);
+
+    /**
+     * @brief Publish nodes to the search control and check whether to stop
+     * @param nodes Nodes visited since the last call
+     * @return True if the search must stop
+     */
+    bool pollControl(uint64_t nodes) {
+        if (!control) {
+            return false;
+        }
+        control->addNodes(nodes);
+        return control->poll();
+    }
+
+    /**
+     * @brief Whether the search control has stopped the search
+     */
+    bool stopRequested() const { return control && control->stopRequested(); }
+
     // Performance tracking
-    std::chrono::microseconds duration;
+    std::chrono::microseconds duration{0};
     size_t combinationsChecked = 0;
-    size_t memoryUsed = 0; // Approximate memory usage in bytes
+    size_t memoryUsed = 0; // Peak bytes allocated by the search itself
+    SearchMetrics metrics; // Detailed metrics of the last decryption
+    SearchControl* control = nullptr; // Cancellation and progress, if any
 };
 
 #endif // PARTITION_ENCRYPTION_H
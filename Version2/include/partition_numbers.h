@@ -0,0 +1,52 @@
+#ifndef PARTITION_NUMBERS_H
+#define PARTITION_NUMBERS_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <gmpxx.h>
+
+/**
+ * @brief Compute the partition numbers p(0..maxN) with Euler's pentagonal recurrence
+ *
+ * p(n) = sum over k >= 1 of (-1)^(k+1) [p(n - k(3k-1)/2) + p(n - k(3k+1)/2)].
+ * Values are computed in blocks: the terms reaching below the block only read
+ * finished values and are summed in parallel, one slice of the block per thread;
+ * the few terms inside the block are then added in order. Total work is
+ * O(n^1.5) big-integer additions.
+ * @param maxN Largest argument
+ * @param threads Worker threads (1 = calling thread only, 0 = all hardware threads)
+ * @return maxN + 1 values, p(0) first
+ */
+std::vector<mpz_class> partitionNumbers(size_t maxN, unsigned int threads = 1);
+
+/**
+ * @brief Assign partition numbers to the characters of an alphabet
+ *
+ * Character i of the alphabet gets p(first + i * step). p is strictly increasing
+ * from p(1) on, so every character gets a distinct value.
+ * @param alphabet Distinct characters (UTF-8 code points), in the order values are assigned
+ * @param first Argument of the first character's value (at least 1)
+ * @param step Distance between the arguments of consecutive characters (at least 1)
+ * @param threads Worker threads for partitionNumbers()
+ * @return Character-to-partition mapping, as loaded from a lookup table file
+ * @throws std::invalid_argument on an empty or malformed alphabet, a repeated character,
+ *         or first or step of 0
+ */
+std::unordered_map<std::string, mpz_class> partitionAlphabet(const std::string& alphabet, size_t first,
+                                                            size_t step, unsigned int threads = 1);
+
+/**
+ * @brief Write a mapping as a lookup table CSV, in alphabet order
+ * @param alphabet Characters to write (UTF-8), in order
+ * @param symbolToPartition Value of every character of the alphabet
+ * @param path Destination file
+ * @throws std::invalid_argument if a character cannot be written in the CSV format (',' or a line break)
+ * @throws std::runtime_error if the file cannot be written
+ */
+void writeLookupTableCsv(const std::string& alphabet,
+                         const std::unordered_map<std::string, mpz_class>& symbolToPartition,
+                         const std::string& path);
+
+#endif // PARTITION_NUMBERS_H
@@ -0,0 +1,77 @@
+#ifndef REACHABILITY_INDEX_H
+#define REACHABILITY_INDEX_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @class ReachabilityIndex
+ * @brief Exact answer to "can `need` be written as a sum of exactly r table values?"
+ *
+ * For every r in [0, maxLength] a bitset marks which sums in [minVal*r, maxVal*r]
+ * are reachable with r values. Row r is built from row r-1 by OR-ing one shifted
+ * copy per table value, so a query is a single bit test. Backtracking consults it
+ * at every node, which means no subtree is entered unless it contains a solution.
+ */
+class ReachabilityIndex {
+public:
+    /**
+     * @brief Build the index for a set of values
+     * @param values Partition values (any order)
+     * @param maxLength Largest r the index must answer for
+     * @param maxBytes Memory budget for the bitsets
+     * @return The index, or nullptr if it would exceed maxBytes
+     */
+    static std::shared_ptr<const ReachabilityIndex> build(
+        const std::vector<uint64_t>& values,
+        unsigned int maxLength,
+        size_t maxBytes);
+
+    /**
+     * @brief Memory the index would need
+     * @param minVal Smallest value
+     * @param maxVal Largest value
+     * @param maxLength Largest r the index must answer for
+     * @return Size of all bitsets in bytes
+     */
+    static size_t estimateBytes(uint64_t minVal, uint64_t maxVal, unsigned int maxLength);
+
+    /**
+     * @brief Check whether a sum is reachable with exactly r values
+     * @param r Number of values (must be <= getMaxLength())
+     * @param need Sum to reach
+     * @return True if some r values sum to need
+     */
+    bool reachable(unsigned int r, uint64_t need) const {
+        if (need < minVal * r || need > maxVal * r) {
+            return false;
+        }
+        uint64_t bit = need - minVal * r;
+        return (bits[rowOffsets[r] + (bit >> 6)] >> (bit & 63)) & 1u;
+    }
+
+    /**
+     * @brief Check whether this index was built for the given values and length
+     * @param values Partition values to compare against
+     * @param length Largest r a search will query
+     * @return True if the index can serve that search
+     */
+    bool covers(const std::vector<uint64_t>& values, unsigned int length) const;
+
+    unsigned int getMaxLength() const { return maxLength; }
+    size_t getMemoryBytes() const { return bits.size() * sizeof(uint64_t); }
+
+private:
+    ReachabilityIndex() = default;
+
+    std::vector<uint64_t> values;     // Sorted values the index was built from
+    std::vector<uint64_t> bits;       // All rows, concatenated
+    std::vector<size_t> rowOffsets;   // Word offset of row r in bits
+    uint64_t minVal = 0;
+    uint64_t maxVal = 0;
+    unsigned int maxLength = 0;
+};
+
+#endif // REACHABILITY_INDEX_H
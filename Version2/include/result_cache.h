@@ -0,0 +1,132 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <gmpxx.h>
+
+/**
+ * @class ResultCache
+ * @brief Complete decryption results of earlier queries, in memory and optionally on disk
+ *
+ * Entries are keyed by everything that determines a result: the table fingerprint,
+ * C, K, the length range and the strategy's cache tag. Loading another table
+ * changes the fingerprint, so results of the old table are never returned again;
+ * they age out of the memory tier and stay unread on disk. Empty results ("no
+ * solution") are cached like any other.
+ *
+ * The memory tier is an LRU list bounded in bytes. With a directory, every entry
+ * is also written to its own small binary file there, so results survive the
+ * process and can be shared between processes. Disk entries store their full key
+ * and are checked against it on load; unreadable or foreign files count as misses.
+ * All methods may be called from several threads.
+ */
+class ResultCache {
+public:
+    /**
+     * @struct Stats
+     * @brief Lookup and store counters since construction
+     */
+    struct Stats {
+        uint64_t memoryHits = 0;
+        uint64_t diskHits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;   // Entries dropped from the memory tier
+    };
+
+    /**
+     * @brief Constructor
+     * @param maxMemoryBytes Budget of the memory tier; results larger than a
+     *        sixteenth of it are not cached
+     * @param directory Directory of the disk tier (empty = memory only); must exist
+     */
+    explicit ResultCache(size_t maxMemoryBytes = size_t(64) << 20, const std::string& directory = "");
+
+    /**
+     * @brief Build the key of a query
+     * @param tableFingerprint Fingerprint of the lookup table (LookupTable::getFingerprint)
+     * @param constantC Encryption constant C
+     * @param target K value of the query
+     * @param minLength Minimum password length
+     * @param maxLength Maximum password length
+     * @param strategyTag DecryptionStrategy::getCacheTag() of the strategy used
+     * @return Compact binary key
+     */
+    static std::string makeKey(uint64_t tableFingerprint, const mpz_class& constantC,
+                               const mpz_class& target, unsigned int minLength,
+                               unsigned int maxLength, const std::string& strategyTag);
+
+    /**
+     * @brief Look a key up in memory, then on disk
+     * @param key Key from makeKey()
+     * @param candidates Receives the cached candidates on a hit
+     * @return True on a hit
+     */
+    bool lookup(const std::string& key, std::vector<std::string>& candidates);
+
+    /**
+     * @brief Cache the complete result of a query
+     *
+     * Only results of searches that ran to completion may be stored.
+     * @param key Key from makeKey()
+     * @param candidates Every candidate of the query, in the order they were found
+     * @return False if the result is too large or the disk entry could not be written
+     */
+    bool store(const std::string& key, const std::vector<std::string>& candidates);
+
+    /**
+     * @brief Drop every entry of the memory tier (disk entries are kept)
+     */
+    void clear();
+
+    Stats getStats() const;
+
+    /**
+     * @brief Memory held by the entries of the memory tier
+     */
+    size_t getMemoryBytes() const;
+
+    /**
+     * @brief Largest result, in entryBytes() units, that is cached
+     */
+    size_t getMaxEntryBytes() const { return maxEntryBytes; }
+
+    /**
+     * @brief Memory a candidate is charged in the memory tier
+     */
+    static size_t entryBytes(const std::string& candidate) { return sizeof(std::string) + candidate.size(); }
+
+private:
+    struct Entry {
+        std::string key;
+        std::vector<std::string> candidates;
+        size_t bytes;
+    };
+
+    /**
+     * @brief Insert or refresh an entry and evict from the cold end (lock held)
+     */
+    void insert(const std::string& key, const std::vector<std::string>& candidates, size_t bytes);
+
+    std::string entryPath(const std::string& key) const;
+    bool readEntry(const std::string& key, std::vector<std::string>& candidates) const;
+    bool writeEntry(const std::string& key, const std::vector<std::string>& candidates) const;
+
+    size_t maxMemoryBytes;
+    size_t maxEntryBytes;
+    std::string directory;
+
+    mutable std::mutex mutex;
+    std::list<Entry> entries; // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t memoryBytes = 0;
+    Stats stats;
+};
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,69 @@
+#ifndef SCHROEPPEL_SHAMIR_STRATEGY_H
+#define SCHROEPPEL_SHAMIR_STRATEGY_H
+
+#include "partition_encryption.h"
+#include "partial_sums.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <gmpxx.h>
+
+/**
+ * @class SchroeppelShamirStrategy
+ * @brief Four-list Meet-in-the-Middle with O(c^(n/4)) memory
+ *
+ * The positions are split into four quarters A, B, C, D and each quarter's
+ * partial sums are generated and sorted (O(c^(n/4)) records each). Instead of
+ * materialising the two halves like MeetInTheMiddleStrategy, the sums A+B are
+ * streamed in ascending order through a min-heap and the sums C+D in descending
+ * order through a max-heap, and the two streams are matched like a two-pointer
+ * merge. Time stays O(c^(n/2) log c) while memory drops to O(c^(n/4)).
+ */
+class SchroeppelShamirStrategy : public DecryptionStrategy {
+public:
+    SchroeppelShamirStrategy() = default;
+
+    /**
+     * @brief Decrypt using the Schroeppel-Shamir four-list approach
+     *
+     * Tables whose sums do not fit in 64 bits are handed to the backtracking
+     * strategy, which has 128-bit and GMP kernels.
+     * @param targetSum The K value (Z - C) to find partitioning for
+     * @param table Prepared lookup table
+     * @param minLength Minimum allowed password length
+     * @param maxLength Maximum allowed password length
+     * @param visit Called with every candidate; returns false to stop the search
+     * @return True if the search ran to completion, false if the visitor stopped it
+     */
+    bool decrypt(
+        const mpz_class& targetSum,
+        const LookupTable& table,
+        unsigned int minLength,
+        unsigned int maxLength,
+        const SolutionVisitor& visit) override;
+
+    using DecryptionStrategy::decrypt;
+
+    /**
+     * @brief Get the strategy name
+     * @return Strategy name
+     */
+    std::string getName() const override { return "Schroeppel-Shamir"; }
+
+private:
+    /**
+     * @brief Solve one password length
+     * @param targetSum Target sum
+     * @param table Prepared lookup table
+     * @param length Password length
+     * @param visit Receives complete passwords
+     * @return False if the visitor stopped the search
+     */
+    bool decryptLength(
+        uint64_t targetSum,
+        const LookupTable& table,
+        unsigned int length,
+        const SolutionVisitor& visit);
+};
+
+#endif // SCHROEPPEL_SHAMIR_STRATEGY_H
@@ -0,0 +1,58 @@
+#ifndef SEARCH_CHECKPOINT_H
+#define SEARCH_CHECKPOINT_H
+
+#include "lookup_table.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <gmpxx.h>
+
+/**
+ * @struct SearchCheckpoint
+ * @brief Frontier of an interrupted depth-first search, as stored on disk
+ *
+ * The search resumes at the node whose path from the root is symbols: every
+ * candidate before it in depth-first order has already been emitted, none after
+ * it has. Files are small "key value" text files with a version header, written
+ * to a temporary file and renamed into place so a crash never leaves a torn one.
+ */
+struct SearchCheckpoint {
+    static const unsigned int formatVersion = 1;
+
+    mpz_class target = 0;            // K value of the search
+    unsigned int minLength = 0;
+    unsigned int maxLength = 0;
+    uint64_t tableFingerprint = 0;   // Detects resuming against a different table
+    bool multiset = false;           // Search placed symbols in table order only
+    unsigned int length = 0;         // Length being searched; shorter ones are finished
+    std::vector<uint32_t> symbols;   // Symbol index at each depth of the resume node
+    uint64_t nodes = 0;              // Counters accumulated before the snapshot
+    uint64_t prunes = 0;
+    uint64_t solutions = 0;          // Candidates handed to the visitor before the snapshot
+    bool complete = false;           // Search ran to completion
+
+    /**
+     * @brief Write the checkpoint atomically
+     * @param path Destination file
+     * @throws std::runtime_error if the file cannot be written
+     */
+    void save(const std::string& path) const;
+
+    /**
+     * @brief Read a checkpoint written by save()
+     * @param path Checkpoint file
+     * @return The checkpoint
+     * @throws std::runtime_error if the file is missing, malformed or of another version
+     */
+    static SearchCheckpoint load(const std::string& path);
+
+    /**
+     * @brief Hash of a table's characters and values in sort order
+     * @param table Prepared lookup table
+     * @return 64-bit FNV-1a fingerprint, computed when the table was built
+     */
+    static uint64_t fingerprint(const LookupTable& table);
+};
+
+#endif // SEARCH_CHECKPOINT_H
@@ -0,0 +1,134 @@
+#ifndef SEARCH_CONSTRAINTS_H
+#define SEARCH_CONSTRAINTS_H
+
+#include "lookup_table.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct PositionConstraints
+ * @brief Constraints of one password length, in symbol ids of a lookup table
+ */
+struct PositionConstraints {
+    std::vector<std::vector<SymbolId>> allowed; // allowed[p] = ids allowed at position p, ascending (descending value)
+    std::vector<uint32_t> requirementBits;      // requirementBits[id] = required sets the symbol belongs to
+    uint32_t requirements = 0;                  // One bit per required set
+
+    /**
+     * @brief Whether a complete password contains a symbol of every required set
+     */
+    bool satisfied(const SymbolId* symbols, size_t count) const {
+        uint32_t covered = 0;
+        for (size_t i = 0; i < count; ++i) {
+            covered |= requirementBits[symbols[i]];
+        }
+        return (covered & requirements) == requirements;
+    }
+};
+
+/**
+ * @class SearchConstraints
+ * @brief What is known about a password, applied during the search instead of afterwards
+ *
+ * Constraints narrow the symbols allowed at each position and require symbols of
+ * given sets somewhere in the password. Strategies that support them
+ * (BacktrackingStrategy, MeetInTheMiddleStrategy) only enumerate the allowed
+ * symbols and bound every subtree by the smallest and largest sums the remaining
+ * positions can still add, so a constrained query costs roughly the size of the
+ * narrowed space.
+ *
+ * Symbol sets are written like hashcat masks: ?l (a-z), ?u (A-Z), ?d (0-9),
+ * ?s (ASCII punctuation and space), ?a (all four), ?? (a literal '?'); any other
+ * UTF-8 code point stands for itself. Classes only contribute the symbols the
+ * lookup table has; literal symbols missing from the table are an error, except
+ * in exclude().
+ */
+class SearchConstraints {
+public:
+    /**
+     * @brief Fix the length and the set of every position, e.g. "?u?l?l?l?d?d"
+     * @throws std::invalid_argument on malformed masks
+     */
+    SearchConstraints& setMask(const std::string& mask);
+
+    /**
+     * @brief Require the password to start with a known fragment (taken literally)
+     * @throws std::invalid_argument if the fragment is not valid UTF-8
+     */
+    SearchConstraints& setPrefix(const std::string& prefix);
+
+    /**
+     * @brief Require the password to end with a known fragment (taken literally)
+     * @throws std::invalid_argument if the fragment is not valid UTF-8
+     */
+    SearchConstraints& setSuffix(const std::string& suffix);
+
+    /**
+     * @brief Restrict one position to a symbol set
+     * @param position Position from the start (0 = first), or from the end if negative (-1 = last)
+     * @param symbols Set in mask syntax, e.g. "?d" or "?u?d" or "xyz"
+     * @throws std::invalid_argument on malformed sets
+     */
+    SearchConstraints& restrictPosition(int position, const std::string& symbols);
+
+    /**
+     * @brief Never use these symbols at any position
+     * @param symbols Set in mask syntax
+     * @throws std::invalid_argument on malformed sets
+     */
+    SearchConstraints& exclude(const std::string& symbols);
+
+    /**
+     * @brief Require at least one symbol of a set somewhere in the password
+     * @param symbols Set in mask syntax, e.g. "?d" for "contains a digit"
+     * @throws std::invalid_argument on malformed sets or beyond 32 required sets
+     */
+    SearchConstraints& require(const std::string& symbols);
+
+    /**
+     * @brief Whether nothing has been constrained
+     */
+    bool empty() const { return description.empty(); }
+
+    /**
+     * @brief Canonical text of the constraints, part of the result cache tag
+     */
+    const std::string& describe() const { return description; }
+
+    /**
+     * @brief Translate the constraints for one password length
+     * @param table Lookup table the ids refer to
+     * @param length Password length
+     * @param out Receives the per-position sets and requirements
+     * @return False if no password of this length can satisfy the constraints
+     * @throws std::invalid_argument if a literal symbol is not in the table
+     */
+    bool resolve(const LookupTable& table, unsigned int length, PositionConstraints& out) const;
+
+private:
+    /**
+     * @brief Parse a set in mask syntax into its symbols
+     * @param text Set text
+     * @param symbols Receives the symbols, classes expanded (may repeat)
+     * @param literals Receives the symbols that were written literally
+     */
+    static void parseSet(const std::string& text, std::vector<std::string>& symbols,
+                         std::vector<std::string>& literals);
+
+    /**
+     * @brief Append one call to the description
+     */
+    void describeCall(const std::string& name, const std::string& value);
+
+    std::vector<std::vector<std::string>> maskSets;                   // Per position; empty without a mask
+    std::vector<std::pair<int, std::vector<std::string>>> positionSets; // Position (negative = from the end), set
+    std::vector<std::string> excluded;
+    std::vector<std::vector<std::string>> required;
+    std::vector<std::string> literals;                                // Must exist in the table
+    std::string description;
+};
+
+#endif // SEARCH_CONSTRAINTS_H
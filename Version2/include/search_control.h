@@ -0,0 +1,116 @@
+#ifndef SEARCH_CONTROL_H
+#define SEARCH_CONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class SearchControl
+ * @brief Cancellation, deadline and live progress shared between a search and its owner
+ *
+ * A strategy given a control (DecryptionStrategy::setSearchControl) polls it from
+ * its inner loops every pollInterval nodes, publishing the nodes visited since the
+ * last poll and, where it can tell, how much of the current length it has
+ * covered. A poll that finds the control cancelled or past its deadline makes the
+ * search unwind and return false, like a visitor that stopped it. Candidates
+ * found before that point have already been handed to the visitor.
+ *
+ * The owner may cancel and read the progress from any thread; the counters are
+ * relaxed atomics and only approximately consistent with each other.
+ */
+class SearchControl {
+public:
+    static const size_t pollInterval = 4096; // Nodes between polls; a power of two
+    static const size_t pollMask = pollInterval - 1;
+
+    /**
+     * @brief Ask the search to stop at its next poll
+     */
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    /**
+     * @brief Stop the search at the first poll after a point in time
+     */
+    void setDeadline(std::chrono::steady_clock::time_point when) { deadline = when; }
+
+    /**
+     * @brief Whether cancel() was called
+     */
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Whether a poll found the deadline passed
+     */
+    bool isExpired() const { return expired.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Whether the search has been told to stop, without reading the clock
+     */
+    bool stopRequested() const { return isCancelled() || isExpired(); }
+
+    /**
+     * @brief Check for cancellation and the deadline
+     * @return True if the search must stop
+     */
+    bool poll() {
+        if (stopRequested()) {
+            return true;
+        }
+        if (deadline != std::chrono::steady_clock::time_point::max() &&
+            std::chrono::steady_clock::now() >= deadline) {
+            expired.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Publish nodes (or records, merge steps) visited since the last call
+     */
+    void addNodes(uint64_t count) { nodes.fetch_add(count, std::memory_order_relaxed); }
+
+    /**
+     * @brief Publish the share of the current length searched so far, in [0, 1]
+     */
+    void setLengthFraction(double fraction) { lengthFraction.store(fraction, std::memory_order_relaxed); }
+
+    /**
+     * @brief Mark a password length as searched completely
+     *
+     * Called by DecryptionStrategy::recordLength(); lengths finish in ascending order.
+     */
+    void finishLength(unsigned int length) {
+        finishedLength.store(length, std::memory_order_relaxed);
+        lengthFraction.store(0.0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Nodes published so far
+     */
+    uint64_t getNodes() const { return nodes.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Longest length searched completely (0 before the first)
+     */
+    unsigned int getFinishedLength() const { return finishedLength.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Share of the length after getFinishedLength() searched so far
+     *
+     * Only sequential backtracking and the bucketed meet-in-the-middle report it;
+     * other searches advance a whole length at a time.
+     */
+    double getLengthFraction() const { return lengthFraction.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> expired{false};
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(); // Set before the search starts
+    std::atomic<uint64_t> nodes{0};
+    std::atomic<unsigned int> finishedLength{0};
+    std::atomic<double> lengthFraction{0.0};
+};
+
+#endif // SEARCH_CONTROL_H
@@ -0,0 +1,136 @@
+#ifndef SEARCH_METRICS_H
+#define SEARCH_METRICS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-depth node counts and prune reasons cost a few instructions per search
+// node; build with -DPARTITION_ENABLE_METRICS=0 to compile them out
+#ifndef PARTITION_ENABLE_METRICS
+#define PARTITION_ENABLE_METRICS 1
+#endif
+
+/**
+ * @struct SearchMetrics
+ * @brief Machine-readable metrics of one decryption call
+ *
+ * Totals (nodes, solutions, timings, peak memory) are always collected.
+ * nodesPerDepth and the prune reasons are only filled when the library is
+ * built with PARTITION_ENABLE_METRICS.
+ */
+struct SearchMetrics {
+    /**
+     * @struct LengthMetrics
+     * @brief Work done for one password length
+     */
+    struct LengthMetrics {
+        unsigned int length = 0;
+        double milliseconds = 0.0;
+        uint64_t nodes = 0;                  // Nodes, records or merge steps, per strategy
+        uint64_t solutions = 0;
+    };
+
+    std::string strategy;                    // Name of the strategy that produced the metrics
+    double milliseconds = 0.0;               // Wall time of the whole call
+    uint64_t nodes = 0;                      // Same as getCombinationsChecked()
+    uint64_t solutions = 0;                  // Leaf hits handed to the visitor
+    size_t peakBytes = 0;                    // Peak working memory owned by the search
+    uint64_t recordsGenerated = 0;           // Partial-sum records built by the MITM variants
+    uint64_t bytesSpilled = 0;               // Run-file bytes written by out-of-core MITM
+    uint64_t boundPrunes = 0;                // Subtrees cut by the min/max sum bounds
+    uint64_t reachabilityPrunes = 0;         // Subtrees cut by the reachability index
+    std::vector<uint64_t> nodesPerDepth;     // Backtracking nodes by prefix length
+    std::vector<LengthMetrics> lengths;      // In search order
+
+    /**
+     * @brief Clear everything and start metrics for a new call
+     * @param strategyName Name reported in the exports
+     */
+    void reset(const std::string& strategyName);
+
+    /**
+     * @brief Record the work done for one password length
+     *
+     * Repeated lengths (batches, composite strategies) accumulate into one entry.
+     */
+    void addLength(unsigned int length, double lengthMilliseconds, uint64_t lengthNodes,
+                   uint64_t lengthSolutions);
+
+    /**
+     * @brief Add the counters of another call (used by composite strategies)
+     *
+     * Counts, per-depth nodes and per-length entries are summed and peak memory
+     * takes the maximum. Wall time is left to the caller.
+     */
+    void merge(const SearchMetrics& other);
+
+    /**
+     * @brief Nodes per second over the whole call
+     */
+    double nodesPerSecond() const;
+
+    /**
+     * @brief Solutions per second over the whole call
+     */
+    double solutionsPerSecond() const;
+
+    /**
+     * @brief Export as a single JSON object
+     */
+    std::string toJson() const;
+
+    /**
+     * @brief Export in the Prometheus text exposition format
+     * @param prefix Metric name prefix
+     * @return Gauges labelled with the strategy name (and depth, reason or length)
+     */
+    std::string toPrometheus(const std::string& prefix = "partition_search") const;
+};
+
+/**
+ * @class MetricCounters
+ * @brief Per-thread hot-path counters merged into SearchMetrics after a search
+ *
+ * Every method is an empty inline function when PARTITION_ENABLE_METRICS is 0.
+ */
+class MetricCounters {
+public:
+    static constexpr unsigned int maxDepth = 64; // Deeper nodes are counted at maxDepth - 1
+
+    void node(unsigned int depth) {
+#if PARTITION_ENABLE_METRICS
+        ++nodesPerDepth[depth < maxDepth ? depth : maxDepth - 1];
+#else
+        (void)depth;
+#endif
+    }
+
+    void boundPrune() {
+#if PARTITION_ENABLE_METRICS
+        ++boundPrunes;
+#endif
+    }
+
+    void reachabilityPrune() {
+#if PARTITION_ENABLE_METRICS
+        ++reachabilityPrunes;
+#endif
+    }
+
+    /**
+     * @brief Add these counters to a metrics record
+     */
+    void addTo(SearchMetrics& metrics) const;
+
+private:
+#if PARTITION_ENABLE_METRICS
+    std::array<uint64_t, maxDepth> nodesPerDepth{};
+    uint64_t boundPrunes = 0;
+    uint64_t reachabilityPrunes = 0;
+#endif
+};
+
+#endif // SEARCH_METRICS_H
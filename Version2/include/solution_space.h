@@ -0,0 +1,149 @@
+#ifndef SOLUTION_SPACE_H
+#define SOLUTION_SPACE_H
+
+#include "lookup_table.h"
+#include "partition_encryption.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <gmpxx.h>
+
+/**
+ * @class SolutionSpace
+ * @brief Ranking and unranking of every password that encrypts to one target
+ *
+ * Solutions are numbered 0 .. size()-1 in exactly the order a sequential
+ * decrypt() emits them: shorter lengths first, then depth-first in table order.
+ * The constructor builds per-depth count tables, ways(r, s) = number of
+ * sequences of r symbols summing to s, as dense rows over the band of sums a
+ * search for the target can actually reach. With them the i-th solution is
+ * constructed directly by walking down from the root and skipping whole
+ * subtrees by their count, so a worker given a shard [begin, end) enumerates
+ * only its slice with no coordination.
+ *
+ * Counts are kept in the narrowest of uint64_t, unsigned __int128 and GMP that
+ * holds them without overflow, in the same way searches pick their sum width.
+ *
+ * Every query is const and the object may be shared between threads.
+ */
+class SolutionSpace {
+public:
+    /**
+     * @brief Build the count tables for a target
+     * @param targetSum The K value (Z - C) to decompose
+     * @param table Prepared lookup table
+     * @param minLength Minimum password length
+     * @param maxLength Maximum password length
+     * @throws std::invalid_argument if the length range is empty or exceeds the table
+     * @throws std::runtime_error if sums of maxLength values do not fit in 64 bits
+     */
+    SolutionSpace(const mpz_class& targetSum,
+                  const LookupTable& table,
+                  unsigned int minLength,
+                  unsigned int maxLength);
+
+    /**
+     * @brief Total number of solutions over all lengths
+     */
+    const mpz_class& size() const { return total; }
+
+    /**
+     * @brief Number of solutions of one length
+     * @param length Password length
+     * @return Count (zero outside the length range)
+     */
+    mpz_class sizeOfLength(unsigned int length) const;
+
+    /**
+     * @brief Construct the solution with a given rank
+     * @param index Rank in [0, size())
+     * @return The index-th password in decrypt order
+     * @throws std::out_of_range if index is not below size()
+     */
+    std::string unrank(const mpz_class& index) const;
+
+    /**
+     * @brief Position of a solution in decrypt order
+     * @param password A password that encrypts to the target
+     * @return Its rank in [0, size())
+     * @throws std::invalid_argument if password is not a solution
+     */
+    mpz_class rank(const std::string& password) const;
+
+    /**
+     * @brief Stream the solutions with rank in [begin, end)
+     *
+     * Subtrees entirely outside the range are skipped by their count, so the
+     * cost is proportional to the slice, not to its position.
+     * @param begin First rank to emit
+     * @param end One past the last rank (clamped to size())
+     * @param visit Called with each password; returns false to stop
+     * @return True if the slice was exhausted, false if visit stopped it
+     */
+    bool enumerate(const mpz_class& begin, const mpz_class& end, const SolutionVisitor& visit) const;
+
+    /**
+     * @brief Rank range of one of count balanced shards
+     *
+     * Shard sizes differ by at most one and together cover [0, size()).
+     * @param index Shard number in [0, count)
+     * @param count Number of shards
+     * @return [begin, end) of the shard
+     * @throws std::invalid_argument if index is not below count
+     */
+    std::pair<mpz_class, mpz_class> shard(unsigned int index, unsigned int count) const;
+
+    /**
+     * @brief Approximate heap memory held by the count tables
+     */
+    size_t getMemoryBytes() const;
+
+private:
+    template <typename Count>
+    std::vector<std::vector<Count>>& rows();
+
+    template <typename Count>
+    const std::vector<std::vector<Count>>& rows() const;
+
+    template <typename Count>
+    bool buildRows();
+
+    template <typename Count>
+    bool sumChildren(unsigned int r, uint64_t need, Count& sum) const;
+
+    template <typename Count>
+    const Count* ways(unsigned int r, uint64_t need) const;
+
+    template <typename Count>
+    bool enumerateLength(unsigned int length, const mpz_class& begin, const mpz_class& end,
+                         const SolutionVisitor& visit) const;
+
+    template <typename Count>
+    bool walk(unsigned int r, uint64_t need, Count& offset, const Count& begin, const Count& end,
+              std::vector<SymbolId>& path, std::string& password, const SolutionVisitor& visit) const;
+
+    template <typename Count>
+    void addPreceding(unsigned int r, uint64_t need, size_t symbol, mpz_class& offset) const;
+
+    std::vector<uint64_t> values;                       // Descending, as in the table
+    LookupTable symbolTable;                            // Spells ids for enumerate(), parses for rank()
+    uint64_t target = 0;
+    uint64_t minVal = 0;
+    uint64_t maxVal = 0;
+    unsigned int minLength = 0;
+    unsigned int maxLength = 0;
+
+    ValueWidth countWidth = ValueWidth::Native64;       // Type the rows below are stored in
+    std::vector<uint64_t> rowStart;                     // Smallest sum covered by each row
+    std::vector<std::vector<uint64_t>> rows64;          // rows[r][s - rowStart[r]] = ways(r, s)
+#ifdef PARTITION_HAVE_INT128
+    std::vector<std::vector<uint128_t>> rows128;
+#endif
+    std::vector<std::vector<mpz_class>> rowsGmp;
+    std::vector<mpz_class> lengthCounts;                // Solutions per length, from minLength
+    mpz_class total = 0;
+};
+
+#endif // SOLUTION_SPACE_H
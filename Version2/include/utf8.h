@@ -0,0 +1,39 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Decode the UTF-8 code point starting at text[position]
+ *
+ * Only well-formed sequences are accepted: no overlong forms, no surrogates
+ * and nothing above U+10FFFF.
+ * @param text Text to read
+ * @param size Bytes in text
+ * @param position Offset of the sequence; advanced past it on success
+ * @param codePoint Receives the decoded code point
+ * @return False if no well-formed sequence starts at position
+ */
+bool decodeUtf8(const char* text, size_t size, size_t& position, uint32_t& codePoint);
+
+inline bool decodeUtf8(const std::string& text, size_t& position, uint32_t& codePoint) {
+    return decodeUtf8(text.data(), text.size(), position, codePoint);
+}
+
+/**
+ * @brief Split UTF-8 text into its code points, each as its own encoded string
+ * @param text Text to split
+ * @param codePoints Receives the code points in order (cleared first)
+ * @return False if the text is not well-formed UTF-8
+ */
+bool splitUtf8(const std::string& text, std::vector<std::string>& codePoints);
+
+/**
+ * @brief Whether text is exactly one well-formed UTF-8 code point
+ */
+bool isSingleCodePoint(const std::string& text);
+
+#endif // UTF8_H
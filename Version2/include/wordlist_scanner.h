@@ -0,0 +1,159 @@
+#ifndef WORDLIST_SCANNER_H
+#define WORDLIST_SCANNER_H
+
+#include "bulk_encoder.h"
+#include "partition_encryption.h"
+#include "work_stealing_pool.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gmpxx.h>
+
+/**
+ * @class TargetSet
+ * @brief Read-only set of 64-bit encrypted values tuned for many failed lookups
+ *
+ * A one-hash bit filter with 16 bits per value rejects about 94% of absent
+ * values with one memory access. The rest search the values stored in
+ * Eytzinger (breadth-first) order, where the next levels of a search share a
+ * cache line and are prefetched while the current comparison runs.
+ */
+class TargetSet {
+public:
+    /**
+     * @brief Build the set (duplicates are merged)
+     * @param values Encrypted values
+     */
+    explicit TargetSet(std::vector<uint64_t> values);
+
+    /**
+     * @brief Whether a value is in the set
+     */
+    bool contains(uint64_t value) const {
+        uint64_t slot = (value * 0x9E3779B97F4A7C15ull) >> filterShift;
+        if (!((filter[slot >> 6] >> (slot & 63)) & 1)) {
+            return false;
+        }
+
+        // Branch-free descent; k ends as the path to the first value >= the query
+        size_t k = 1;
+        const size_t count = tree.size();
+        while (k < count) {
+#if defined(__GNUC__)
+            if (k * prefetchStride < count) {
+                __builtin_prefetch(tree.data() + k * prefetchStride);
+            }
+#endif
+            k = 2 * k + (tree[k] < value);
+        }
+        // Undo the right turns taken after the last left turn, then that left turn
+        while (k & 1) {
+            k >>= 1;
+        }
+        k >>= 1;
+        return k != 0 && tree[k] == value;
+    }
+
+    /**
+     * @brief Number of distinct values
+     */
+    size_t size() const { return tree.size() - 1; }
+
+    /**
+     * @brief Memory held by the filter and the tree
+     */
+    size_t memoryBytes() const { return (filter.size() + tree.size()) * sizeof(uint64_t); }
+
+private:
+    static const size_t prefetchStride = 8; // Values per cache line: descendants three levels down
+
+    /**
+     * @brief Store sorted values in Eytzinger order below node k
+     */
+    void fill(const std::vector<uint64_t>& sorted, size_t& next, size_t k);
+
+    std::vector<uint64_t> tree;     // tree[1..n] in breadth-first order; tree[0] unused
+    std::vector<uint64_t> filter;   // One bit per hash slot
+    unsigned int filterShift = 63;  // 64 - log2(filter bits)
+};
+
+/**
+ * @struct ScanStats
+ * @brief Counters of one wordlist scan
+ */
+struct ScanStats {
+    uint64_t bytes = 0;         // Bytes of the wordlist scanned
+    uint64_t words = 0;         // Non-empty lines
+    uint64_t encrypted = 0;     // Words that are valid passwords for the table
+    uint64_t matches = 0;       // Words whose Z is in the target set
+    double seconds = 0.0;       // Wall time of the scan
+    bool completed = true;      // False if the visitor stopped the scan
+};
+
+/**
+ * @brief Receives the Z value and the word of every match; returns false to stop
+ */
+using ScanVisitor = std::function<bool(uint64_t encryptedValue, const std::string& word)>;
+
+/**
+ * @class WordlistScanner
+ * @brief Encrypts every line of a wordlist and reports the words whose Z is a known target
+ *
+ * The wordlist is memory-mapped and split into chunks of a few MiB that end on
+ * a newline, scanned in parallel on a work-stealing pool. Words are encrypted
+ * with the BulkEncoder kernels (AVX2 gathers where available) and probed
+ * against a TargetSet, so a scan costs a few nanoseconds per word and nothing
+ * is allocated except for matches. Lines may end in "\n" or "\r\n"; words
+ * that are not valid passwords for the table are skipped.
+ *
+ * Matches of one chunk reach the visitor together, in file order, as soon as
+ * the chunk is done; chunks finish in any order. The visitor is never called
+ * concurrently.
+ */
+class WordlistScanner {
+public:
+    /**
+     * @brief Prepare a scan against a set of encrypted values
+     *
+     * Values that no password can encrypt to (negative, or beyond 64 bits) are ignored.
+     * @param system Encryption system whose table, C and length limits define Z
+     * @param targets Known encrypted values
+     * @throws std::runtime_error if encrypted values of this table do not fit in 64 bits
+     */
+    WordlistScanner(const PartitionEncryption& system, const std::vector<mpz_class>& targets);
+
+    /**
+     * @brief Scan a wordlist file
+     * @param path Wordlist with one word per line
+     * @param visit Receives every match
+     * @param threads Worker threads (1 = calling thread only, 0 = all hardware threads)
+     * @return Counters of the scan
+     * @throws std::runtime_error if the file cannot be read
+     */
+    ScanStats scanFile(const std::string& path, const ScanVisitor& visit, unsigned int threads = 0);
+
+    /**
+     * @brief Scan a wordlist held in memory
+     * @param data Wordlist bytes
+     * @param size Number of bytes
+     * @param visit Receives every match
+     * @param threads Worker threads (1 = calling thread only, 0 = all hardware threads)
+     * @return Counters of the scan
+     */
+    ScanStats scan(const char* data, size_t size, const ScanVisitor& visit, unsigned int threads = 0);
+
+    /**
+     * @brief Get the target set probed for every word
+     */
+    const TargetSet& getTargets() const { return targets; }
+
+private:
+    BulkEncoder encoder;                    // Copy of the system's dense-table encoder
+    TargetSet targets;
+    std::shared_ptr<WorkStealingPool> pool; // Reused while the thread count is unchanged
+};
+
+#endif // WORDLIST_SCANNER_H
@@ -0,0 +1,87 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WorkStealingPool
+ * @brief Fixed-size thread pool where idle workers steal queued tasks from busy ones
+ *
+ * Every worker owns a deque. Tasks submitted from inside a task go to the
+ * submitting worker's own deque and are popped LIFO (depth-first, cache-warm);
+ * idle workers steal FIFO from the other end, which hands them the oldest and
+ * therefore largest pieces of work.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void(unsigned int worker)>;
+
+    /**
+     * @brief Start the worker threads
+     * @param threadCount Number of workers (0 = hardware concurrency)
+     */
+    explicit WorkStealingPool(unsigned int threadCount);
+
+    /**
+     * @brief Stop and join all workers (queued tasks are discarded)
+     */
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * @brief Queue a task
+     *
+     * Called from a worker of this pool, the task goes to that worker's deque;
+     * otherwise tasks are spread round-robin.
+     * @param task Task receiving the index of the worker that runs it
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Block until every submitted task, including tasks they spawned, has run
+     *
+     * A task that throws does not end its worker: the first exception is kept
+     * and rethrown here, on the waiting thread, once the remaining tasks are done.
+     * Tasks that share work should raise their own stop flag before throwing.
+     */
+    void wait();
+
+    /**
+     * @brief Number of worker threads
+     */
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(unsigned int id);
+    bool takeTask(unsigned int id, Task& task);
+    void push(unsigned int id, Task task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> pending{0};      // Submitted but not yet finished
+    std::atomic<size_t> queued{0};       // Sitting in some deque
+    std::atomic<unsigned int> nextWorker{0};
+    bool stopping = false;               // Guarded by idleMutex
+    std::exception_ptr failure;          // First exception of a task, guarded by idleMutex
+    std::mutex idleMutex;
+    std::condition_variable idleCondition;
+    std::condition_variable doneCondition;
+};
+
+#endif // WORK_STEALING_POOL_H
@@ -0,0 +1,36 @@
+#include "atomic_file.h"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+void writeFileAtomically(const std::string& path, const std::function<void(std::ostream&)>& write,
+                         const std::string& what) {
+    std::string temporary = path + ".tmp" + std::to_string(std::random_device()());
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Could not write " + what + ": " + temporary);
+        }
+        try {
+            write(file);
+        } catch (...) {
+            file.close();
+            std::remove(temporary.c_str());
+            throw;
+        }
+        file.close();
+        if (!file) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Could not write " + what + ": " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Could not replace " + what + ": " + path);
+    }
+}
+
+void writeFileAtomically(const std::string& path, const std::string& bytes, const std::string& what) {
+    writeFileAtomically(path, [&bytes](std::ostream& file) { file.write(bytes.data(), bytes.size()); }, what);
+}
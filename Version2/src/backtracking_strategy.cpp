@@ -1,228 +1,1627 @@
 #include "backtracking_strategy.h"
+#include "multiset.h"
+#include "search_checkpoint.h"
 #include <algorithm>
+#include <bitset>
 #include <chrono>
+#include <functional>
 #include <iostream>
 #include <climits>
+#include <type_traits>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+
+/**
+ * Per-search constants shared by the search kernels
+ */
+template <typename Int>
+struct NativeSearch {
+    const std::vector<Int>& values;        // Sorted in descending order
+    const LookupTable& table;              // Spells out symbol ids (value order) as text
+    const std::vector<Int>& minRemaining;  // minRemaining[r] = minimum sum of r characters
+    const std::vector<Int>& maxRemaining;  // maxRemaining[r] = maximum sum of r characters
+    const ReachabilityIndex* reach;        // Exact pruning, or nullptr for bounds only
+    const PairSumTable* pairs;             // Closes the last two positions, or nullptr
+    Int target;
+    unsigned int length;
+    bool optimize;
+    bool multiset;                         // Only non-decreasing symbol sequences, one per multiset
+    SearchControl* control;                // Polled every SearchControl::pollInterval nodes, or nullptr
+};
+
+/**
+ * Explicit DFS stack of the iterative kernel, sized once before a search so the
+ * search itself never allocates
+ */
+template <typename Int>
+struct SearchStack {
+    std::vector<Int> need;          // need[d] = sum the positions from d on must still add
+    std::vector<uint32_t> next;     // next[d] = next symbol to try at depth d
+    std::vector<SymbolId> symbols;  // symbols[d] = symbol id placed at position d
+    std::string password;           // Spelled out from symbols only when a solution is emitted
+
+    /**
+     * @brief Size the stack for passwords of up to maxLength characters
+     * @param maxLength Longest password searched
+     * @param widest Largest value need will hold; pre-grows GMP frames
+     */
+    void prepare(unsigned int maxLength, const Int& widest) {
+        need.assign(maxLength + 1, widest);
+        next.assign(maxLength + 1, 0);
+        symbols.assign(maxLength, 0);
+        password.reserve(maxLength);
+    }
+
+    size_t memoryBytes() const {
+        return need.capacity() * sizeof(Int) + next.capacity() * sizeof(uint32_t) +
+               symbols.capacity() * sizeof(SymbolId) + password.capacity();
+    }
+};
+
+namespace {
+
+/**
+ * Node and prune counts of one thread, merged when the search ends
+ */
+struct SearchCounters {
+    size_t nodes = 0;
+    size_t prunes = 0;
+    MetricCounters detail;  // Per-depth nodes and prune reasons
+};
+
+/**
+ * Periodic snapshot of the sequential kernel's frontier
+ */
+struct CheckpointHook {
+    static const size_t defaultPollMask = (size_t(1) << 16) - 1; // Read the clock every 65,536 nodes
+
+    std::chrono::steady_clock::duration interval;
+    std::chrono::steady_clock::time_point last;
+    size_t pollMask;  // 0 polls at every node (multiset nodes each emit many candidates)
+    std::function<void(unsigned int depth, const SymbolId* symbols, const SearchCounters& counters)> save;
+
+    /**
+     * @brief Save the node about to be entered if the interval has elapsed
+     */
+    void poll(unsigned int depth, const SymbolId* symbols, const SearchCounters& counters) {
+        if (std::chrono::steady_clock::now() - last >= interval) {
+            save(depth, symbols, counters);
+            last = std::chrono::steady_clock::now();
+        }
+    }
+};
+
+/**
+ * @brief Whether the exact index says r characters cannot add up to rest
+ */
+template <typename Int>
+bool unreachable(const NativeSearch<Int>& search, unsigned int r, const Int& rest) {
+    if constexpr (std::is_same<Int, uint64_t>::value) {
+        return search.reach && !search.reach->reachable(r, rest);
+    } else {
+        return false;
+    }
+}
+
+/**
+ * @brief Whether a multiset search cannot fill r more positions after symbol i
+ *
+ * Later positions of a multiset search hold values no larger than values[i], so
+ * they add at most values[i] * r. GMP searches skip this bound to stay free of
+ * temporaries.
+ */
+template <typename Int>
+bool exceedsCappedMax(const NativeSearch<Int>& search, size_t i, unsigned int r, const Int& rest) {
+    if constexpr (std::is_same<Int, mpz_class>::value) {
+        return false;
+    } else {
+        return search.multiset && rest > search.values[i] * r;
+    }
+}
+
+/**
+ * @brief Call visit(i) for every character i that can extend the current prefix
+ * @param from Smallest symbol index allowed (the last symbol in multiset searches)
+ * @return False as soon as visit returns false
+ */
+template <typename Int, typename Visit>
+bool forEachViableChild(const NativeSearch<Int>& search, Int sumNeeded, unsigned int remainingPositions,
+                        size_t from, SearchCounters& counters, Visit&& visit) {
+    const std::vector<Int>& values = search.values;
+
+    // Values are sorted in descending order: skip straight past the ones that
+    // would overshoot the target
+    size_t first = std::lower_bound(values.begin(), values.end(), sumNeeded,
+                                    std::greater<Int>()) - values.begin();
+
+    for (size_t i = std::max(first, from); i < values.size(); ++i) {
+        Int rest = sumNeeded - values[i];
+
+        if (search.optimize) {
+            // Every later value is smaller and leaves an even larger rest
+            if (rest > search.maxRemaining[remainingPositions - 1] ||
+                exceedsCappedMax(search, i, remainingPositions - 1, rest)) {
+                ++counters.prunes;
+                counters.detail.boundPrune();
+                break;
+            }
+            if (rest < search.minRemaining[remainingPositions - 1]) {
+                ++counters.prunes;
+                counters.detail.boundPrune();
+                continue;
+            }
+            // Exact check: only descend into subtrees that contain a solution
+            if (unreachable(search, remainingPositions - 1, rest)) {
+                ++counters.prunes;
+                counters.detail.reachabilityPrune();
+                continue;
+            }
+        }
+
+        if (!visit(i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Publish progress to the search control and check whether to stop
+ *
+ * A search from the root estimates its position in the length from the first
+ * two symbols of its path; the subtrees of a parallel search cannot tell.
+ * @return True if the search must stop
+ */
+template <typename Int>
+bool reportProgress(const NativeSearch<Int>& search, const SymbolId* symbols, unsigned int depth,
+                    bool fromRoot) {
+    SearchControl& control = *search.control;
+    control.addNodes(SearchControl::pollInterval);
+    if (fromRoot && depth > 0) {
+        double count = static_cast<double>(search.values.size());
+        double covered = symbols[0] + (depth > 1 ? symbols[1] / count : 0.0);
+        control.setLengthFraction(covered / count);
+    }
+    return control.poll();
+}
+
+/**
+ * @brief Spell out the symbols of a complete password and hand it to emit
+ */
+template <typename Int, typename Emit>
+bool emitSymbols(const NativeSearch<Int>& search, SearchStack<Int>& stack, Emit& emit) {
+    search.table.spell(stack.symbols.data(), search.length, stack.password);
+    return emit(stack.password);
+}
+
+/**
+ * @brief Iterative depth-first search over a prepared stack
+ *
+ * Frames live in a preallocated SearchStack: need[d] is updated in place (no
+ * temporaries, also for GMP values) and a password string is only built for
+ * solutions. Works for native integers and for mpz_class.
+ * @param search Search parameters
+ * @param stack Stack sized for search.length. need[rootDepth, depth] and, below
+ *              depth, symbols and next describe the path to the first node
+ * @param rootDepth Depth of the subtree's root; the search returns when it is done
+ * @param depth Depth of the node entered first
+ * @param counters Counters of the calling thread
+ * @param emit Called with each solution; returns false to stop the search
+ * @param stop Optional flag that aborts the search when set by another thread
+ * @param checkpoint Optional hook that snapshots the frontier
+ * @return True if should continue searching, false if the search was stopped
+ */
+template <typename Int, typename Emit>
+bool runStack(const NativeSearch<Int>& search, SearchStack<Int>& stack, unsigned int rootDepth,
+              unsigned int depth, SearchCounters& counters, Emit& emit,
+              const std::atomic<bool>* stop, CheckpointHook* checkpoint) {
+    const std::vector<Int>& values = search.values;
+    const size_t valueCount = values.size();
+    const unsigned int length = search.length;
+    Int* need = stack.need.data();
+    uint32_t* next = stack.next.data();
+    SymbolId* symbols = stack.symbols.data();
+
+    bool entering = true;
+
+    for (;;) {
+        if (entering) {
+            // First visit of the node at this depth
+            entering = false;
+            if (checkpoint && (counters.nodes & checkpoint->pollMask) == 0) {
+                checkpoint->poll(depth, symbols, counters);
+            }
+            ++counters.nodes;
+            counters.detail.node(depth);
+
+            if (stop && stop->load(std::memory_order_relaxed)) {
+                return false;
+            }
+            if (search.control && (counters.nodes & SearchControl::pollMask) == 0 &&
+                reportProgress(search, symbols, depth, rootDepth == 0)) {
+                return false;
+            }
+
+            const Int& sumNeeded = need[depth];
+            unsigned int remainingPositions = length - depth;
+            bool expand = false;
+
+            if (remainingPositions == 0) {
+                if (sumNeeded == 0 && !emitSymbols(search, stack, emit)) {
+                    return false;
+                }
+            } else if (search.optimize &&
+                       (sumNeeded > search.maxRemaining[remainingPositions] ||
+                        sumNeeded < search.minRemaining[remainingPositions])) {
+                ++counters.prunes;
+                counters.detail.boundPrune();
+            } else if (search.pairs && remainingPositions == 2) {
+                // Two positions left: every pair with the needed sum is a solution
+                if constexpr (std::is_same<Int, uint64_t>::value) {
+                    uint32_t from = search.multiset && depth > 0 ? symbols[depth - 1] : 0;
+                    auto [begin, end] = search.pairs->find(sumNeeded);
+                    for (const PairSumTable::Pair* pair = begin; pair != end; ++pair) {
+                        if (search.multiset && (pair->first < from || pair->second < pair->first)) {
+                            continue;
+                        }
+                        symbols[length - 2] = static_cast<SymbolId>(pair->first);
+                        symbols[length - 1] = static_cast<SymbolId>(pair->second);
+                        if (!emitSymbols(search, stack, emit)) {
+                            return false;
+                        }
+                    }
+                }
+            } else {
+                // Values are sorted in descending order: skip straight past the
+                // ones that would overshoot the target. Multiset searches never
+                // go back to a larger value than the previous symbol's.
+                size_t first = std::lower_bound(values.begin(), values.end(), sumNeeded,
+                                                std::greater<Int>()) - values.begin();
+                if (search.multiset && depth > 0) {
+                    first = std::max<size_t>(first, symbols[depth - 1]);
+                }
+                next[depth] = static_cast<uint32_t>(first);
+                expand = true;
+            }
+
+            if (!expand) {
+                if (depth == rootDepth) {
+                    return true;
+                }
+                --depth;
+            }
+        }
+
+        // Advance the frame at this depth to its next viable child
+        unsigned int childRemaining = length - depth - 1;
+        const Int& sumNeeded = need[depth];
+        Int& rest = need[depth + 1];
+        size_t i = next[depth];
+
+        for (; i < valueCount; ++i) {
+            rest = sumNeeded - values[i];
+
+            if (search.optimize) {
+                // Every later value is smaller and leaves an even larger rest
+                if (rest > search.maxRemaining[childRemaining] ||
+                    exceedsCappedMax(search, i, childRemaining, rest)) {
+                    ++counters.prunes;
+                    counters.detail.boundPrune();
+                    i = valueCount;
+                    break;
+                }
+                if (rest < search.minRemaining[childRemaining]) {
+                    ++counters.prunes;
+                    counters.detail.boundPrune();
+                    continue;
+                }
+                // Exact check: only descend into subtrees that contain a solution
+                if (unreachable(search, childRemaining, rest)) {
+                    ++counters.prunes;
+                    counters.detail.reachabilityPrune();
+                    continue;
+                }
+            }
+            break;
+        }
+
+        if (i < valueCount) {
+            next[depth] = static_cast<uint32_t>(i + 1);
+            symbols[depth] = static_cast<SymbolId>(i);
+            ++depth;
+            entering = true;
+        } else if (depth == rootDepth) {
+            return true;
+        } else {
+            --depth;
+        }
+    }
+}
+
+/**
+ * @brief Iterative depth-first search below a fixed prefix
+ * @param search Search parameters
+ * @param stack Stack sized for search.length; symbols[0, depth) hold the prefix
+ * @param depth Length of the prefix
+ * @param currentSum Sum of the prefix
+ * @param counters Counters of the calling thread
+ * @param emit Called with each solution; returns false to stop the search
+ * @param stop Optional flag that aborts the search when set by another thread
+ * @param checkpoint Optional hook that snapshots the frontier
+ * @return True if should continue searching, false if the search was stopped
+ */
+template <typename Int, typename Emit>
+bool searchSubtree(const NativeSearch<Int>& search, SearchStack<Int>& stack, unsigned int depth,
+                   const Int& currentSum, SearchCounters& counters, Emit& emit,
+                   const std::atomic<bool>* stop, CheckpointHook* checkpoint = nullptr) {
+    stack.need[depth] = search.target - currentSum; // currentSum never exceeds the target
+    return runStack(search, stack, depth, depth, counters, emit, stop, checkpoint);
+}
+
+/**
+ * @brief Search one length, from the root or from a checkpointed node
+ * @param search Search parameters
+ * @param stack Stack sized for search.length
+ * @param resume Symbol path of the node to continue at, or nullptr to start at the root
+ * @param counters Counters of the calling thread
+ * @param emit Called with each solution; returns false to stop the search
+ * @param checkpoint Optional hook that snapshots the frontier
+ * @return True if should continue searching, false if the search was stopped
+ * @throws std::runtime_error if the path does not belong to this search
+ */
+template <typename Int, typename Emit>
+bool searchLength(const NativeSearch<Int>& search, SearchStack<Int>& stack,
+                  const std::vector<uint32_t>* resume, SearchCounters& counters, Emit& emit,
+                  CheckpointHook* checkpoint) {
+    if (!resume) {
+        return searchSubtree(search, stack, 0, Int(0), counters, emit, nullptr, checkpoint);
+    }
+
+    // Rebuild the frames of the path; next[d] always points past the symbol taken
+    unsigned int depth = static_cast<unsigned int>(resume->size());
+    stack.need[0] = search.target;
+    for (unsigned int d = 0; d < depth; ++d) {
+        uint32_t symbol = (*resume)[d];
+        if (symbol >= search.values.size() || search.values[symbol] > stack.need[d]) {
+            throw std::runtime_error("Checkpoint does not match this search");
+        }
+        stack.need[d + 1] = stack.need[d] - search.values[symbol];
+        stack.symbols[d] = static_cast<SymbolId>(symbol);
+        stack.next[d] = symbol + 1;
+    }
+    return runStack(search, stack, 0, depth, counters, emit, nullptr, checkpoint);
+}
+
+/**
+ * Per-search constants of a batch traversal
+ */
+template <typename Int>
+struct BatchSearch {
+    const std::vector<Int>& values;        // Sorted in descending order
+    const LookupTable& table;              // Spells out symbol ids (value order) as text
+    const std::vector<Int>& minRemaining;  // minRemaining[r] = minimum sum of r characters
+    const std::vector<Int>& maxRemaining;  // maxRemaining[r] = maximum sum of r characters
+    const std::vector<Int>& targets;       // Distinct targets in ascending order
+    unsigned int length;
+    SearchControl* control;                // Polled every SearchControl::pollInterval nodes, or nullptr
+};
+
+/**
+ * @brief Narrow [first, last) to the targets reachable with r more characters
+ * @return False if no target is left
+ */
+template <typename Int>
+bool narrowTargets(const BatchSearch<Int>& search, Int currentSum, unsigned int r,
+                   size_t& first, size_t& last) {
+    auto targets = search.targets.begin();
+    first = std::lower_bound(targets + first, targets + last,
+                             currentSum + search.minRemaining[r]) - targets;
+    last = std::upper_bound(targets + first, targets + last,
+                            currentSum + search.maxRemaining[r]) - targets;
+    return first != last;
+}
+
+/**
+ * @brief Backtracking below a prefix that answers a sorted set of targets at once
+ * @param search Search parameters
+ * @param path Symbol ids of the current partial password
+ * @param password Buffer the solutions are spelled out in
+ * @param currentSum Sum of the symbols in path
+ * @param first Start of the slice of targets this prefix can still reach
+ * @param last End of that slice (non-empty)
+ * @param counters Counters of the calling thread
+ * @param emit Called with the target's index in search.targets and each solution
+ * @return True if should continue searching, false if the search was stopped
+ */
+template <typename Int, typename Emit>
+bool searchBatchSubtree(const BatchSearch<Int>& search, std::vector<SymbolId>& path, std::string& password,
+                        Int currentSum, size_t first, size_t last, SearchCounters& counters, Emit& emit) {
+    ++counters.nodes;
+    counters.detail.node(static_cast<unsigned int>(path.size()));
+    if (search.control && (counters.nodes & SearchControl::pollMask) == 0) {
+        search.control->addNodes(SearchControl::pollInterval);
+        if (search.control->poll()) {
+            return false;
+        }
+    }
+
+    const std::vector<Int>& values = search.values;
+    const std::vector<Int>& targets = search.targets;
+    unsigned int remainingPositions = search.length - static_cast<unsigned int>(path.size());
+
+    // Last position: probe the smaller of the target slice and the value list
+    // against the other instead of trying every character
+    if (remainingPositions == 1) {
+        auto finish = [&](size_t target, size_t i) {
+            path.push_back(static_cast<SymbolId>(i));
+            search.table.spell(path.data(), path.size(), password);
+            path.pop_back();
+            return emit(target, password);
+        };
+
+        if (last - first <= values.size()) {
+            for (size_t t = first; t < last; ++t) {
+                auto range = std::equal_range(values.begin(), values.end(), targets[t] - currentSum,
+                                              std::greater<Int>());
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (!finish(t, it - values.begin())) {
+                        return false;
+                    }
+                }
+            }
+        } else {
+            for (size_t i = 0; i < values.size(); ++i) {
+                auto it = std::lower_bound(targets.begin() + first, targets.begin() + last,
+                                           currentSum + values[i]);
+                if (it != targets.begin() + last && *it == currentSum + values[i] &&
+                    !finish(it - targets.begin(), i)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Skip values that overshoot the largest target; once a value cannot reach
+    // the smallest target, no later (smaller) value can either
+    Int largestNeed = targets[last - 1] - currentSum - search.minRemaining[remainingPositions - 1];
+    Int smallestNeed = targets[first] - currentSum;
+    size_t start = std::lower_bound(values.begin(), values.end(), largestNeed,
+                                    std::greater<Int>()) - values.begin();
+
+    for (size_t i = start; i < values.size(); ++i) {
+        if (values[i] + search.maxRemaining[remainingPositions - 1] < smallestNeed) {
+            ++counters.prunes;
+            counters.detail.boundPrune();
+            break;
+        }
+
+        Int childSum = currentSum + values[i];
+        size_t childFirst = first;
+        size_t childLast = last;
+        if (!narrowTargets(search, childSum, remainingPositions - 1, childFirst, childLast)) {
+            ++counters.prunes;
+            counters.detail.boundPrune();
+            continue;
+        }
+
+        path.push_back(static_cast<SymbolId>(i));
+        bool keepGoing = searchBatchSubtree(search, path, password, childSum, childFirst, childLast,
+                                            counters, emit);
+        path.pop_back();
+        if (!keepGoing) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Per-length constants of a constrained search
+ */
+template <typename Int>
+struct ConstrainedSearch {
+    const std::vector<Int>& values;        // Sorted in descending order
+    const LookupTable& table;              // Spells out symbol ids (value order) as text
+    const PositionConstraints& positions;  // Allowed ids per position and required sets
+    std::vector<Int> minSuffix;            // minSuffix[p] = smallest sum positions p and later can add
+    std::vector<Int> maxSuffix;            // maxSuffix[p] = largest sum positions p and later can add
+    SearchControl* control;                // Polled every SearchControl::pollInterval nodes, or nullptr
+};
+
+/**
+ * @brief Backtracking over the symbols each position allows
+ * @param search Search parameters
+ * @param path Symbol ids of the current partial password
+ * @param password Buffer the solutions are spelled out in
+ * @param need Sum the remaining positions must add
+ * @param covered Required sets the path already contains
+ * @param counters Counters of the calling thread
+ * @param emit Called with each solution; returns false to stop the search
+ * @return True if should continue searching, false if the search was stopped
+ */
+template <typename Int, typename Emit>
+bool searchConstrainedSubtree(const ConstrainedSearch<Int>& search, std::vector<SymbolId>& path,
+                              std::string& password, const Int& need, uint32_t covered,
+                              SearchCounters& counters, Emit& emit) {
+    const unsigned int depth = static_cast<unsigned int>(path.size());
+    ++counters.nodes;
+    counters.detail.node(depth);
+    if (search.control && (counters.nodes & SearchControl::pollMask) == 0) {
+        search.control->addNodes(SearchControl::pollInterval);
+        if (search.control->poll()) {
+            return false;
+        }
+    }
+
+    const PositionConstraints& positions = search.positions;
+    const unsigned int length = static_cast<unsigned int>(positions.allowed.size());
+    uint32_t missing = positions.requirements & ~covered;
+    if (depth == length) {
+        if (need == 0 && missing == 0) {
+            search.table.spell(path.data(), length, password);
+            return emit(password);
+        }
+        return true;
+    }
+
+    // Every required set still missing needs a position of its own at worst
+    if (std::bitset<32>(missing).count() > length - depth) {
+        ++counters.prunes;
+        counters.detail.boundPrune();
+        return true;
+    }
+
+    // Allowed ids ascend, so values descend: skip the symbols that overshoot even
+    // with the smallest completion, and stop once the rest exceeds the largest
+    const std::vector<SymbolId>& allowed = positions.allowed[depth];
+    const std::vector<Int>& values = search.values;
+    const Int& restMin = search.minSuffix[depth + 1];
+    const Int& restMax = search.maxSuffix[depth + 1];
+    auto first = std::lower_bound(allowed.begin(), allowed.end(), need,
+                                  [&](SymbolId id, const Int& limit) { return values[id] + restMin > limit; });
+
+    for (auto it = first; it != allowed.end(); ++it) {
+        Int rest = need - values[*it];
+        if (rest > restMax) {
+            ++counters.prunes;
+            counters.detail.boundPrune();
+            break;
+        }
+
+        path.push_back(*it);
+        bool keepGoing = searchConstrainedSubtree(search, path, password, rest,
+                                                  covered | positions.requirementBits[*it], counters, emit);
+        path.pop_back();
+        if (!keepGoing) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * One prefix of a likelihood-ordered search, kept in an arena
+ */
+template <typename Int>
+struct LikelyNode {
+    Int sum;            // Sum of the prefix
+    size_t parent;      // Arena index of the prefix one symbol shorter (the root is its own)
+    SymbolId symbol;    // Last symbol of the prefix
+    unsigned int depth; // Symbols in the prefix
+};
+
+/**
+ * Pending entry of a likelihood-ordered search
+ */
+struct LikelyEntry {
+    double cost;        // Negative log-probability of the prefix, or of the password if complete
+    size_t node;        // Arena index of the prefix
+    bool complete;      // Popping it emits the prefix as a password
+
+    // std::push_heap keeps the largest element on top: make that the cheapest
+    bool operator<(const LikelyEntry& other) const { return cost > other.cost; }
+};
+
+/**
+ * @brief Drop the less probable half of the frontier and the arena nodes only it used
+ * @param frontier Heap of pending entries
+ * @param arena Prefix nodes; compacted in place, the root stays at index 0
+ * @param keep Entries to keep
+ */
+template <typename Int>
+void trimFrontier(std::vector<LikelyEntry>& frontier, std::vector<LikelyNode<Int>>& arena, size_t keep) {
+    std::nth_element(frontier.begin(), frontier.begin() + keep, frontier.end(),
+                     [](const LikelyEntry& a, const LikelyEntry& b) { return a.cost < b.cost; });
+    frontier.resize(keep);
+
+    // Keep the nodes on the path of every surviving entry, renumbered in arena order
+    std::vector<uint8_t> live(arena.size(), 0);
+    live[0] = 1;
+    for (const LikelyEntry& entry : frontier) {
+        for (size_t node = entry.node; !live[node]; node = arena[node].parent) {
+            live[node] = 1;
+        }
+    }
+    std::vector<size_t> remap(arena.size());
+    size_t next = 0;
+    for (size_t node = 0; node < arena.size(); ++node) {
+        if (live[node]) {
+            remap[node] = next;
+            if (next != node) {
+                arena[next] = std::move(arena[node]);
+            }
+            arena[next].parent = remap[arena[next].parent]; // Parents precede their children
+            ++next;
+        }
+    }
+    arena.resize(next);
+    for (LikelyEntry& entry : frontier) {
+        entry.node = remap[entry.node];
+    }
+    std::make_heap(frontier.begin(), frontier.end());
+}
+
+} // namespace
 
 BacktrackingStrategy::BacktrackingStrategy(bool enableOptimizations, size_t maxSolutions)
     : enableOptimizations(enableOptimizations), maxSolutions(maxSolutions), pruneCount(0) {
 }
 
-std::vector<std::string> BacktrackingStrategy::decrypt(
+bool BacktrackingStrategy::decrypt(
+    const mpz_class& targetSum,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const SolutionVisitor& visit) {
+
+    return runSearch(targetSum, table, minLength, maxLength, visit, multisetSearch, true);
+}
+
+std::string BacktrackingStrategy::getCacheTag() const {
+    // Pruning options only change the speed; the limit, the order and constraints change the output
+    if (candidateModel) {
+        return getName() + ";max=" + std::to_string(maxSolutions) + ";order=likelihood:" +
+               candidateModel->getTag() + ";frontier=" + std::to_string(frontierLimit);
+    }
+    if (!constraints.empty()) {
+        return getName() + ";max=" + std::to_string(maxSolutions) + ";order=depth-first;constraints=" +
+               constraints.describe();
+    }
+    std::string order = multisetSearch ? "multiset" : threadCount != 1 ? "parallel" : "depth-first";
+    return getName() + ";max=" + std::to_string(maxSolutions) + ";order=" + order;
+}
+
+bool BacktrackingStrategy::decryptMultisets(
+    const mpz_class& targetSum,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const MultisetVisitor& visit) {
+
+    SolutionVisitor report = [&](const std::string& multiset) {
+        return visit(multiset, permutationCount(multiset));
+    };
+    return runSearch(targetSum, table, minLength, maxLength, report, true, false);
+}
+
+mpz_class BacktrackingStrategy::countSolutions(
     const mpz_class& targetSum,
-    const std::unordered_map<char, mpz_class>& charToPartition,
+    const LookupTable& table,
     unsigned int minLength,
     unsigned int maxLength) {
-    
+
+    mpz_class total = 0;
+    decryptMultisets(targetSum, table, minLength, maxLength,
+                     [&](const std::string&, const mpz_class& permutations) {
+        total += permutations;
+        return true;
+    });
+    return total;
+}
+
+bool BacktrackingStrategy::resume(
+    const std::string& path,
+    const LookupTable& table,
+    const SolutionVisitor& visit) {
+
+    SearchCheckpoint checkpoint = SearchCheckpoint::load(path);
+    if (checkpoint.tableFingerprint != SearchCheckpoint::fingerprint(table)) {
+        throw std::invalid_argument("Checkpoint was written for a different lookup table");
+    }
+
+    resumeFrom = &checkpoint;
+    bool completed;
+    try {
+        completed = runSearch(checkpoint.target, table, checkpoint.minLength, checkpoint.maxLength,
+                              visit, checkpoint.multiset, true);
+    } catch (...) {
+        resumeFrom = nullptr;
+        throw;
+    }
+    resumeFrom = nullptr;
+    return completed;
+}
+
+void BacktrackingStrategy::saveCheckpoint(
+    unsigned int length,
+    unsigned int depth,
+    const SymbolId* symbols,
+    size_t nodes,
+    size_t prunes,
+    bool complete) {
+
+    checkpointState.length = length;
+    checkpointState.symbols.assign(symbols, symbols + depth);
+    checkpointState.nodes = nodes;
+    checkpointState.prunes = prunes;
+    checkpointState.solutions = solutionsFound;
+    checkpointState.complete = complete;
+    checkpointState.save(checkpointPath);
+}
+
+bool BacktrackingStrategy::runSearch(
+    const mpz_class& targetSum,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const SolutionVisitor& visit,
+    bool canonical,
+    bool expand) {
+
     auto startTime = std::chrono::high_resolution_clock::now();
-    std::vector<std::string> results;
     combinationsChecked = 0;
     pruneCount = 0;
-    
-    if (charToPartition.empty()) {
-        return results;
-    }
-    
-    // Calculate bounds for pruning
-    calculateBounds(charToPartition, minPartitionVal, maxPartitionVal);
-    
-    // Create sorted character list for optimization
-    auto sortedChars = createSortedCharacters(charToPartition);
-    
-    // Try each possible password length
-    for (unsigned int length = minLength; length <= maxLength; ++length) {
-        mpz_class maxPossibleSum = maxPartitionVal * length;
-        mpz_class minPossibleSum = minPartitionVal * length;
-        
-        // Early pruning: check if target is achievable with this length
-        if (targetSum > maxPossibleSum || targetSum < minPossibleSum) {
-            continue;
+    solutionsFound = 0;
+    memoryUsed = 0;
+    metrics.reset(getName());
+
+    if (table.empty() || targetSum < 0) {
+        return true;
+    }
+    if (!constraints.empty() && (canonical || resumeFrom)) {
+        throw std::invalid_argument("Constraints cannot be combined with multiset search or resume");
+    }
+    // Multiset reports and counts have no order to rank, so only decrypt() uses the model
+    const bool likely = candidateModel && expand;
+    if (likely && (canonical || resumeFrom || !constraints.empty())) {
+        throw std::invalid_argument(
+            "A candidate model cannot be combined with multiset search, constraints or resume");
+    }
+
+    // A resumed search continues the counters of the interrupted one
+    if (resumeFrom) {
+        combinationsChecked = resumeFrom->nodes;
+        pruneCount = resumeFrom->prunes;
+        solutionsFound = resumeFrom->solutions;
+    }
+
+    // Checkpoints cover decrypt(); multiset reports have no resume entry point,
+    // constrained searches are short, and a batch must not overwrite the snapshot
+    // of an earlier decrypt() with its per-target searches
+    checkpointing = expand && !checkpointPath.empty() && constraints.empty() && !likely && !batchRunning;
+    if (checkpointing) {
+        checkpointState = SearchCheckpoint();
+        checkpointState.target = targetSum;
+        checkpointState.minLength = minLength;
+        checkpointState.maxLength = maxLength;
+        checkpointState.tableFingerprint = SearchCheckpoint::fingerprint(table);
+        checkpointState.multiset = canonical;
+    }
+
+    // Every kernel reports through this one sink, which also enforces maxSolutions
+    bool visitorStopped = false;
+    SolutionVisitor emit = [&](const std::string& solution) {
+        if (!visit(solution)) {
+            visitorStopped = true;
+            return false;
+        }
+        ++solutionsFound;
+        return !(maxSolutions > 0 && solutionsFound >= maxSolutions);
+    };
+
+    // Canonical searches hand each multiset over as is or as its distinct orderings
+    canonicalSearch = canonical;
+    SolutionVisitor expandOrderings = [&](const std::string& multiset) {
+        return forEachPermutation(multiset, emit);
+    };
+    const SolutionVisitor& kernelEmit = canonical && expand ? expandOrderings : emit;
+
+    // Bounds are precomputed by the lookup table
+    minPartitionVal = table.getMinValue();
+    maxPartitionVal = table.getMaxValue();
+
+    // Nothing is left of a search that had already finished
+    bool finished = resumeFrom &&
+                    (resumeFrom->complete || (maxSolutions > 0 && solutionsFound >= maxSolutions));
+
+    // Likelihood-ordered searches rank prefixes by the model instead of descending depth-first
+    if (likely) {
+        if (targetSum <= maxPartitionVal * maxLength) {
+            switch (table.widthFor(maxLength)) {
+                case ValueWidth::Native64:
+                    decryptLikely<uint64_t>(table.getNativeValues<uint64_t>(), toNative<uint64_t>(targetSum),
+                                            table, minLength, maxLength, emit);
+                    break;
+#ifdef PARTITION_HAVE_INT128
+                case ValueWidth::Native128:
+                    decryptLikely<uint128_t>(table.getNativeValues<uint128_t>(), toNative<uint128_t>(targetSum),
+                                             table, minLength, maxLength, emit);
+                    break;
+#endif
+                default:
+                    decryptLikely<mpz_class>(table.getSortedValues(), targetSum, table, minLength, maxLength, emit);
+                    break;
+            }
         }
-        
-        // Calculate remaining sum potential
-        mpz_class remainingSum = calculateRemainingSum(targetSum, 0, length, maxPartitionVal);
-        
-        // Start backtracking
-        if (!backtrackRecursive("", 0, targetSum, remainingSum, length, length, 
-                                charToPartition, sortedChars, results)) {
-            break; // Max solutions reached
+    } else if (!constraints.empty()) {
+        // Constrained searches only enumerate the symbols each position allows
+        if (targetSum <= maxPartitionVal * maxLength) {
+            switch (table.widthFor(maxLength)) {
+                case ValueWidth::Native64:
+                    decryptConstrained<uint64_t>(table.getNativeValues<uint64_t>(), toNative<uint64_t>(targetSum),
+                                                 table, minLength, maxLength, kernelEmit);
+                    break;
+#ifdef PARTITION_HAVE_INT128
+                case ValueWidth::Native128:
+                    decryptConstrained<uint128_t>(table.getNativeValues<uint128_t>(),
+                                                  toNative<uint128_t>(targetSum), table, minLength, maxLength,
+                                                  kernelEmit);
+                    break;
+#endif
+                default:
+                    decryptConstrained<mpz_class>(table.getSortedValues(), targetSum, table, minLength, maxLength,
+                                                  kernelEmit);
+                    break;
+            }
+        }
+    } else if (!finished) {
+        // Pick the narrowest arithmetic able to represent every sum of this search
+        switch (table.widthFor(maxLength)) {
+            case ValueWidth::Native64:
+                decryptNative<uint64_t>(targetSum, table, minLength, maxLength, kernelEmit);
+                break;
+#ifdef PARTITION_HAVE_INT128
+            case ValueWidth::Native128:
+                decryptNative<uint128_t>(targetSum, table, minLength, maxLength, kernelEmit);
+                break;
+#endif
+            default:
+                searchArbitrary(targetSum, table, minLength, maxLength, kernelEmit);
+                break;
         }
     }
-    
+
+    // A search the visitor or the control stopped keeps its last snapshot so it can be resumed
+    bool interrupted = visitorStopped || stopRequested();
+    if (checkpointing && !interrupted) {
+        saveCheckpoint(maxLength, 0, nullptr, combinationsChecked, pruneCount, true);
+    }
+
     auto endTime = std::chrono::high_resolution_clock::now();
     duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
-    
-    // Estimate memory usage (rough approximation)
-    memoryUsed = results.size() * 50 + sortedChars.size() * 20; // bytes
-    
-    return results;
+
+    metrics.solutions = solutionsFound;
+    finishMetrics();
+
+    return !interrupted;
 }
 
-bool BacktrackingStrategy::backtrackRecursive(
-    const std::string& currentPassword,
-    const mpz_class& currentSum,
+template <typename Int>
+void BacktrackingStrategy::decryptNative(
     const mpz_class& targetSum,
-    const mpz_class& remainingSum,
+    const LookupTable& table,
     unsigned int minLength,
     unsigned int maxLength,
-    const std::unordered_map<char, mpz_class>& charToPartition,
-    const std::vector<std::pair<char, mpz_class>>& sortedChars,
-    std::vector<std::string>& results) {
-    
-    ++combinationsChecked;
-    
-    // Base case: we've reached the desired length
-    if (currentPassword.length() == minLength) {
-        if (currentSum == targetSum) {
-            results.push_back(currentPassword);
-            
-            // Check if we've reached max solutions
-            if (maxSolutions > 0 && results.size() >= maxSolutions) {
-                return false;
+    const SolutionVisitor& emit,
+    bool recordLengths) {
+
+    // A target above every reachable sum has no solutions (and may not fit in Int)
+    if (targetSum > maxPartitionVal * maxLength) {
+        return;
+    }
+
+    const std::vector<Int>& values = table.getNativeValues<Int>();
+    const Int target = toNative<Int>(targetSum);
+    const Int minVal = values.back();
+    const Int maxVal = values.front();
+
+    // Bounds for r remaining characters, indexed by r
+    std::vector<Int> minRemaining(maxLength + 1);
+    std::vector<Int> maxRemaining(maxLength + 1);
+    for (unsigned int r = 0; r <= maxLength; ++r) {
+        minRemaining[r] = minVal * r;
+        maxRemaining[r] = maxVal * r;
+    }
+
+    // Exact reachability replaces bounds pruning when the table is small enough
+    const ReachabilityIndex* reach = nullptr;
+    if (std::is_same<Int, uint64_t>::value) {
+        reach = prepareReachability(table, maxLength);
+    }
+
+    const PairSumTable* pairs = nullptr;
+    if (std::is_same<Int, uint64_t>::value && usePairLookupTail) {
+        const std::vector<uint64_t>& values64 = table.getNativeValues<uint64_t>();
+        if (!pairTable || !pairTable->covers(values64)) {
+            pairTable = PairSumTable::build(values64);
+        }
+        pairs = pairTable.get();
+    }
+
+    if (threadCount != 1 && !checkpointing && (!pool || (threadCount != 0 && pool->size() != threadCount))) {
+        pool = std::make_shared<WorkStealingPool>(threadCount);
+    }
+
+    SearchStack<Int> stack;
+    stack.prepare(maxLength, target);
+    SearchCounters counters;
+
+    // Everything this search allocates besides the per-worker state
+    size_t searchBytes = (reach ? reach->getMemoryBytes() : 0) +
+                         (pairs ? pairs->getMemoryBytes() : 0) +
+                         2 * minRemaining.capacity() * sizeof(Int) + stack.memoryBytes();
+    parallelBytes = 0;
+
+    // Checkpointed searches run sequentially so their frontier is a single path
+    unsigned int currentLength = 0;
+    CheckpointHook hook{checkpointInterval, std::chrono::steady_clock::now(),
+                        canonicalSearch ? 0 : CheckpointHook::defaultPollMask,
+                        [&](unsigned int depth, const SymbolId* symbols, const SearchCounters& c) {
+        saveCheckpoint(currentLength, depth, symbols, combinationsChecked + c.nodes,
+                       pruneCount + c.prunes, false);
+    }};
+    CheckpointHook* checkpoint = checkpointing ? &hook : nullptr;
+    bool parallel = threadCount != 1 && !checkpoint;
+
+    for (unsigned int length = resumeFrom ? resumeFrom->length : minLength; length <= maxLength; ++length) {
+        // Early pruning: check if target is achievable with this length
+        if (target > maxRemaining[length] || target < minRemaining[length]) {
+            continue;
+        }
+        if (reach && !reach->reachable(length, static_cast<uint64_t>(target))) {
+            ++pruneCount;
+            counters.detail.reachabilityPrune();
+            continue;
+        }
+
+        NativeSearch<Int> search{values, table, minRemaining, maxRemaining,
+                                 reach, pairs, target, length, enableOptimizations, canonicalSearch,
+                                 control};
+
+        auto lengthStart = std::chrono::high_resolution_clock::now();
+        size_t nodesBefore = combinationsChecked + counters.nodes;
+        size_t solutionsBefore = solutionsFound;
+        const std::vector<uint32_t>* resume =
+            resumeFrom && length == resumeFrom->length ? &resumeFrom->symbols : nullptr;
+        currentLength = length;
+        bool keepGoing;
+        if (parallel && !resume) {
+            keepGoing = searchParallel(search, emit);
+        } else {
+            keepGoing = searchLength(search, stack, resume, counters, emit, checkpoint);
+        }
+        if (recordLengths) {
+            recordLength(length, lengthStart, combinationsChecked + counters.nodes - nodesBefore,
+                         solutionsFound - solutionsBefore);
+        }
+
+        if (!keepGoing) {
+            break; // Max solutions reached or visitor stopped
+        }
+    }
+
+    combinationsChecked += counters.nodes;
+    pruneCount += counters.prunes;
+    counters.detail.addTo(metrics);
+    memoryUsed = std::max(memoryUsed, searchBytes + parallelBytes);
+}
+
+template <typename Int>
+void BacktrackingStrategy::decryptConstrained(
+    const std::vector<Int>& values,
+    const Int& target,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const SolutionVisitor& emit) {
+
+    SearchCounters counters;
+    std::vector<SymbolId> path;
+    path.reserve(maxLength);
+    std::string password;
+    PositionConstraints positions;
+    size_t constraintBytes = 0;
+
+    for (unsigned int length = minLength; length <= maxLength; ++length) {
+        if (!constraints.resolve(table, length, positions)) {
+            continue;
+        }
+
+        // Bounds of every suffix, from the smallest and largest value each position allows
+        ConstrainedSearch<Int> search{values, table, positions, std::vector<Int>(length + 1, Int(0)),
+                                      std::vector<Int>(length + 1, Int(0)), control};
+        size_t allowedCount = 0;
+        for (unsigned int p = length; p-- > 0;) {
+            search.minSuffix[p] = search.minSuffix[p + 1] + values[positions.allowed[p].back()];
+            search.maxSuffix[p] = search.maxSuffix[p + 1] + values[positions.allowed[p].front()];
+            allowedCount += positions.allowed[p].size();
+        }
+        constraintBytes = std::max(constraintBytes, allowedCount * sizeof(SymbolId) +
+                                   positions.requirementBits.size() * sizeof(uint32_t) +
+                                   2 * (length + 1) * sizeof(Int));
+        if (target < search.minSuffix[0] || target > search.maxSuffix[0]) {
+            continue;
+        }
+
+        auto lengthStart = std::chrono::high_resolution_clock::now();
+        size_t nodesBefore = counters.nodes;
+        size_t solutionsBefore = solutionsFound;
+        bool keepGoing = searchConstrainedSubtree(search, path, password, target, 0, counters, emit);
+        recordLength(length, lengthStart, counters.nodes - nodesBefore, solutionsFound - solutionsBefore);
+        if (!keepGoing) {
+            break; // Max solutions reached or visitor stopped
+        }
+    }
+
+    combinationsChecked += counters.nodes;
+    pruneCount += counters.prunes;
+    counters.detail.addTo(metrics);
+    memoryUsed = std::max(memoryUsed, constraintBytes + path.capacity() * sizeof(SymbolId) + password.capacity());
+}
+
+template <typename Int>
+void BacktrackingStrategy::decryptLikely(
+    const std::vector<Int>& values,
+    const Int& target,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const SolutionVisitor& emit) {
+
+    SearchCounters counters;
+    const CandidateModel& model = *candidateModel;
+    const std::vector<std::string>& symbols = table.getSymbols();
+
+    // minRest[r] / maxRest[r] = smallest / largest sum of r more symbols
+    std::vector<Int> minRest(maxLength + 1, Int(0));
+    std::vector<Int> maxRest(maxLength + 1, Int(0));
+    for (unsigned int r = 1; r <= maxLength; ++r) {
+        minRest[r] = minRest[r - 1] + values.back();
+        maxRest[r] = maxRest[r - 1] + values.front();
+    }
+    // Whether some allowed length can complete a prefix of this depth and sum
+    auto reachable = [&](unsigned int depth, const Int& sum) {
+        if (sum > target) {
+            return false;
+        }
+        Int rest = target - sum;
+        for (unsigned int length = std::max(minLength, depth); length <= maxLength; ++length) {
+            if (rest >= minRest[length - depth] && rest <= maxRest[length - depth]) {
+                return true;
             }
         }
+        return false;
+    };
+
+    std::vector<LikelyNode<Int>> arena;
+    std::vector<LikelyEntry> frontier;
+    std::vector<SymbolId> path;
+    std::vector<std::string> history;
+    std::vector<double> scores;
+    std::string password;
+    size_t peakBytes = 0;
+    size_t steps = 0;
+
+    arena.push_back({Int(0), 0, 0, 0});
+    if (reachable(0, Int(0))) {
+        frontier.push_back({0.0, 0, false});
+    }
+
+    while (!frontier.empty()) {
+        if ((++steps & SearchControl::pollMask) == 0 && pollControl(SearchControl::pollInterval)) {
+            break;
+        }
+
+        std::pop_heap(frontier.begin(), frontier.end());
+        LikelyEntry entry = frontier.back();
+        frontier.pop_back();
+
+        // Spell the prefix out from the arena
+        const unsigned int depth = arena[entry.node].depth;
+        path.resize(depth);
+        for (size_t node = entry.node; node != 0; node = arena[node].parent) {
+            path[arena[node].depth - 1] = arena[node].symbol;
+        }
+        if (entry.complete) {
+            table.spell(path.data(), depth, password);
+            if (!emit(password)) {
+                break; // Max solutions reached or visitor stopped
+            }
+            continue;
+        }
+
+        ++counters.nodes;
+        counters.detail.node(depth);
+        history.resize(depth);
+        for (unsigned int k = 0; k < depth; ++k) {
+            history[k] = symbols[path[k]];
+        }
+
+        const Int sum = arena[entry.node].sum;
+        if (sum == target && depth >= minLength) {
+            frontier.push_back({entry.cost - model.endLogProbability(history), entry.node, true});
+            std::push_heap(frontier.begin(), frontier.end());
+        }
+        if (depth == maxLength) {
+            continue;
+        }
+
+        model.nextLogProbabilities(history, symbols, scores);
+        for (size_t id = 0; id < symbols.size(); ++id) {
+            Int childSum = sum + values[id];
+            if (!reachable(depth + 1, childSum)) {
+                ++counters.prunes;
+                counters.detail.boundPrune();
+                continue;
+            }
+            arena.push_back({childSum, entry.node, static_cast<SymbolId>(id), depth + 1});
+            frontier.push_back({entry.cost - scores[id], arena.size() - 1, false});
+            std::push_heap(frontier.begin(), frontier.end());
+        }
+
+        if (frontierLimit > 0 && frontier.size() > frontierLimit) {
+            peakBytes = std::max(peakBytes, arena.capacity() * sizeof(LikelyNode<Int>) +
+                                            frontier.capacity() * sizeof(LikelyEntry));
+            size_t keep = std::max<size_t>(frontierLimit / 2, 1);
+            counters.prunes += frontier.size() - keep;
+            trimFrontier(frontier, arena, keep);
+        }
+    }
+
+    peakBytes = std::max(peakBytes, arena.capacity() * sizeof(LikelyNode<Int>) +
+                                    frontier.capacity() * sizeof(LikelyEntry));
+    combinationsChecked += counters.nodes;
+    pruneCount += counters.prunes;
+    counters.detail.addTo(metrics);
+    memoryUsed = std::max(memoryUsed, peakBytes);
+}
+
+const ReachabilityIndex* BacktrackingStrategy::prepareReachability(
+    const LookupTable& table,
+    unsigned int maxLength) {
+
+    if (!enableOptimizations || !useReachabilityIndex) {
+        return nullptr;
+    }
+
+    const std::vector<uint64_t>& values = table.getNativeValues<uint64_t>();
+    if (!reachability || !reachability->covers(values, maxLength)) {
+        // Build for the table's full length range so later calls can reuse it
+        reachability = ReachabilityIndex::build(
+            values, std::max(maxLength, table.getMaxLength()), reachabilityMemoryLimit);
+    }
+    return reachability.get();
+}
+
+bool BacktrackingStrategy::decryptBatch(
+    const std::vector<mpz_class>& targetSums,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const BatchSolutionVisitor& visit) {
+
+    // Flags left by an earlier decrypt() or resume() must not reach the batch kernels
+    checkpointing = false;
+    resumeFrom = nullptr;
+    batchRunning = true;
+    bool completed;
+    try {
+        completed = runBatch(targetSums, table, minLength, maxLength, visit);
+    } catch (...) {
+        batchRunning = false;
+        throw;
+    }
+    batchRunning = false;
+    return completed;
+}
+
+bool BacktrackingStrategy::runBatch(
+    const std::vector<mpz_class>& targetSums,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const BatchSolutionVisitor& visit) {
+
+    if (table.empty()) {
         return true;
     }
-    
-    // Pruning: check if current path is viable
-    unsigned int remainingPositions = minLength - currentPassword.length();
-    if (enableOptimizations && !isViablePath(currentSum, targetSum, remainingPositions,
-                                           minPartitionVal, maxPartitionVal,
-                                           currentPassword.length(), minLength, maxLength)) {
-        ++pruneCount;
+
+    // Multiset, constrained and likelihood-ordered searches run per target through decrypt()
+    if (multisetSearch || !constraints.empty() || candidateModel) {
+        return DecryptionStrategy::decryptBatch(targetSums, table, minLength, maxLength, visit);
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    bool completed = true;
+    combinationsChecked = 0;
+    pruneCount = 0;
+    solutionsFound = 0;
+    memoryUsed = 0;
+    metrics.reset(getName());
+    canonicalSearch = false;
+
+    minPartitionVal = table.getMinValue();
+    maxPartitionVal = table.getMaxValue();
+
+    switch (table.widthFor(maxLength)) {
+        case ValueWidth::Native64:
+            completed = decryptBatchNative<uint64_t>(targetSums, table, minLength, maxLength, visit);
+            break;
+#ifdef PARTITION_HAVE_INT128
+        case ValueWidth::Native128:
+            completed = decryptBatchNative<uint128_t>(targetSums, table, minLength, maxLength, visit);
+            break;
+#endif
+        default:
+            // GMP sums: one target at a time
+            return DecryptionStrategy::decryptBatch(targetSums, table, minLength, maxLength, visit);
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+
+    metrics.solutions = solutionsFound;
+    finishMetrics();
+
+    return completed;
+}
+
+template <typename Int>
+bool BacktrackingStrategy::decryptBatchNative(
+    const std::vector<mpz_class>& targetSums,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const BatchSolutionVisitor& visit) {
+
+    const mpz_class maxReachable = maxPartitionVal * maxLength;
+
+    // Distinct targets in ascending order; requests[ownerBegin[t]..ownerBegin[t + 1])
+    // are the batch indices asking for targets[t]
+    std::vector<std::pair<Int, size_t>> requests;
+    requests.reserve(targetSums.size());
+    for (size_t i = 0; i < targetSums.size(); ++i) {
+        if (targetSums[i] >= 0 && targetSums[i] <= maxReachable) {
+            requests.emplace_back(toNative<Int>(targetSums[i]), i);
+        }
+    }
+    if (requests.empty()) {
         return true;
     }
-    
-    // Try each character
-    for (const auto& [character, partitionValue] : sortedChars) {
-        mpz_class newSum = currentSum + partitionValue;
-        
-        // Early pruning: if adding this character makes sum too large
-        if (newSum > targetSum) {
-            // Since characters are sorted by partition value (descending),
-            // all remaining characters will also make the sum too large
-            if (enableOptimizations) {
-                break;
+    std::sort(requests.begin(), requests.end());
+
+    std::vector<Int> targets;
+    std::vector<size_t> ownerBegin;
+    for (size_t k = 0; k < requests.size(); ++k) {
+        if (k == 0 || requests[k].first != requests[k - 1].first) {
+            targets.push_back(requests[k].first);
+            ownerBegin.push_back(k);
+        }
+    }
+    ownerBegin.push_back(requests.size());
+    size_t batchBytes = requests.capacity() * sizeof(requests[0]) +
+                        targets.capacity() * sizeof(Int) + ownerBegin.capacity() * sizeof(size_t);
+
+    const std::vector<Int>& values = table.getNativeValues<Int>();
+    std::vector<Int> minRemaining(maxLength + 1);
+    std::vector<Int> maxRemaining(maxLength + 1);
+    for (unsigned int r = 0; r <= maxLength; ++r) {
+        minRemaining[r] = values.back() * r;
+        maxRemaining[r] = values.front() * r;
+    }
+
+    // maxSolutions applies to every target on its own; duplicates of a target
+    // receive the same candidates
+    bool visitorStopped = false;
+    auto forward = [&](size_t target, const std::string& solution) {
+        for (size_t k = ownerBegin[target]; k < ownerBegin[target + 1]; ++k) {
+            if (!visit(requests[k].second, solution)) {
+                visitorStopped = true;
+                return false;
             }
-            continue;
         }
-        
-        // Advanced pruning: check if remaining positions can reach target
-        if (enableOptimizations) {
-            unsigned int remainingAfterThis = remainingPositions - 1;
-            mpz_class sumNeeded = targetSum - newSum;
-            mpz_class maxRemaining = maxPartitionVal * remainingAfterThis;
-            mpz_class minRemaining = minPartitionVal * remainingAfterThis;
-            
-            if (sumNeeded > maxRemaining || sumNeeded < minRemaining) {
-                ++pruneCount;
-                continue;
+        return true;
+    };
+
+    // With exact pruning a search costs about as much as its output, so sharing a
+    // traversal cannot save anything: answer each target on its own, reusing the
+    // cached index and bounds. Lengths run in the outer loop so metrics and
+    // progress cover every target of a length before it counts as finished.
+    if (std::is_same<Int, uint64_t>::value && prepareReachability(table, maxLength)) {
+        std::vector<size_t> found(targets.size(), 0);
+        size_t totalFound = 0;
+        for (unsigned int length = minLength; length <= maxLength; ++length) {
+            auto lengthStart = std::chrono::high_resolution_clock::now();
+            size_t nodesBefore = combinationsChecked;
+            size_t foundBefore = totalFound;
+            for (size_t target = 0; target < targets.size() && !visitorStopped && !stopRequested(); ++target) {
+                if (maxSolutions > 0 && found[target] >= maxSolutions) {
+                    continue;
+                }
+                // solutionsFound holds this target's count, which the parallel quota reads
+                solutionsFound = found[target];
+                SolutionVisitor emit = [&](const std::string& solution) {
+                    if (!forward(target, solution)) {
+                        return false;
+                    }
+                    ++solutionsFound;
+                    return !(maxSolutions > 0 && solutionsFound >= maxSolutions);
+                };
+                decryptNative<Int>(targetSums[requests[ownerBegin[target]].second], table,
+                                   length, length, emit, false);
+                totalFound += solutionsFound - found[target];
+                found[target] = solutionsFound;
+            }
+            // Lengths no target could reach visited nothing, as in a single search
+            if (combinationsChecked > nodesBefore) {
+                recordLength(length, lengthStart, combinationsChecked - nodesBefore, totalFound - foundBefore);
             }
+            if (visitorStopped || stopRequested()) {
+                break;
+            }
+        }
+        solutionsFound = totalFound;
+        memoryUsed += batchBytes + found.capacity() * sizeof(size_t);
+        return !visitorStopped && !stopRequested();
+    }
+
+    // Bounds-only pruning: one traversal per length answers every target
+    std::vector<size_t> found(targets.size(), 0);
+    size_t saturated = 0;
+    auto emit = [&](size_t target, const std::string& solution) {
+        if (maxSolutions > 0 && found[target] >= maxSolutions) {
+            return true;
+        }
+        if (!forward(target, solution)) {
+            return false;
+        }
+        ++solutionsFound;
+        if (++found[target] == maxSolutions) {
+            ++saturated;
+        }
+        return !(maxSolutions > 0 && saturated == targets.size());
+    };
+
+    std::vector<SymbolId> path;
+    path.reserve(maxLength);
+    std::string password;
+    SearchCounters counters;
+    memoryUsed = batchBytes + found.capacity() * sizeof(size_t) +
+                 2 * minRemaining.capacity() * sizeof(Int) + path.capacity() * sizeof(SymbolId);
+
+    for (unsigned int length = minLength; length <= maxLength; ++length) {
+        BatchSearch<Int> search{values, table, minRemaining, maxRemaining,
+                                targets, length, control};
+
+        size_t first = 0;
+        size_t last = targets.size();
+        if (!narrowTargets(search, Int(0), length, first, last)) {
+            continue;
         }
-        
-        // Recursive call
-        mpz_class newRemainingSum = calculateRemainingSum(targetSum, newSum, 
-                                                         remainingPositions - 1, maxPartitionVal);
-        
-        if (!backtrackRecursive(currentPassword + character, newSum, targetSum,
-                               newRemainingSum, minLength, maxLength, charToPartition,
-                               sortedChars, results)) {
-            return false; // Max solutions reached
+
+        auto lengthStart = std::chrono::high_resolution_clock::now();
+        size_t nodesBefore = counters.nodes;
+        size_t solutionsBefore = solutionsFound;
+        path.clear();
+        bool keepGoing = searchBatchSubtree(search, path, password, Int(0), first, last, counters, emit);
+        recordLength(length, lengthStart, counters.nodes - nodesBefore,
+                     solutionsFound - solutionsBefore);
+        if (!keepGoing) {
+            break; // Every target saturated or visitor stopped
         }
     }
-    
-    return true;
+
+    combinationsChecked += counters.nodes;
+    pruneCount += counters.prunes;
+    counters.detail.addTo(metrics);
+
+    return !visitorStopped && !stopRequested();
 }
 
-void BacktrackingStrategy::calculateBounds(
-    const std::unordered_map<char, mpz_class>& charToPartition,
-    mpz_class& minVal,
-    mpz_class& maxVal) {
-    
-    if (charToPartition.empty()) {
-        minVal = 0;
-        maxVal = 0;
-        return;
+template <typename Int>
+bool BacktrackingStrategy::searchParallel(
+    const NativeSearch<Int>& search,
+    const SolutionVisitor& emit) {
+
+    // Per-worker state on separate cache lines: counters, unsent solutions, DFS stack
+    struct alignas(64) WorkerState {
+        SearchCounters counters;
+        std::vector<std::string> pending;
+        SearchStack<Int> stack;
+    };
+
+    // Solutions are handed over in batches so workers rarely contend for the lock
+    const size_t flushBatch = 256;
+
+    const size_t quota = maxSolutions > 0 ? maxSolutions - solutionsFound : 0;
+    std::vector<WorkerState> states(pool->size());
+    for (WorkerState& state : states) {
+        state.stack.prepare(search.length, search.target);
     }
-    
-    auto it = charToPartition.begin();
-    minVal = maxVal = it->second;
-    
-    for (const auto& [character, partitionValue] : charToPartition) {
-        if (partitionValue < minVal) {
-            minVal = partitionValue;
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> tickets{0};
+    std::mutex emitMutex;
+    bool stopped = false; // Guarded by emitMutex
+
+    // Serialises visitor calls; returns false once the search has to stop
+    auto flush = [&](WorkerState& state) {
+        std::lock_guard<std::mutex> lock(emitMutex);
+        for (const std::string& solution : state.pending) {
+            if (stopped) {
+                break;
+            }
+            bool keepGoing;
+            try {
+                keepGoing = emit(solution);
+            } catch (...) {
+                // The pool rethrows from wait(); the other workers stop early
+                stopped = true;
+                stop.store(true, std::memory_order_relaxed);
+                throw;
+            }
+            if (!keepGoing) {
+                stopped = true;
+                stop.store(true, std::memory_order_relaxed);
+            }
         }
-        if (partitionValue > maxVal) {
-            maxVal = partitionValue;
+        state.pending.clear();
+        return !stopped;
+    };
+
+    // Split until there are enough subtrees to keep every worker busy
+    unsigned int splitDepth = 0;
+    for (size_t subtrees = 1; subtrees < size_t(16) * pool->size() && splitDepth < search.length;
+         subtrees *= search.values.size()) {
+        ++splitDepth;
+    }
+
+    // An atomic ticket makes maxSolutions an exact global cutoff; solutions are
+    // buffered per worker and reach the visitor through the mutex-serialised flush
+    auto emitFrom = [&](unsigned int worker) {
+        return [&, worker](const std::string& solution) {
+            WorkerState& state = states[worker];
+            size_t ticket = quota > 0 ? tickets.fetch_add(1, std::memory_order_relaxed) : 0;
+            if (quota > 0 && ticket >= quota) {
+                stop.store(true, std::memory_order_relaxed);
+                return false;
+            }
+
+            state.pending.push_back(solution);
+            if (state.pending.size() >= flushBatch && !flush(state)) {
+                return false;
+            }
+
+            if (quota > 0 && ticket + 1 >= quota) {
+                stop.store(true, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        };
+    };
+
+    // Prefixes (symbol indices) shorter than splitDepth fan out into tasks;
+    // longer ones run the kernel
+    std::function<void(unsigned int, const std::vector<SymbolId>&, Int)> expand;
+    expand = [&](unsigned int worker, const std::vector<SymbolId>& prefix, Int currentSum) {
+        if (stop.load(std::memory_order_relaxed) || stopRequested()) {
+            return;
+        }
+
+        WorkerState& state = states[worker];
+        unsigned int depth = static_cast<unsigned int>(prefix.size());
+        if (depth >= splitDepth) {
+            auto emit = emitFrom(worker);
+            std::copy(prefix.begin(), prefix.end(), state.stack.symbols.begin());
+            searchSubtree(search, state.stack, depth, currentSum, state.counters, emit, &stop);
+            flush(state);
+            return;
         }
+
+        ++state.counters.nodes;
+        state.counters.detail.node(depth);
+        Int sumNeeded = search.target - currentSum;
+
+        size_t from = search.multiset && depth > 0 ? prefix.back() : 0;
+        forEachViableChild(search, sumNeeded, search.length - depth, from, state.counters, [&](size_t i) {
+            std::vector<SymbolId> child = prefix;
+            child.push_back(static_cast<SymbolId>(i));
+            Int childSum = currentSum + search.values[i];
+            pool->submit([&expand, child, childSum](unsigned int w) { expand(w, child, childSum); });
+            return true;
+        });
+    };
+
+    pool->submit([&](unsigned int worker) { expand(worker, std::vector<SymbolId>(), Int(0)); });
+    pool->wait();
+
+    size_t workerBytes = states.capacity() * sizeof(WorkerState);
+    for (WorkerState& state : states) {
+        combinationsChecked += state.counters.nodes;
+        pruneCount += state.counters.prunes;
+        state.counters.detail.addTo(metrics);
+        workerBytes += state.pending.capacity() * sizeof(std::string) + state.stack.memoryBytes();
     }
+    parallelBytes = std::max(parallelBytes, workerBytes);
+
+    return !stopped && !(quota > 0 && solutionsFound >= maxSolutions) && !stopRequested();
 }
 
-bool BacktrackingStrategy::isViablePath(
-    const mpz_class& currentSum,
+void BacktrackingStrategy::searchArbitrary(
     const mpz_class& targetSum,
-    unsigned int remainingPositions,
-    const mpz_class& minVal,
-    const mpz_class& maxVal,
-    unsigned int currentLength,
+    const LookupTable& table,
     unsigned int minLength,
-    unsigned int maxLength) {
-    
-    if (remainingPositions == 0) {
-        return currentSum == targetSum;
-    }
-    
-    // Check bounds
-    mpz_class sumNeeded = targetSum - currentSum;
-    mpz_class maxPossible = maxVal * remainingPositions;
-    mpz_class minPossible = minVal * remainingPositions;
-    
-    return (sumNeeded <= maxPossible && sumNeeded >= minPossible);
-}
-
-std::vector<std::pair<char, mpz_class>> BacktrackingStrategy::createSortedCharacters(
-    const std::unordered_map<char, mpz_class>& charToPartition) {
-    
-    std::vector<std::pair<char, mpz_class>> sortedChars;
-    sortedChars.reserve(charToPartition.size());
-    
-    for (const auto& [character, partitionValue] : charToPartition) {
-        sortedChars.emplace_back(character, partitionValue);
-    }
-    
-    // Sort by partition value in descending order for better pruning
-    std::sort(sortedChars.begin(), sortedChars.end(),
-              [](const auto& a, const auto& b) {
-                  return a.second > b.second;
-              });
-    
-    return sortedChars;
-}
-
-mpz_class BacktrackingStrategy::calculateRemainingSum(
-    const mpz_class& targetSum,
-    const mpz_class& currentSum,
-    unsigned int remainingPositions,
-    const mpz_class& maxVal) {
-    
-    if (remainingPositions == 0) {
-        return 0;
-    }
-    
-    mpz_class sumNeeded = targetSum - currentSum;
-    mpz_class maxPossible = maxVal * remainingPositions;
-    
-    return (sumNeeded < maxPossible) ? sumNeeded : maxPossible;
-}
-
-std::string DecryptionStrategy::getPerformanceMetrics() const {
-    double durationMs = duration.count() / 1000.0;
-    double memoryKB = memoryUsed / 1024.0;
-    
-    std::string metrics = "Performance Metrics:\n";
-    metrics += "  Duration: " + std::to_string(durationMs) + " ms\n";
-    metrics += "  Combinations checked: " + std::to_string(combinationsChecked) + "\n";
-    metrics += "  Memory used: " + std::to_string(memoryKB) + " KB\n";
-    
-    return metrics;
-}
\ No newline at end of file
+    unsigned int maxLength,
+    const SolutionVisitor& emit) {
+
+    const std::vector<mpz_class>& values = table.getSortedValues();
+
+    // Bounds for r remaining characters, indexed by r
+    std::vector<mpz_class> minRemaining(maxLength + 1);
+    std::vector<mpz_class> maxRemaining(maxLength + 1);
+    for (unsigned int r = 0; r <= maxLength; ++r) {
+        minRemaining[r] = minPartitionVal * r;
+        maxRemaining[r] = maxPartitionVal * r;
+    }
+
+    // Frames are pre-grown to the target's size, so the search reuses their limbs
+    SearchStack<mpz_class> stack;
+    stack.prepare(maxLength, targetSum);
+    SearchCounters counters;
+
+    unsigned int currentLength = 0;
+    CheckpointHook hook{checkpointInterval, std::chrono::steady_clock::now(),
+                        canonicalSearch ? 0 : CheckpointHook::defaultPollMask,
+                        [&](unsigned int depth, const SymbolId* symbols, const SearchCounters& c) {
+        saveCheckpoint(currentLength, depth, symbols, combinationsChecked + c.nodes,
+                       pruneCount + c.prunes, false);
+    }};
+    CheckpointHook* checkpoint = checkpointing ? &hook : nullptr;
+
+    for (unsigned int length = resumeFrom ? resumeFrom->length : minLength; length <= maxLength; ++length) {
+        // Early pruning: check if target is achievable with this length
+        if (targetSum > maxRemaining[length] || targetSum < minRemaining[length]) {
+            continue;
+        }
+
+        NativeSearch<mpz_class> search{values, table, minRemaining, maxRemaining,
+                                       nullptr, nullptr, targetSum, length, enableOptimizations,
+                                       canonicalSearch, control};
+
+        auto lengthStart = std::chrono::high_resolution_clock::now();
+        size_t nodesBefore = counters.nodes;
+        size_t solutionsBefore = solutionsFound;
+        const std::vector<uint32_t>* resume =
+            resumeFrom && length == resumeFrom->length ? &resumeFrom->symbols : nullptr;
+        currentLength = length;
+        bool keepGoing = searchLength(search, stack, resume, counters, emit, checkpoint);
+        recordLength(length, lengthStart, counters.nodes - nodesBefore,
+                     solutionsFound - solutionsBefore);
+        if (!keepGoing) {
+            break; // Max solutions reached or visitor stopped
+        }
+    }
+
+    combinationsChecked += counters.nodes;
+    pruneCount += counters.prunes;
+    counters.detail.addTo(metrics);
+
+    // Limbs of every frame and bound, plus the stack itself
+    size_t limbBytes = mpz_size(targetSum.get_mpz_t()) * sizeof(mp_limb_t);
+    memoryUsed = stack.memoryBytes() + stack.need.size() * limbBytes +
+                 2 * minRemaining.capacity() * (sizeof(mpz_class) + limbBytes);
+}
@@ -0,0 +1,310 @@
+#include "bulk_encoder.h"
+#include "lookup_table.h"
+#include "utf8.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BULK_ENCODER_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Passwords per task when encrypting on several threads
+const size_t chunkSize = 16384;
+
+/**
+ * @brief Sum the table values of n bytes with two independent accumulators
+ */
+uint64_t sumScalar(const uint64_t* values, const unsigned char* bytes, size_t n) {
+    uint64_t even = 0;
+    uint64_t odd = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        even += values[bytes[i]];
+        odd += values[bytes[i + 1]];
+    }
+    if (i < n) {
+        even += values[bytes[i]];
+    }
+    return even + odd;
+}
+
+#ifdef BULK_ENCODER_HAVE_AVX2
+/**
+ * @brief Sum the table values of n bytes, gathering four 64-bit values at a time
+ */
+__attribute__((target("avx2")))
+uint64_t sumAvx2(const uint64_t* values, const unsigned char* bytes, size_t n) {
+    const long long* table = reinterpret_cast<const long long*>(values);
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m128i eight = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + i));
+        __m128i low = _mm_cvtepu8_epi32(eight);
+        __m128i high = _mm_cvtepu8_epi32(_mm_srli_si128(eight, 4));
+        acc = _mm256_add_epi64(acc, _mm256_i32gather_epi64(table, low, 8));
+        acc = _mm256_add_epi64(acc, _mm256_i32gather_epi64(table, high, 8));
+    }
+    if (i + 4 <= n) {
+        uint32_t four;
+        std::memcpy(&four, bytes + i, sizeof(four));
+        __m128i indices = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(static_cast<int>(four)));
+        acc = _mm256_add_epi64(acc, _mm256_i32gather_epi64(table, indices, 8));
+        i += 4;
+    }
+
+    __m128i pair = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    uint64_t total = static_cast<uint64_t>(_mm_cvtsi128_si64(pair)) +
+                     static_cast<uint64_t>(_mm_extract_epi64(pair, 1));
+    for (; i < n; ++i) {
+        total += values[bytes[i]];
+    }
+    return total;
+}
+
+const bool cpuHasAvx2 = __builtin_cpu_supports("avx2");
+#else
+const bool cpuHasAvx2 = false;
+#endif
+
+} // namespace
+
+BulkEncoder::BulkEncoder(const LookupTable& table,
+                         const mpz_class& constantC,
+                         unsigned int minLength,
+                         unsigned int maxLength)
+    : minLength(minLength), maxLength(maxLength) {
+
+    if (table.empty() || maxLength == 0) {
+        return;
+    }
+
+    // Largest power of two that maxLength + 1 copies of still fit in 64 bits,
+    // so any number of unknown characters shows up as a sum >= invalidMark
+    invalidMark = uint64_t(1) << 63;
+    while (invalidMark > UINT64_MAX / (maxLength + 1)) {
+        invalidMark >>= 1;
+    }
+
+    mpz_class maxSum = table.getMaxValue() * maxLength;
+    mpz_class maxEncrypted = maxSum + constantC;
+    if (constantC < 0 || table.getMinValue() < 0 || maxSum >= fromNative(invalidMark) ||
+        mpz_sizeinbase(maxEncrypted.get_mpz_t(), 2) > 64) {
+        return;
+    }
+
+    std::fill(std::begin(values), std::end(values), invalidMark);
+    for (size_t id = 0; id < table.size(); ++id) {
+        const std::string& symbol = table.getSymbols()[id];
+        uint64_t value = toNative<uint64_t>(table.getSortedValues()[id]);
+        size_t position = 0;
+        uint32_t codePoint = 0;
+        decodeUtf8(symbol, position, codePoint);
+        if (codePoint < 0x80) {
+            values[codePoint] = value;
+        } else {
+            wideValues.emplace_back(codePoint, value);
+        }
+    }
+    std::sort(wideValues.begin(), wideValues.end());
+    constant = toNative<uint64_t>(constantC);
+    available = true;
+}
+
+bool BulkEncoder::usesAvx2() const {
+    return cpuHasAvx2;
+}
+
+size_t BulkEncoder::encrypt(const char* data, const size_t* offsets, size_t count,
+                            uint64_t* out, EncryptStatus* status, unsigned int threads) {
+    if (!available) {
+        throw std::runtime_error("Batch encryption needs every encrypted value to fit in 64 bits");
+    }
+
+    if (threads == 1 || count <= chunkSize) {
+        return encryptRange(data, offsets, 0, count, out, status);
+    }
+
+    if (!pool || (threads != 0 && pool->size() != threads)) {
+        pool = std::make_shared<WorkStealingPool>(threads);
+    }
+
+    // Chunks write disjoint slices of out and status
+    std::atomic<size_t> encrypted{0};
+    for (size_t begin = 0; begin < count; begin += chunkSize) {
+        size_t end = std::min(count, begin + chunkSize);
+        pool->submit([=, &encrypted](unsigned int) {
+            encrypted.fetch_add(encryptRange(data, offsets, begin, end, out, status),
+                                std::memory_order_relaxed);
+        });
+    }
+    pool->wait();
+
+    return encrypted.load();
+}
+
+size_t BulkEncoder::encryptRange(const char* data, const size_t* offsets, size_t begin, size_t end,
+                                 uint64_t* out, EncryptStatus* status) const {
+    size_t encrypted = 0;
+    for (size_t i = begin; i < end; ++i) {
+        out[i] = 0;
+        status[i] = encryptOne(data + offsets[i], offsets[i + 1] - offsets[i], out[i]);
+        if (status[i] == EncryptStatus::Ok) {
+            ++encrypted;
+        }
+    }
+    return encrypted;
+}
+
+EncryptStatus BulkEncoder::encryptOne(const char* bytes, size_t size, uint64_t& out) const {
+    // Multi-byte symbols: the byte count is not the length
+    size_t length = size;
+    uint64_t wideTotal = 0;
+    if (!wideValues.empty()) {
+        wideTotal = sumUtf8(bytes, size, length);
+    }
+
+    if (length < minLength) {
+        return EncryptStatus::TooShort;
+    }
+    if (length > maxLength) {
+        return EncryptStatus::TooLong;
+    }
+
+    uint64_t total = wideTotal;
+    if (wideValues.empty()) {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(bytes);
+#ifdef BULK_ENCODER_HAVE_AVX2
+        total = cpuHasAvx2 ? sumAvx2(values, data, length) : sumScalar(values, data, length);
+#else
+        total = sumScalar(values, data, length);
+#endif
+    }
+    if (total >= invalidMark) {
+        return EncryptStatus::UnknownCharacter;
+    }
+
+    out = total + constant;
+    return EncryptStatus::Ok;
+}
+
+size_t BulkEncoder::encryptLines(const char* data, size_t size, EncodedLine* lines, size_t capacity,
+                                 size_t& consumed) const {
+    if (capacity <= static_cast<size_t>(maxLength) + 2) {
+        throw std::invalid_argument("Line buffer must hold more than maxLength + 2 lines");
+    }
+
+    consumed = 0;
+    size_t count = 0;
+    if (!wideValues.empty()) {
+        while (consumed < size && count < capacity) {
+            const char* line = data + consumed;
+            const char* newline = static_cast<const char*>(std::memchr(line, '\n', size - consumed));
+            size_t length = newline ? static_cast<size_t>(newline - line) : size - consumed;
+            EncodedLine& out = lines[count++];
+            out.begin = consumed;
+            out.length = length > 0 && line[length - 1] == '\r' ? length - 1 : length;
+            out.encrypted = 0;
+            out.status = encryptOne(line, out.length, out.encrypted);
+            consumed += newline ? length + 1 : length;
+        }
+        return count;
+    }
+
+    // Pass 1: running sum of every byte; a newline stores the sum of its line and
+    // restarts it. Slot `count` is overwritten until a newline advances it.
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    const size_t limit = std::min(size, capacity - 1);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < limit; ++i) {
+        unsigned char byte = bytes[i];
+        uint64_t newline = byte == '\n';
+        lines[count].encrypted = sum;
+        lines[count].begin = i;
+        count += newline;
+        sum = (sum + values[byte]) & (newline - 1);
+    }
+
+    size_t lineStart = 0;
+    if (count == 0 && limit < size) {
+        // A line longer than the buffer is too long for any table
+        const void* newline = std::memchr(data + limit, '\n', size - limit);
+        size_t end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data) : size;
+        lines[0] = {0, 0, end > 0 && data[end - 1] == '\r' ? end - 1 : end, EncryptStatus::TooLong};
+        consumed = newline ? end + 1 : end;
+        return 1;
+    }
+    if (limit == size && (size == 0 || bytes[size - 1] != '\n')) {
+        // Unterminated last line
+        if (size > 0) {
+            lines[count].encrypted = sum;
+            lines[count].begin = size;
+            ++count;
+        }
+    }
+
+    // Pass 2: entries hold (sum, newline offset); turn them into validated lines
+    for (size_t k = 0; k < count; ++k) {
+        EncodedLine& line = lines[k];
+        size_t end = line.begin;
+        uint64_t total = line.encrypted;
+        size_t length = end - lineStart;
+        if (length > 0 && bytes[end - 1] == '\r') {
+            --length;
+            total -= values['\r'];
+        }
+
+        line.begin = lineStart;
+        line.length = length;
+        line.encrypted = 0;
+        if (length < minLength) {
+            line.status = EncryptStatus::TooShort;
+        } else if (length > maxLength) {
+            line.status = EncryptStatus::TooLong;
+        } else if (total >= invalidMark) {
+            line.status = EncryptStatus::UnknownCharacter;
+        } else {
+            line.encrypted = total + constant;
+            line.status = EncryptStatus::Ok;
+        }
+        lineStart = end + 1;
+    }
+    consumed = std::min(lineStart, size);
+    return count;
+}
+
+uint64_t BulkEncoder::sumUtf8(const char* bytes, size_t size, size_t& symbols) const {
+    // Keeps counting after an invalid symbol so length errors take precedence as in the byte path
+    uint64_t total = 0;
+    bool valid = true;
+    symbols = 0;
+    size_t position = 0;
+    uint32_t codePoint;
+    while (position < size) {
+        unsigned char byte = static_cast<unsigned char>(bytes[position]);
+        ++symbols;
+        if (byte < 0x80) {
+            valid = valid && values[byte] != invalidMark;
+            total += values[byte];
+            ++position;
+            continue;
+        }
+        if (!decodeUtf8(bytes, size, position, codePoint)) {
+            valid = false;
+            ++position; // Resynchronise on the next byte
+            continue;
+        }
+        auto it = std::lower_bound(wideValues.begin(), wideValues.end(), std::make_pair(codePoint, uint64_t(0)));
+        if (it == wideValues.end() || it->first != codePoint) {
+            valid = false;
+            continue;
+        }
+        total += it->second;
+    }
+    return valid ? total : invalidMark;
+}
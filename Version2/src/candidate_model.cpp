@@ -0,0 +1,133 @@
+#include "candidate_model.h"
+#include "utf8.h"
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+const char* const beginMarker = "\x02"; // Pads the context of the first symbols
+const char* const endSymbol = "";       // Follower that ends a password
+
+} // namespace
+
+MarkovModel::MarkovModel(unsigned int order)
+    : order(order) {
+    if (order == 0) {
+        throw std::invalid_argument("Markov model order must be at least 1");
+    }
+}
+
+bool MarkovModel::add(const std::string& password) {
+    std::vector<std::string> symbols;
+    if (password.empty() || !splitUtf8(password, symbols)) {
+        return false;
+    }
+
+    std::vector<std::string> padded(order - 1, beginMarker);
+    padded.insert(padded.end(), symbols.begin(), symbols.end());
+    padded.emplace_back(endSymbol);
+
+    // Every follower is counted under its contexts of length 0 to order - 1
+    for (size_t i = order - 1; i < padded.size(); ++i) {
+        std::string key;
+        for (unsigned int k = 0; k < order; ++k) {
+            Context& context = contexts[key];
+            ++context.total;
+            ++context.next[padded[i]];
+            if (k + 1 < order) {
+                key.insert(0, padded[i - k - 1]);
+            }
+        }
+    }
+
+    for (char c : password) {
+        fingerprint = (fingerprint ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    fingerprint = (fingerprint ^ '\n') * 1099511628211ull;
+    ++passwordCount;
+    return true;
+}
+
+size_t MarkovModel::loadCorpus(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open corpus file: " + path);
+    }
+
+    size_t added = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (add(line)) {
+            ++added;
+        }
+    }
+    if (file.bad()) {
+        throw std::runtime_error("Error reading corpus file: " + path);
+    }
+    return added;
+}
+
+void MarkovModel::findContexts(const std::vector<std::string>& history,
+                               std::vector<const Context*>& out) const {
+    out.assign(order, nullptr);
+    std::string key;
+    for (unsigned int k = 0; k < order; ++k) {
+        auto it = contexts.find(key);
+        if (it == contexts.end()) {
+            break; // Longer contexts contain this one, so they are unseen too
+        }
+        out[k] = &it->second;
+        if (k + 1 < order) {
+            key.insert(0, k < history.size() ? history[history.size() - k - 1] : std::string(beginMarker));
+        }
+    }
+}
+
+double MarkovModel::probability(const std::vector<const Context*>& found, const std::string& symbol) const {
+    // Add-one unigrams over the followers seen, plus one slot for unseen symbols
+    const Context* unigrams = found[0];
+    uint64_t total = unigrams ? unigrams->total : 0;
+    size_t vocabulary = unigrams ? unigrams->next.size() : 0;
+    uint64_t count = 0;
+    if (unigrams) {
+        auto it = unigrams->next.find(symbol);
+        count = it != unigrams->next.end() ? it->second : 0;
+    }
+    double p = (count + 1.0) / (total + vocabulary + 1.0);
+
+    // Witten-Bell: a context trusts its counts as much as it has seen few distinct followers
+    for (unsigned int k = 1; k < order && found[k]; ++k) {
+        const Context& context = *found[k];
+        auto it = context.next.find(symbol);
+        double seen = it != context.next.end() ? static_cast<double>(it->second) : 0.0;
+        double distinct = static_cast<double>(context.next.size());
+        p = (seen + distinct * p) / (context.total + distinct);
+    }
+    return p;
+}
+
+void MarkovModel::nextLogProbabilities(const std::vector<std::string>& history,
+                                       const std::vector<std::string>& symbols,
+                                       std::vector<double>& out) const {
+    std::vector<const Context*> found;
+    findContexts(history, found);
+    out.resize(symbols.size());
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        out[i] = std::log(probability(found, symbols[i]));
+    }
+}
+
+double MarkovModel::endLogProbability(const std::vector<std::string>& history) const {
+    std::vector<const Context*> found;
+    findContexts(history, found);
+    return std::log(probability(found, endSymbol));
+}
+
+std::string MarkovModel::getTag() const {
+    return "markov:" + std::to_string(order) + ":" + std::to_string(passwordCount) + ":" +
+           std::to_string(fingerprint);
+}
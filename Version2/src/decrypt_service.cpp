@@ -0,0 +1,317 @@
+#include "decrypt_service.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+bool isFinal(JobStatus status) {
+    return status != JobStatus::Queued && status != JobStatus::Running;
+}
+
+std::chrono::steady_clock::time_point deadlineAfter(std::chrono::milliseconds timeout) {
+    if (timeout.count() <= 0) {
+        return std::chrono::steady_clock::time_point::max();
+    }
+    return std::chrono::steady_clock::now() + timeout;
+}
+
+} // namespace
+
+DecryptJob::DecryptJob(const mpz_class& encryptedValue, std::shared_ptr<DecryptionStrategy> strategy,
+                       const JobOptions& options, unsigned int minLength, unsigned int maxLength,
+                       size_t symbolCount)
+    : encryptedValue(encryptedValue), strategy(std::move(strategy)), options(options),
+      minLength(minLength), maxLength(maxLength), symbolCount(static_cast<double>(symbolCount)),
+      deadline(deadlineAfter(options.timeout)) {
+    control.setDeadline(deadline);
+}
+
+std::string DecryptJob::getStatusName(JobStatus status) {
+    switch (status) {
+        case JobStatus::Queued: return "Queued";
+        case JobStatus::Running: return "Running";
+        case JobStatus::Completed: return "Completed";
+        case JobStatus::Cancelled: return "Cancelled";
+        case JobStatus::TimedOut: return "Timed out";
+        case JobStatus::Failed: return "Failed";
+    }
+    return "Unknown";
+}
+
+void DecryptJob::expireIfQueued() {
+    if (status == JobStatus::Queued && deadline != std::chrono::steady_clock::time_point::max() &&
+        std::chrono::steady_clock::now() >= deadline) {
+        status = JobStatus::TimedOut;
+        endTime = std::chrono::steady_clock::now();
+        doneCondition.notify_all();
+    }
+}
+
+JobStatus DecryptJob::getStatus() {
+    std::lock_guard<std::mutex> lock(mutex);
+    expireIfQueued();
+    return status;
+}
+
+bool DecryptJob::isDone() {
+    return isFinal(getStatus());
+}
+
+void DecryptJob::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        expireIfQueued();
+        if (isFinal(status)) {
+            return;
+        }
+        // A queued job has to wake up at its deadline to time itself out
+        if (status == JobStatus::Queued && deadline != std::chrono::steady_clock::time_point::max()) {
+            doneCondition.wait_until(lock, deadline);
+        } else {
+            doneCondition.wait(lock);
+        }
+    }
+}
+
+bool DecryptJob::waitFor(std::chrono::milliseconds timeout) {
+    auto until = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        expireIfQueued();
+        if (isFinal(status)) {
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= until) {
+            return false;
+        }
+        doneCondition.wait_until(lock, status == JobStatus::Queued ? std::min(until, deadline) : until);
+    }
+}
+
+void DecryptJob::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    control.cancel();
+    if (status == JobStatus::Queued) {
+        status = JobStatus::Cancelled;
+        endTime = std::chrono::steady_clock::now();
+        doneCondition.notify_all();
+    }
+}
+
+bool DecryptJob::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    expireIfQueued();
+    if (status != JobStatus::Queued) {
+        return false;
+    }
+    status = JobStatus::Running;
+    started = true;
+    startTime = std::chrono::steady_clock::now();
+    return true;
+}
+
+void DecryptJob::finish(JobStatus finalStatus, bool complete, const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    status = finalStatus;
+    searchedAll = complete;
+    error = message;
+    endTime = std::chrono::steady_clock::now();
+    doneCondition.notify_all();
+}
+
+double DecryptJob::coveredFraction() const {
+    if (minLength > maxLength) {
+        return 1.0;
+    }
+
+    // Length L holds c^L passwords; weights are scaled by c^-maxLength to stay finite
+    unsigned int finished = control.getFinishedLength();
+    unsigned int current = std::max(minLength, finished + 1);
+    double covered = 0.0;
+    double total = 0.0;
+    for (unsigned int length = minLength; length <= maxLength; ++length) {
+        double weight = std::pow(symbolCount, static_cast<double>(length) - maxLength);
+        total += weight;
+        if (length <= finished) {
+            covered += weight;
+        } else if (length == current) {
+            covered += weight * control.getLengthFraction();
+        }
+    }
+    return total > 0.0 ? std::min(covered / total, 1.0) : 0.0;
+}
+
+JobProgress DecryptJob::getProgress() {
+    std::lock_guard<std::mutex> lock(mutex);
+    expireIfQueued();
+
+    JobProgress progress;
+    progress.candidates = candidates.size();
+    progress.nodes = control.getNodes();
+    progress.finishedLength = control.getFinishedLength();
+    if (searchedAll) {
+        progress.fraction = 1.0;
+    } else if (started) {
+        progress.fraction = coveredFraction();
+    }
+    if (started) {
+        auto end = status == JobStatus::Running ? std::chrono::steady_clock::now() : endTime;
+        progress.elapsedSeconds = std::chrono::duration<double>(end - startTime).count();
+    }
+    if (progress.elapsedSeconds > 0.0) {
+        progress.nodesPerSecond = progress.nodes / progress.elapsedSeconds;
+    }
+    return progress;
+}
+
+std::vector<std::string> DecryptJob::getCandidates() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return candidates;
+}
+
+std::string DecryptJob::getError() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+}
+
+DecryptService::DecryptService(PartitionEncryption& system, unsigned int threads,
+                               unsigned int interactiveWorkers)
+    : system(system) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    interactiveWorkers = std::min(interactiveWorkers, threads - 1);
+
+    for (unsigned int i = 0; i < threads; ++i) {
+        bool interactiveOnly = i < interactiveWorkers;
+        workers.emplace_back([this, interactiveOnly] { workerLoop(interactiveOnly); });
+    }
+}
+
+DecryptService::~DecryptService() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (auto* queue : {&interactiveQueue, &batchQueue}) {
+            for (const std::shared_ptr<DecryptJob>& job : *queue) {
+                job->cancel();
+            }
+            queue->clear();
+        }
+        for (const std::shared_ptr<DecryptJob>& job : running) {
+            job->cancel();
+        }
+    }
+    wakeCondition.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+std::shared_ptr<DecryptJob> DecryptService::submit(const mpz_class& encryptedValue,
+                                                   std::shared_ptr<DecryptionStrategy> strategy,
+                                                   const JobOptions& options) {
+    if (!strategy) {
+        throw std::invalid_argument("Strategy cannot be null");
+    }
+
+    std::shared_ptr<DecryptJob> job(new DecryptJob(encryptedValue, std::move(strategy), options,
+                                                   system.getMinPasswordLength(),
+                                                   system.getMaxPasswordLength(),
+                                                   system.getPreparedTable().size()));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (options.priority == JobPriority::Interactive) {
+            interactiveQueue.push_back(job);
+        } else {
+            batchQueue.push_back(job);
+        }
+    }
+    wakeCondition.notify_all();
+    return job;
+}
+
+size_t DecryptService::getQueuedCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return interactiveQueue.size() + batchQueue.size();
+}
+
+std::shared_ptr<DecryptJob> DecryptService::takeJob(bool interactiveOnly) {
+    for (auto* queue : {&interactiveQueue, &batchQueue}) {
+        if (interactiveOnly && queue == &batchQueue) {
+            break;
+        }
+        for (auto it = queue->begin(); it != queue->end();) {
+            // Jobs cancelled or timed out while queued are dropped here
+            if ((*it)->isDone()) {
+                it = queue->erase(it);
+                continue;
+            }
+            if (busy.count((*it)->strategy.get())) {
+                ++it;
+                continue;
+            }
+            std::shared_ptr<DecryptJob> job = *it;
+            it = queue->erase(it);
+            if (job->start()) {
+                return job;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void DecryptService::workerLoop(bool interactiveOnly) {
+    for (;;) {
+        std::shared_ptr<DecryptJob> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [&] {
+                return stopping || (job = takeJob(interactiveOnly)) != nullptr;
+            });
+            if (stopping) {
+                return;
+            }
+            busy.insert(job->strategy.get());
+            running.push_back(job);
+        }
+
+        run(*job);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy.erase(job->strategy.get());
+            running.erase(std::find(running.begin(), running.end(), job));
+        }
+        // A job skipped because its strategy was busy may run now
+        wakeCondition.notify_all();
+    }
+}
+
+void DecryptService::run(DecryptJob& job) {
+    JobStatus finalStatus = JobStatus::Completed;
+    bool completed = false;
+    std::string message;
+
+    job.strategy->setSearchControl(&job.control);
+    try {
+        completed = system.decrypt(job.encryptedValue, job.strategy, [&job](const std::string& candidate) {
+            std::lock_guard<std::mutex> lock(job.mutex);
+            job.candidates.push_back(candidate);
+            return job.options.maxCandidates == 0 || job.candidates.size() < job.options.maxCandidates;
+        });
+        // Otherwise the search stopped at maxCandidates, which completes the job
+        if (!completed && job.control.isCancelled()) {
+            finalStatus = JobStatus::Cancelled;
+        } else if (!completed && job.control.isExpired()) {
+            finalStatus = JobStatus::TimedOut;
+        }
+    } catch (const std::exception& e) {
+        finalStatus = JobStatus::Failed;
+        message = e.what();
+    }
+    job.strategy->setSearchControl(nullptr);
+
+    job.finish(finalStatus, completed, message);
+}
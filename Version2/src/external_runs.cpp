@@ -0,0 +1,161 @@
+#include "external_runs.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+std::atomic<uint64_t> runCounter{0};
+
+/**
+ * @brief Open a new file with a name no other run (or process) is using
+ */
+std::FILE* createUnique(const std::string& directory, std::string& path) {
+    uint64_t stamp = static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        path = directory + "/partition-run-" + std::to_string(stamp) + "-" +
+               std::to_string(runCounter.fetch_add(1)) + ".bin";
+        // "x" fails instead of truncating a file that already exists
+        if (std::FILE* file = std::fopen(path.c_str(), "wbx")) {
+            return file;
+        }
+    }
+    throw std::runtime_error("Could not create a run file in " + directory);
+}
+
+} // namespace
+
+SortedRun::~SortedRun() {
+    std::remove(path.c_str());
+}
+
+RunWriter::RunWriter(const std::string& directory, size_t bufferRecords) {
+    file = createUnique(directory, path);
+    buffer.reserve(std::max<size_t>(bufferRecords, 1));
+}
+
+RunWriter::~RunWriter() {
+    // Abandoned before finish(): nothing refers to the file
+    if (file) {
+        std::fclose(file);
+        std::remove(path.c_str());
+    }
+}
+
+void RunWriter::append(const PartialSum* data, size_t count) {
+    flush();
+    if (count > 0 && std::fwrite(data, sizeof(PartialSum), count, file) != count) {
+        throw std::runtime_error("Could not write run file " + path);
+    }
+    written += count;
+}
+
+void RunWriter::flush() {
+    if (!buffer.empty() && std::fwrite(buffer.data(), sizeof(PartialSum), buffer.size(), file) != buffer.size()) {
+        throw std::runtime_error("Could not write run file " + path);
+    }
+    written += buffer.size();
+    buffer.clear();
+}
+
+std::unique_ptr<SortedRun> RunWriter::finish() {
+    flush();
+    int status = std::fclose(file);
+    file = nullptr;
+    std::unique_ptr<SortedRun> run(new SortedRun(path, written));
+    if (status != 0) {
+        throw std::runtime_error("Could not write run file " + path);
+    }
+    return run;
+}
+
+bool RunMerger::Cursor::refill() {
+    filled = std::fread(buffer.data(), sizeof(PartialSum), buffer.size(), file);
+    position = 0;
+    return filled > 0;
+}
+
+RunMerger::RunMerger(const std::vector<const SortedRun*>& runs, bool descending, size_t bufferRecords)
+    : cursors(runs.size()), descending(descending) {
+    for (size_t i = 0; i < runs.size(); ++i) {
+        Cursor& cursor = cursors[i];
+        cursor.file = std::fopen(runs[i]->getPath().c_str(), "rb");
+        if (!cursor.file) {
+            throw std::runtime_error("Could not open run file " + runs[i]->getPath());
+        }
+        // Reads go straight into the block buffer; stdio's own would be a second copy
+        std::setvbuf(cursor.file, nullptr, _IONBF, 0);
+        cursor.buffer.resize(std::max<size_t>(std::min<uint64_t>(bufferRecords, runs[i]->size()), 1));
+        if (cursor.refill()) {
+            heap.push_back(i);
+        }
+    }
+    auto later = [this](size_t a, size_t b) { return before(b, a); };
+    std::make_heap(heap.begin(), heap.end(), later);
+}
+
+RunMerger::~RunMerger() {
+    for (Cursor& cursor : cursors) {
+        if (cursor.file) {
+            std::fclose(cursor.file);
+        }
+    }
+}
+
+bool RunMerger::before(size_t a, size_t b) const {
+    uint64_t sumA = cursors[a].head().sum;
+    uint64_t sumB = cursors[b].head().sum;
+    return descending ? sumA > sumB : sumA < sumB;
+}
+
+void RunMerger::advance() {
+    auto later = [this](size_t a, size_t b) { return before(b, a); };
+    std::pop_heap(heap.begin(), heap.end(), later);
+    Cursor& cursor = cursors[heap.back()];
+    if (++cursor.position < cursor.filled || cursor.refill()) {
+        std::push_heap(heap.begin(), heap.end(), later);
+    } else {
+        heap.pop_back();
+    }
+}
+
+size_t RunMerger::memoryBytes() const {
+    size_t bytes = cursors.capacity() * sizeof(Cursor) + heap.capacity() * sizeof(size_t);
+    for (const Cursor& cursor : cursors) {
+        bytes += cursor.buffer.capacity() * sizeof(PartialSum);
+    }
+    return bytes;
+}
+
+uint64_t reduceRuns(std::vector<std::unique_ptr<SortedRun>>& runs, const std::string& directory,
+                    bool descending, size_t maxRuns, size_t bufferRecords) {
+    uint64_t bytesWritten = 0;
+    maxRuns = std::max<size_t>(maxRuns, 2);
+
+    while (runs.size() > maxRuns) {
+        std::vector<std::unique_ptr<SortedRun>> merged;
+        for (size_t begin = 0; begin < runs.size(); begin += maxRuns) {
+            size_t end = std::min(runs.size(), begin + maxRuns);
+            std::vector<const SortedRun*> group;
+            for (size_t i = begin; i < end; ++i) {
+                group.push_back(runs[i].get());
+            }
+
+            RunWriter writer(directory, bufferRecords);
+            for (RunMerger merger(group, descending, bufferRecords); merger.valid(); merger.advance()) {
+                writer.push(merger.current());
+            }
+            merged.push_back(writer.finish());
+            bytesWritten += merged.back()->size() * sizeof(PartialSum);
+
+            // Inputs are deleted as soon as they are merged
+            for (size_t i = begin; i < end; ++i) {
+                runs[i].reset();
+            }
+        }
+        runs.swap(merged);
+    }
+    return bytesWritten;
+}
@@ -0,0 +1,314 @@
+#include "hybrid_strategy.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Relative cost of the basic operations of each engine, in "search nodes"
+constexpr double kNodeCost = 1.0;        // Expanding one backtracking node
+constexpr double kCheckCost = 0.2;       // Testing one child against the reachability index
+constexpr double kLookupCost = 1.5;      // One PairSumTable probe
+constexpr double kRecordCost = 2.0;      // Generating one MITM record
+constexpr double kSortCost = 1.5;        // Radix-sorting one record
+constexpr double kHeapCost = 1.0;        // One heap level in the Schroeppel-Shamir streams
+constexpr size_t kMaxBins = 4096;        // Resolution of the binned count DP
+constexpr size_t kReachabilityBudget = size_t(256) << 20; // BacktrackingStrategy's default
+
+/**
+ * Approximate number of r-character sequences per sum, for sums in [0, maxSum]
+ *
+ * ways[r][b] counts sequences whose sum falls in bin b. Bins are binWidth wide;
+ * a value shifts a row by v / binWidth bins, with the fractional part split
+ * linearly between the two neighbouring bins so total counts stay exact.
+ * Small targets get one bin per sum, which makes the counts exact.
+ */
+class SumCountModel {
+public:
+    SumCountModel(const std::vector<uint64_t>& values, uint64_t maxSum, unsigned int maxLength) {
+        size_t binCount = static_cast<size_t>(std::min<uint64_t>(maxSum + 1, kMaxBins));
+        binWidth = static_cast<double>(maxSum + 1) / binCount;
+        ways.assign(maxLength + 1, std::vector<double>(binCount, 0.0));
+        ways[0][0] = 1.0;
+
+        for (unsigned int r = 1; r <= maxLength; ++r) {
+            const std::vector<double>& previous = ways[r - 1];
+            std::vector<double>& current = ways[r];
+
+            // dp[r][j] += dp[r-1][j - v] for every value v
+            for (uint64_t value : values) {
+                double shift = value / binWidth;
+                size_t whole = static_cast<size_t>(shift);
+                double fraction = shift - whole;
+
+                for (size_t j = 0; j + whole < binCount; ++j) {
+                    if (previous[j] == 0.0) {
+                        continue;
+                    }
+                    current[j + whole] += previous[j] * (1.0 - fraction);
+                    if (j + whole + 1 < binCount) {
+                        current[j + whole + 1] += previous[j] * fraction;
+                    }
+                }
+            }
+        }
+    }
+
+    size_t binCount() const { return ways[0].size(); }
+    double binCenter(size_t bin) const { return (bin + 0.5) * binWidth; }
+
+    size_t binOf(double sum) const {
+        double bin = std::floor(sum / binWidth);
+        return static_cast<size_t>(std::clamp(bin, 0.0, static_cast<double>(binCount() - 1)));
+    }
+
+    /**
+     * @brief Expected number of r-character sequences with exactly this sum
+     */
+    double countAt(unsigned int r, double sum) const {
+        if (sum < 0.0 || sum >= binCount() * binWidth) {
+            return 0.0;
+        }
+        return ways[r][binOf(sum)] / std::max(binWidth, 1.0);
+    }
+
+    /**
+     * @brief Number of r-character sequences with a sum in [low, high]
+     */
+    double countIn(unsigned int r, double low, double high) const {
+        if (high < low) {
+            return 0.0;
+        }
+        double total = 0.0;
+        for (size_t bin = binOf(low); bin <= binOf(high); ++bin) {
+            total += ways[r][bin];
+        }
+        return total;
+    }
+
+    /**
+     * @brief Number of d-character prefixes, bin by bin, that pass a predicate on their sum
+     * @param weight Called with the prefix sum; returns the fraction of prefixes counted
+     */
+    template <typename Weight>
+    double countPrefixes(unsigned int d, Weight&& weight) const {
+        double total = 0.0;
+        for (size_t bin = 0; bin < binCount(); ++bin) {
+            if (ways[d][bin] > 0.0) {
+                total += ways[d][bin] * weight(binCenter(bin));
+            }
+        }
+        return total;
+    }
+
+private:
+    double binWidth;
+    std::vector<std::vector<double>> ways;
+};
+
+/**
+ * Sum window [low, high] for `positions` characters when the other
+ * `others` characters must make up the rest of the target
+ */
+std::pair<double, double> sumWindow(double target, double minVal, double maxVal,
+                                    unsigned int positions, unsigned int others) {
+    double low = std::max(0.0, target - maxVal * others);
+    double high = std::min(target - minVal * others, maxVal * positions);
+    return {low, high};
+}
+
+} // namespace
+
+HybridStrategy::HybridStrategy(double maxMemoryGB)
+    : backtracking(true, 0), mitm(maxMemoryGB) {
+}
+
+std::string HybridStrategy::getEngineName(Engine engine) {
+    switch (engine) {
+        case Engine::Backtracking: return "Backtracking";
+        case Engine::PairLookupTail: return "Backtracking + pair lookup";
+        case Engine::MeetInTheMiddle: return "Meet-in-the-Middle";
+        case Engine::SchroeppelShamir: return "Schroeppel-Shamir";
+    }
+    return "Unknown";
+}
+
+std::vector<HybridStrategy::LengthPlan> HybridStrategy::plan(
+    const mpz_class& targetSum,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength) const {
+
+    std::vector<LengthPlan> plans;
+    if (table.empty() || targetSum < 0 || targetSum > table.getMaxValue() * maxLength) {
+        return plans;
+    }
+
+    // Only backtracking has kernels for sums wider than 64 bits
+    if (table.widthFor(maxLength) != ValueWidth::Native64) {
+        for (unsigned int length = minLength; length <= maxLength; ++length) {
+            if (targetSum <= table.getMaxValue() * length && targetSum >= table.getMinValue() * length) {
+                plans.push_back({length, Engine::Backtracking, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
+            }
+        }
+        return plans;
+    }
+
+    const std::vector<uint64_t>& values = table.getNativeValues<uint64_t>();
+    const uint64_t target = toNative<uint64_t>(targetSum);
+    const double T = static_cast<double>(target);
+    const double minVal = static_cast<double>(values.back());
+    const double maxVal = static_cast<double>(values.front());
+    const double symbolCount = static_cast<double>(values.size());
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    SumCountModel model(values, target, maxLength);
+
+    bool reachabilityAvailable = ReachabilityIndex::estimateBytes(
+        values.back(), values.front(), std::max(maxLength, table.getMaxLength())) <= kReachabilityBudget;
+
+    for (unsigned int length = minLength; length <= maxLength; ++length) {
+        if (target > values.front() * length || target < values.back() * length) {
+            continue;
+        }
+
+        LengthPlan lengthPlan{length, Engine::Backtracking, model.countAt(length, T),
+                              0.0, 0.0, 0.0, 0.0, 0.0};
+
+        // Backtracking: prefixes at depth d whose remainder the other n-d
+        // characters can still produce (exactly, with the reachability index)
+        double treeCost = 0.0;
+        double depthCosts[2] = {0.0, 0.0}; // Cost of the last two levels
+        double prefixesAtTail = 0.0;        // Nodes at depth n-2
+        for (unsigned int d = 0; d <= length; ++d) {
+            unsigned int remaining = length - d;
+            double inBounds = model.countPrefixes(d, [&](double sum) {
+                double need = T - sum;
+                return (need >= minVal * remaining && need <= maxVal * remaining) ? 1.0 : 0.0;
+            });
+
+            double levelCost;
+            double nodes;
+            if (reachabilityAvailable) {
+                nodes = model.countPrefixes(d, [&](double sum) {
+                    return std::min(1.0, model.countAt(remaining, T - sum));
+                });
+                levelCost = nodes * kNodeCost + inBounds * kCheckCost;
+            } else {
+                nodes = inBounds;
+                levelCost = nodes * kNodeCost;
+            }
+
+            treeCost += levelCost;
+            if (remaining < 2) {
+                depthCosts[remaining] = levelCost;
+            }
+            if (remaining == 2) {
+                prefixesAtTail = nodes;
+            }
+        }
+        lengthPlan.backtrackingCost = treeCost;
+        // The tree cost already includes one node per solution; the other
+        // engines pay the same to emit them
+        double emitCost = lengthPlan.estimatedSolutions * kNodeCost;
+        lengthPlan.pairLookupCost = length >= 2
+            ? treeCost - depthCosts[0] - depthCosts[1] + prefixesAtTail * kLookupCost + emitCost
+            : infinity;
+
+        // Two-list MITM: windowed half tables; sum-range buckets generate each record once
+        unsigned int firstPositions = length / 2;
+        unsigned int secondPositions = length - firstPositions;
+        auto firstWindow = sumWindow(T, minVal, maxVal, firstPositions, secondPositions);
+        auto secondWindow = sumWindow(T, minVal, maxVal, secondPositions, firstPositions);
+        double records = model.countIn(firstPositions, firstWindow.first, firstWindow.second) +
+                         model.countIn(secondPositions, secondWindow.first, secondWindow.second);
+        lengthPlan.mitmBytes = (std::pow(symbolCount, firstPositions) +
+                                2.0 * std::pow(symbolCount, secondPositions)) * sizeof(PartialSum);
+        lengthPlan.mitmCost = records * (kRecordCost + kSortCost) + emitCost;
+
+        // Four-list MITM: every pair of the two quarter lists passes through a heap
+        unsigned int quarters[4] = {firstPositions / 2, firstPositions - firstPositions / 2,
+                                    secondPositions / 2, secondPositions - secondPositions / 2};
+        double quarterSizes[4];
+        for (int q = 0; q < 4; ++q) {
+            auto window = sumWindow(T, minVal, maxVal, quarters[q], length - quarters[q]);
+            quarterSizes[q] = model.countIn(quarters[q], window.first, window.second);
+        }
+        double pops = quarterSizes[0] * quarterSizes[1] + quarterSizes[2] * quarterSizes[3];
+        double heapDepth = std::log2(std::max(quarterSizes[0], quarterSizes[2]) + 2.0);
+        lengthPlan.schroeppelShamirCost = pops * kHeapCost * heapDepth +
+                                          (quarterSizes[0] + quarterSizes[1] + quarterSizes[2] +
+                                           quarterSizes[3]) * (kRecordCost + kSortCost) + emitCost;
+
+        // Cheapest engine wins
+        std::pair<double, Engine> candidates[] = {
+            {lengthPlan.backtrackingCost, Engine::Backtracking},
+            {lengthPlan.pairLookupCost, Engine::PairLookupTail},
+            {lengthPlan.mitmCost, Engine::MeetInTheMiddle},
+            {lengthPlan.schroeppelShamirCost, Engine::SchroeppelShamir},
+        };
+        lengthPlan.engine = std::min_element(std::begin(candidates), std::end(candidates),
+                                             [](const auto& a, const auto& b) {
+                                                 return a.first < b.first;
+                                             })->second;
+
+        plans.push_back(lengthPlan);
+    }
+
+    return plans;
+}
+
+void HybridStrategy::setSearchControl(SearchControl* searchControl) {
+    DecryptionStrategy::setSearchControl(searchControl);
+    backtracking.setSearchControl(searchControl);
+    mitm.setSearchControl(searchControl);
+    schroeppelShamir.setSearchControl(searchControl);
+}
+
+bool HybridStrategy::decrypt(
+    const mpz_class& targetSum,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const SolutionVisitor& visit) {
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    bool completed = true;
+    combinationsChecked = 0;
+    memoryUsed = 0;
+    metrics.reset(getName());
+
+    lastPlan = plan(targetSum, table, minLength, maxLength);
+
+    for (const LengthPlan& lengthPlan : lastPlan) {
+        DecryptionStrategy* engine = &backtracking;
+        switch (lengthPlan.engine) {
+            case Engine::Backtracking:
+                backtracking.setPairLookupTail(false);
+                break;
+            case Engine::PairLookupTail:
+                backtracking.setPairLookupTail(true);
+                break;
+            case Engine::MeetInTheMiddle:
+                engine = &mitm;
+                break;
+            case Engine::SchroeppelShamir:
+                engine = &schroeppelShamir;
+                break;
+        }
+
+        completed = engine->decrypt(targetSum, table, lengthPlan.length, lengthPlan.length, visit);
+
+        absorbMetrics(*engine, true);
+        if (!completed) {
+            break;
+        }
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+    finishMetrics();
+
+    return completed;
+}
@@ -0,0 +1,319 @@
+#include "inverse_index.h"
+#include "atomic_file.h"
+#include "partial_sums.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define INVERSE_INDEX_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char magic[8] = {'P', 'I', 'N', 'V', 'I', 'D', 'X', '\0'};
+const uint32_t formatVersion = 1;
+const uint32_t byteOrderMark = 0x01020304;   // Files are only read on hosts of the same byte order
+const size_t sumsPerBlock = 64;
+
+/**
+ * @struct FileHeader
+ * @brief Start of the file, followed by one section record per length
+ */
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t tableFingerprint;
+    uint32_t symbolCount;
+    uint32_t maxLength;
+};
+
+void appendVarint(std::vector<unsigned char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+uint64_t readVarint(const unsigned char*& in, const unsigned char* end) {
+    uint64_t value = 0;
+    for (unsigned int shift = 0; in < end && shift < 64; shift += 7) {
+        unsigned char byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Corrupt inverse index: truncated sum block");
+}
+
+/**
+ * @brief Pad the output to a multiple of 8 bytes so mapped records are aligned
+ */
+uint64_t alignOutput(std::ostream& out) {
+    static const char zeros[8] = {};
+    uint64_t position = static_cast<uint64_t>(out.tellp());
+    out.write(zeros, (8 - position % 8) % 8);
+    return static_cast<uint64_t>(out.tellp());
+}
+
+} // namespace
+
+void InverseIndex::build(const LookupTable& table, unsigned int maxLength, const std::string& path) {
+    if (table.empty() || maxLength == 0) {
+        throw std::invalid_argument("Inverse index needs a table and a length of at least 1");
+    }
+    if (table.widthFor(maxLength) != ValueWidth::Native64 || !packedIndexFits(table.size(), maxLength)) {
+        throw std::invalid_argument("Inverse index sums and tuples must fit in 64 bits");
+    }
+
+    const std::vector<uint64_t>& values = table.getNativeValues<uint64_t>();
+    // Generated inside the writer so a failure (bad_alloc included) removes the temporary file
+    writeFileAtomically(path, [&](std::ostream& out) {
+        FileHeader header = {};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = formatVersion;
+        header.byteOrder = byteOrderMark;
+        header.tableFingerprint = table.getFingerprint();
+        header.symbolCount = static_cast<uint32_t>(table.size());
+        header.maxLength = maxLength;
+        std::vector<Section> sections(maxLength);
+
+        // Placeholder; the section records are only known once everything is written
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(Section));
+
+        std::vector<PartialSum> records;
+        std::vector<PartialSum> scratch;
+        uint64_t tupleCount = 1;
+        for (unsigned int length = 1; length <= maxLength; ++length) {
+            Section& section = sections[length - 1];
+            tupleCount *= values.size();
+
+            // Table-order enumeration plus a stable sort keeps each sum's tuples in table order
+            records.clear();
+            records.reserve(tupleCount);
+            generatePartialSums(values, length, 0, UINT64_MAX, records);
+            radixSortPartialSums(records, scratch, values.back() * length, values.front() * length);
+
+            section.tupleCount = records.size();
+            section.tupleBytes = 1;
+            while (section.tupleBytes < 8 && (tupleCount - 1) >> (8 * section.tupleBytes) != 0) {
+                ++section.tupleBytes;
+            }
+
+            std::vector<Block> blocks;
+            std::vector<unsigned char> sums;
+            uint64_t previous = 0;
+            for (size_t i = 0; i < records.size();) {
+                size_t end = i;
+                while (end < records.size() && records[end].sum == records[i].sum) {
+                    ++end;
+                }
+                if (section.sumCount % sumsPerBlock == 0) {
+                    blocks.push_back({records[i].sum, i, sums.size()});
+                    previous = records[i].sum;
+                }
+                appendVarint(sums, records[i].sum - previous);
+                appendVarint(sums, end - i);
+                previous = records[i].sum;
+                ++section.sumCount;
+                i = end;
+            }
+            section.blockCount = blocks.size();
+
+            section.blocksOffset = alignOutput(out);
+            out.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(Block));
+            section.sumsOffset = alignOutput(out);
+            out.write(reinterpret_cast<const char*>(sums.data()), sums.size());
+            section.tuplesOffset = alignOutput(out);
+
+            std::vector<unsigned char> buffer;
+            buffer.reserve(size_t(1) << 20);
+            for (const PartialSum& record : records) {
+                for (uint64_t b = 0; b < section.tupleBytes; ++b) {
+                    buffer.push_back(static_cast<unsigned char>(record.packed >> (8 * b)));
+                }
+                if (buffer.size() + 8 > buffer.capacity()) {
+                    out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+                    buffer.clear();
+                }
+            }
+            out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        }
+        alignOutput(out);
+
+        out.seekp(sizeof(header));
+        out.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(Section));
+    }, "inverse index");
+}
+
+InverseIndex::InverseIndex(const std::string& path, const LookupTable& table) : path(path) {
+#ifdef INVERSE_INDEX_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open inverse index: " + path);
+    }
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not open inverse index: " + path);
+    }
+    size = static_cast<size_t>(status.st_size);
+    void* mapping = size > 0 ? ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Could not map inverse index: " + path);
+    }
+    data = static_cast<const unsigned char*>(mapping);
+#ifdef MADV_RANDOM
+    // Lookups touch a few pages each; read-ahead would only evict others
+    ::madvise(mapping, size, MADV_RANDOM);
+#endif
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Could not open inverse index: " + path);
+    }
+    copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data = copy.data();
+    size = copy.size();
+#endif
+
+    try {
+        validate(table);
+    } catch (...) {
+        // The destructor does not run for a constructor that throws
+        release();
+        throw;
+    }
+}
+
+InverseIndex::~InverseIndex() {
+    release();
+}
+
+void InverseIndex::release() {
+#ifdef INVERSE_INDEX_HAVE_MMAP
+    if (data) {
+        ::munmap(const_cast<unsigned char*>(data), size);
+    }
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+void InverseIndex::validate(const LookupTable& table) {
+    FileHeader header;
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Corrupt inverse index: " + path);
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.byteOrder != byteOrderMark) {
+        throw std::runtime_error("Not an inverse index for this platform: " + path);
+    }
+    if (header.version != formatVersion) {
+        throw std::runtime_error("Inverse index " + path + " has an unsupported format version");
+    }
+    if (header.tableFingerprint != table.getFingerprint() || header.symbolCount != table.size()) {
+        throw std::invalid_argument("Inverse index " + path + " was built for another lookup table");
+    }
+
+    maxLength = header.maxLength;
+    tableFingerprint = header.tableFingerprint;
+    if (maxLength == 0 || (size - sizeof(header)) / sizeof(Section) < maxLength) {
+        throw std::runtime_error("Corrupt inverse index: " + path);
+    }
+    sections.resize(maxLength);
+    std::memcpy(sections.data(), data + sizeof(header), maxLength * sizeof(Section));
+
+    // Every lookup stays inside the file, however it was damaged
+    for (const Section& section : sections) {
+        bool valid = section.tupleBytes >= 1 && section.tupleBytes <= 8 &&
+                     section.blocksOffset % 8 == 0 && section.blocksOffset <= size &&
+                     section.blockCount <= (size - section.blocksOffset) / sizeof(Block) &&
+                     section.blockCount == (section.sumCount + sumsPerBlock - 1) / sumsPerBlock &&
+                     section.sumsOffset <= section.tuplesOffset && section.tuplesOffset <= size &&
+                     section.tupleCount <= (size - section.tuplesOffset) / section.tupleBytes;
+        if (!valid) {
+            throw std::runtime_error("Corrupt inverse index: " + path);
+        }
+    }
+}
+
+bool InverseIndex::find(unsigned int length, uint64_t sum, uint64_t& firstTuple, uint64_t& tupleCount) const {
+    if (length == 0 || length > maxLength) {
+        return false;
+    }
+    const Section& section = sections[length - 1];
+    const Block* blocks = reinterpret_cast<const Block*>(data + section.blocksOffset);
+    const Block* end = blocks + section.blockCount;
+
+    // Last block starting at or before the sum
+    const Block* block = std::upper_bound(blocks, end, sum, [](uint64_t value, const Block& b) {
+        return value < b.firstSum;
+    });
+    if (block == blocks) {
+        return false;
+    }
+    --block;
+
+    const unsigned char* in = data + section.sumsOffset + block->sumsOffset;
+    const unsigned char* sumsEnd = data + section.tuplesOffset;
+    uint64_t index = static_cast<uint64_t>(block - blocks) * sumsPerBlock;
+    uint64_t blockSums = std::min<uint64_t>(sumsPerBlock, section.sumCount - index);
+    uint64_t current = block->firstSum;
+    uint64_t tuple = block->firstTuple;
+    for (uint64_t i = 0; i < blockSums; ++i) {
+        current += readVarint(in, sumsEnd);
+        uint64_t count = readVarint(in, sumsEnd);
+        if (current == sum) {
+            if (tuple + count > section.tupleCount) {
+                throw std::runtime_error("Corrupt inverse index: " + path);
+            }
+            firstTuple = tuple;
+            tupleCount = count;
+            return true;
+        }
+        if (current > sum) {
+            return false;
+        }
+        tuple += count;
+    }
+    return false;
+}
+
+bool InverseIndex::lookup(unsigned int length, uint64_t sum, const TupleVisitor& visit) const {
+    uint64_t first = 0;
+    uint64_t count = 0;
+    if (!find(length, sum, first, count)) {
+        return true;
+    }
+
+    const Section& section = sections[length - 1];
+    const unsigned char* tuple = data + section.tuplesOffset + first * section.tupleBytes;
+    for (uint64_t i = 0; i < count; ++i, tuple += section.tupleBytes) {
+        uint64_t packed = 0;
+        for (uint64_t b = 0; b < section.tupleBytes; ++b) {
+            packed |= static_cast<uint64_t>(tuple[b]) << (8 * b);
+        }
+        if (!visit(packed)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t InverseIndex::count(unsigned int length, uint64_t sum) const {
+    uint64_t first = 0;
+    uint64_t count = 0;
+    return find(length, sum, first, count) ? count : 0;
+}
@@ -0,0 +1,81 @@
+#include "inverse_index_strategy.h"
+#include "partial_sums.h"
+#include <algorithm>
+
+InverseIndexStrategy::InverseIndexStrategy(const std::string& indexPath)
+    : indexPath(indexPath) {
+}
+
+const InverseIndex& InverseIndexStrategy::openIndex(const LookupTable& table) {
+    if (!index || index->getTableFingerprint() != table.getFingerprint()) {
+        index.reset();
+        index.reset(new InverseIndex(indexPath, table));
+    }
+    return *index;
+}
+
+void InverseIndexStrategy::setSearchControl(SearchControl* searchControl) {
+    DecryptionStrategy::setSearchControl(searchControl);
+    backtracking.setSearchControl(searchControl);
+}
+
+bool InverseIndexStrategy::decrypt(
+    const mpz_class& targetSum,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const SolutionVisitor& visit) {
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    bool completed = true;
+    combinationsChecked = 0;
+    memoryUsed = 0;
+    metrics.reset(getName());
+
+    if (table.empty() || targetSum < 0) {
+        return completed;
+    }
+
+    const InverseIndex& inverse = openIndex(table);
+    unsigned int indexedMax = std::min(maxLength, inverse.getMaxLength());
+
+    // Indexed sums are 64-bit; a larger target has no indexed candidates
+    if (minLength <= indexedMax && targetSum <= table.getMaxValue() * indexedMax) {
+        uint64_t target = toNative<uint64_t>(targetSum);
+        const uint64_t symbolCount = table.size();
+        std::vector<SymbolId> symbols;
+        std::string password;
+
+        for (unsigned int length = minLength; length <= indexedMax && completed; ++length) {
+            auto lengthStart = std::chrono::high_resolution_clock::now();
+            uint64_t solutionsBefore = metrics.solutions;
+            symbols.assign(length, 0);
+            completed = inverse.lookup(length, target, [&](uint64_t packed) {
+                unpackSymbols(packed, length, symbolCount, symbols.data());
+                table.spell(symbols.data(), length, password);
+                ++metrics.solutions;
+                if (!visit(password)) {
+                    return false;
+                }
+                return (metrics.solutions & SearchControl::pollMask) != 0 ||
+                       !pollControl(SearchControl::pollInterval);
+            });
+            combinationsChecked += metrics.solutions - solutionsBefore;
+            recordLength(length, lengthStart, metrics.solutions - solutionsBefore,
+                         metrics.solutions - solutionsBefore);
+        }
+    }
+
+    // Lengths beyond the index are searched
+    unsigned int searchMin = std::max(minLength, inverse.getMaxLength() + 1);
+    if (completed && searchMin <= maxLength) {
+        completed = backtracking.decrypt(targetSum, table, searchMin, maxLength, visit);
+        absorbMetrics(backtracking, true);
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+    finishMetrics();
+
+    return completed;
+}
@@ -0,0 +1,357 @@
+#include "lookup_table.h"
+#include "atomic_file.h"
+#include "utf8.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+const char compiledMagic[8] = {'P', 'T', 'A', 'B', 'L', 'E', '\0', '\0'};
+const uint32_t compiledVersion = 2;
+
+void appendLittleEndian(std::string& out, uint64_t value, unsigned int bytes) {
+    for (unsigned int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+uint64_t readLittleEndian(const std::string& in, size_t position, unsigned int bytes) {
+    uint64_t value = 0;
+    for (unsigned int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(in[position + i])) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief FNV-1a of a compiled table's payload
+ */
+uint64_t checksum(const std::string& bytes) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char byte : bytes) {
+        hash = (hash ^ byte) * 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+LookupTable::LookupTable(const std::unordered_map<std::string, mpz_class>& symbolToPartition,
+                         unsigned int maxLength)
+    : symbolToPartition(symbolToPartition), maxLength(maxLength) {
+
+    if (symbolToPartition.empty()) {
+        return;
+    }
+    if (symbolToPartition.size() > maxSymbolCount) {
+        throw std::invalid_argument("Lookup table has more than " + std::to_string(maxSymbolCount) + " symbols");
+    }
+
+    std::vector<std::pair<std::string, mpz_class>> entries(symbolToPartition.begin(), symbolToPartition.end());
+    for (const auto& entry : entries) {
+        if (!isSingleCodePoint(entry.first)) {
+            throw std::invalid_argument("Lookup table symbol \"" + entry.first +
+                                        "\" is not a single UTF-8 code point");
+        }
+    }
+
+    // Sort by partition value in descending order for better pruning
+    // (ties broken by symbol so the order is deterministic)
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) {
+                  if (a.second != b.second) {
+                      return a.second > b.second;
+                  }
+                  return a.first < b.first;
+              });
+
+    sortedSymbols.reserve(entries.size());
+    sortedValues.reserve(entries.size());
+    for (const auto& [symbol, partitionValue] : entries) {
+        sortedSymbols.push_back(symbol);
+        sortedValues.push_back(partitionValue);
+    }
+
+    maxValue = sortedValues.front();
+    minValue = sortedValues.back();
+    valueWidth = selectWidth(maxLength);
+    indexSymbols();
+
+    auto mix = [this](const std::string& bytes) {
+        for (unsigned char byte : bytes) {
+            fingerprint = (fingerprint ^ byte) * 1099511628211ull;
+        }
+        fingerprint = (fingerprint ^ 0xff) * 1099511628211ull; // Field separator
+    };
+    for (size_t i = 0; i < sortedSymbols.size(); ++i) {
+        mix(sortedSymbols[i]);
+        mix(sortedValues[i].get_str());
+    }
+
+    // Native copies of the values for the fixed-width search kernels
+    if (valueWidth == ValueWidth::Native64) {
+        nativeValues64.reserve(sortedValues.size());
+        for (const auto& value : sortedValues) {
+            nativeValues64.push_back(toNative<uint64_t>(value));
+        }
+    }
+#ifdef PARTITION_HAVE_INT128
+    if (valueWidth != ValueWidth::Arbitrary) {
+        nativeValues128.reserve(sortedValues.size());
+        for (const auto& value : sortedValues) {
+            nativeValues128.push_back(toNative<uint128_t>(value));
+        }
+    }
+#endif
+}
+
+void LookupTable::indexSymbols() {
+    symbolBytes.clear();
+    symbolOffsets.assign(1, 0);
+    asciiSymbols.assign(128, static_cast<SymbolId>(maxSymbolCount));
+    wideSymbols.clear();
+    singleByte = true;
+
+    for (size_t id = 0; id < sortedSymbols.size(); ++id) {
+        const std::string& symbol = sortedSymbols[id];
+        symbolBytes += symbol;
+        symbolOffsets.push_back(static_cast<uint32_t>(symbolBytes.size()));
+
+        size_t position = 0;
+        uint32_t codePoint = 0;
+        decodeUtf8(symbol, position, codePoint);
+        if (codePoint < 0x80) {
+            asciiSymbols[codePoint] = static_cast<SymbolId>(id);
+        } else {
+            wideSymbols.emplace_back(codePoint, static_cast<SymbolId>(id));
+            singleByte = false;
+        }
+    }
+    std::sort(wideSymbols.begin(), wideSymbols.end());
+}
+
+bool LookupTable::parse(const std::string& text, std::vector<SymbolId>& symbols) const {
+    symbols.clear();
+    if (asciiSymbols.empty()) {
+        return text.empty();
+    }
+
+    size_t position = 0;
+    uint32_t codePoint;
+    while (position < text.size()) {
+        unsigned char byte = static_cast<unsigned char>(text[position]);
+        SymbolId id;
+        if (byte < 0x80) {
+            id = asciiSymbols[byte];
+            ++position;
+        } else {
+            if (!decodeUtf8(text, position, codePoint)) {
+                return false;
+            }
+            auto it = std::lower_bound(wideSymbols.begin(), wideSymbols.end(),
+                                       std::make_pair(codePoint, SymbolId(0)));
+            id = it != wideSymbols.end() && it->first == codePoint ? it->second
+                                                                   : static_cast<SymbolId>(maxSymbolCount);
+        }
+        if (id == maxSymbolCount) {
+            return false;
+        }
+        symbols.push_back(id);
+    }
+    return true;
+}
+
+size_t LookupTable::findSymbol(const std::string& symbol) const {
+    std::vector<SymbolId> ids;
+    if (!parse(symbol, ids) || ids.size() != 1) {
+        return maxSymbolCount;
+    }
+    return ids[0];
+}
+
+ValueWidth LookupTable::widthFor(unsigned int length) const {
+    if (length <= maxLength) {
+        return valueWidth;
+    }
+    return selectWidth(length);
+}
+
+ValueWidth LookupTable::selectWidth(unsigned int length) const {
+    if (minValue < 0) {
+        return ValueWidth::Arbitrary; // Native kernels assume unsigned values
+    }
+
+    mpz_class largestSum = maxValue * std::max(length, 1u);
+    size_t bits = mpz_sizeinbase(largestSum.get_mpz_t(), 2);
+
+    if (bits <= 64) {
+        return ValueWidth::Native64;
+    }
+#ifdef PARTITION_HAVE_INT128
+    if (bits <= 128) {
+        return ValueWidth::Native128;
+    }
+#endif
+    return ValueWidth::Arbitrary;
+}
+
+void LookupTable::save(const std::string& path) const {
+    std::string payload;
+    for (size_t i = 0; i < sortedSymbols.size(); ++i) {
+        const mpz_class& value = sortedValues[i];
+        std::string magnitude((mpz_sizeinbase(value.get_mpz_t(), 2) + 7) / 8, '\0');
+        size_t written = 0;
+        mpz_export(&magnitude[0], &written, 1, 1, 1, 0, value.get_mpz_t());
+        magnitude.resize(written);
+        if (magnitude.size() > 0xffff) {
+            throw std::runtime_error("Partition value too large for a compiled table");
+        }
+
+        payload.push_back(static_cast<char>(sortedSymbols[i].size()));
+        payload += sortedSymbols[i];
+        payload.push_back(value < 0 ? 1 : 0);
+        appendLittleEndian(payload, magnitude.size(), 2);
+        payload += magnitude;
+    }
+    for (uint64_t value : nativeValues64) {
+        appendLittleEndian(payload, value, 8);
+    }
+#ifdef PARTITION_HAVE_INT128
+    for (uint128_t value : nativeValues128) {
+        appendLittleEndian(payload, static_cast<uint64_t>(value), 8);
+        appendLittleEndian(payload, static_cast<uint64_t>(value >> 64), 8);
+    }
+#endif
+
+    std::string file(compiledMagic, sizeof(compiledMagic));
+    appendLittleEndian(file, compiledVersion, 4);
+    appendLittleEndian(file, sortedSymbols.size(), 4);
+    appendLittleEndian(file, maxLength, 4);
+    appendLittleEndian(file, static_cast<uint32_t>(valueWidth), 4);
+    appendLittleEndian(file, nativeValues64.size(), 4);
+#ifdef PARTITION_HAVE_INT128
+    appendLittleEndian(file, nativeValues128.size(), 4);
+#else
+    appendLittleEndian(file, 0, 4);
+#endif
+    appendLittleEndian(file, fingerprint, 8);
+    appendLittleEndian(file, checksum(payload), 8);
+    file += payload;
+
+    writeFileAtomically(path, file, "compiled table");
+}
+
+LookupTable LookupTable::load(const std::string& path) {
+    // One read of the whole file; a table is a few kilobytes at most
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error("Could not open compiled table: " + path);
+    }
+    std::string file(static_cast<size_t>(in.tellg()), '\0');
+    in.seekg(0);
+    in.read(&file[0], file.size());
+    if (!in) {
+        throw std::runtime_error("Could not read compiled table: " + path);
+    }
+
+    const size_t headerBytes = sizeof(compiledMagic) + 6 * 4 + 2 * 8;
+    if (file.size() < headerBytes || file.compare(0, sizeof(compiledMagic), compiledMagic, sizeof(compiledMagic)) != 0) {
+        throw std::runtime_error("Not a compiled lookup table: " + path);
+    }
+    size_t position = sizeof(compiledMagic);
+    auto read = [&](unsigned int bytes) {
+        if (file.size() - position < bytes) {
+            throw std::runtime_error("Corrupt compiled table: " + path);
+        }
+        uint64_t value = readLittleEndian(file, position, bytes);
+        position += bytes;
+        return value;
+    };
+
+    uint64_t version = read(4);
+    if (version != compiledVersion) {
+        throw std::runtime_error("Compiled table " + path + " has an unsupported format version");
+    }
+    uint64_t symbolCount = read(4);
+    LookupTable table;
+    table.maxLength = static_cast<unsigned int>(read(4));
+    uint64_t width = read(4);
+    uint64_t native64Count = read(4);
+    uint64_t native128Count = read(4);
+    table.fingerprint = read(8);
+    uint64_t expectedChecksum = read(8);
+    if (checksum(file.substr(position)) != expectedChecksum) {
+        throw std::runtime_error("Corrupt compiled table (checksum mismatch): " + path);
+    }
+    if (width > static_cast<uint64_t>(ValueWidth::Arbitrary) || symbolCount == 0 || symbolCount > maxSymbolCount ||
+        (native64Count != 0 && native64Count != symbolCount) ||
+        (native128Count != 0 && native128Count != symbolCount)) {
+        throw std::runtime_error("Corrupt compiled table: " + path);
+    }
+    table.valueWidth = static_cast<ValueWidth>(width);
+
+    table.sortedSymbols.reserve(symbolCount);
+    table.sortedValues.reserve(symbolCount);
+    for (uint64_t i = 0; i < symbolCount; ++i) {
+        size_t symbolLength = static_cast<size_t>(read(1));
+        if (file.size() - position < symbolLength) {
+            throw std::runtime_error("Corrupt compiled table: " + path);
+        }
+        std::string symbol = file.substr(position, symbolLength);
+        position += symbolLength;
+        if (!isSingleCodePoint(symbol)) {
+            throw std::runtime_error("Compiled table " + path + " has a symbol that is not one UTF-8 code point");
+        }
+        bool negative = read(1) != 0;
+        size_t length = static_cast<size_t>(read(2));
+        if (file.size() - position < length) {
+            throw std::runtime_error("Corrupt compiled table: " + path);
+        }
+        mpz_class value;
+        mpz_import(value.get_mpz_t(), length, 1, 1, 1, 0, file.data() + position);
+        position += length;
+        if (negative) {
+            value = -value;
+        }
+
+        table.sortedSymbols.push_back(symbol);
+        table.sortedValues.push_back(value);
+        table.symbolToPartition[symbol] = value;
+    }
+    table.maxValue = table.sortedValues.front();
+    table.minValue = table.sortedValues.back();
+    table.indexSymbols();
+
+    // Native values are only meaningful in a build that has the same widths
+    table.nativeValues64.reserve(native64Count);
+    for (uint64_t i = 0; i < native64Count; ++i) {
+        table.nativeValues64.push_back(read(8));
+    }
+    for (uint64_t i = 0; i < native128Count; ++i) {
+        uint64_t low = read(8);
+        uint64_t high = read(8);
+#ifdef PARTITION_HAVE_INT128
+        table.nativeValues128.push_back((static_cast<uint128_t>(high) << 64) | low);
+#else
+        (void)low;
+        (void)high;
+#endif
+    }
+    if (position != file.size()) {
+        throw std::runtime_error("Corrupt compiled table: " + path);
+    }
+#ifndef PARTITION_HAVE_INT128
+    if (table.valueWidth == ValueWidth::Native128) {
+        table.valueWidth = ValueWidth::Arbitrary;
+    }
+#endif
+    return table;
+}
+
+bool LookupTable::isCompiled(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(compiledMagic)] = {};
+    in.read(magic, sizeof(magic));
+    return in && std::equal(magic, magic + sizeof(magic), compiledMagic);
+}
@@ -0,0 +1,786 @@
+#include "mitm_strategy.h"
+#include "backtracking_strategy.h"
+#include "external_runs.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+const size_t radixCountBytes = (size_t(1) << 16) * sizeof(size_t); // Counter array of one sort pass
+const size_t minBlockRecords = 4096;                               // 64 KiB: smallest useful read
+const size_t maxBlockRecords = size_t(1) << 20;                    // 16 MiB per run is plenty
+const size_t runOverheadBytes = 1024;                              // Cursor, heap slot and FILE of an open run
+
+/**
+ * @brief Write one half as sorted runs, generating it in partitions by leading symbols
+ *
+ * Partitions are gathered into a buffer of at most partitionRecords records until
+ * the next one might not fit; the buffer is then sorted and written as one run.
+ * @param values Partition values in the table's sort order
+ * @param positions Number of symbols of the half
+ * @param low Smallest sum worth keeping
+ * @param high Largest sum worth keeping
+ * @param descending Write runs in descending sum order
+ * @param partitionRecords Records the sort buffer may hold
+ * @param directory Spill directory
+ * @param runs Receives the runs
+ * @param peakBytes Raised to the memory held by the buffers
+ * @return Number of records written
+ */
+uint64_t spillHalf(const std::vector<uint64_t>& values, unsigned int positions, uint64_t low, uint64_t high,
+                   bool descending, size_t partitionRecords, const std::string& directory,
+                   std::vector<std::unique_ptr<SortedRun>>& runs, size_t& peakBytes) {
+    // Shortest prefix whose completions are guaranteed to fit in the buffer
+    unsigned int prefixLength = 0;
+    uint64_t perPrefix = 1;
+    for (unsigned int k = 0; k < positions; ++k) {
+        perPrefix *= values.size();
+    }
+    const uint64_t halfRecords = perPrefix;
+    while (perPrefix > partitionRecords) {
+        perPrefix /= values.size();
+        ++prefixLength;
+    }
+    if (perPrefix == 0 || prefixLength > positions) {
+        throw std::runtime_error("Memory budget is too small for out-of-core MITM");
+    }
+
+    std::vector<PartialSum> records;
+    std::vector<PartialSum> scratch;
+    // The sort swaps the two buffers, so both get the full capacity up front
+    records.reserve(std::min<uint64_t>(partitionRecords, halfRecords));
+    scratch.reserve(records.capacity());
+    uint64_t written = 0;
+
+    auto writeRun = [&]() {
+        if (records.empty()) {
+            return;
+        }
+        radixSortPartialSums(records, scratch, low, high);
+        if (descending) {
+            std::reverse(records.begin(), records.end());
+        }
+        RunWriter writer(directory, 0);
+        writer.append(records.data(), records.size());
+        runs.push_back(writer.finish());
+        written += records.size();
+        records.clear();
+    };
+
+    // Odometer over every prefix of prefixLength symbols
+    std::vector<uint32_t> prefix(prefixLength, 0);
+    for (;;) {
+        if (records.size() + perPrefix > partitionRecords) {
+            writeRun();
+        }
+        generatePartialSumsWithPrefix(values, positions, prefix, low, high, records);
+
+        size_t k = 0;
+        while (k < prefixLength && ++prefix[k] == values.size()) {
+            prefix[k++] = 0;
+        }
+        if (k == prefixLength) {
+            break;
+        }
+    }
+    writeRun();
+
+    peakBytes = std::max(peakBytes, (records.capacity() + scratch.capacity()) * sizeof(PartialSum) +
+                                        radixCountBytes);
+    return written;
+}
+
+/**
+ * Approximate count of half sequences with a sum at most x, from a binned count DP
+ *
+ * Bins are binWidth wide; a value shifts a row by v / binWidth bins, with the
+ * fractional part split linearly between the two neighbouring bins (as in the
+ * hybrid cost model), so the total stays exact and a cumulative count is off by
+ * at most about one bin.
+ */
+class SumDistribution {
+public:
+    /**
+     * @param values Partition values in the table's sort order
+     * @param allowed allowed[k] = ids allowed at position k (empty = every id at every position)
+     * @param positions Number of symbols per sequence
+     * @param maxBins Resolution of the DP
+     */
+    SumDistribution(const std::vector<uint64_t>& values, const std::vector<std::vector<SymbolId>>& allowed,
+                    unsigned int positions, size_t maxBins) {
+        uint64_t maxSum = 0;
+        for (unsigned int k = 0; k < positions; ++k) {
+            maxSum += allowed.empty() ? values.front() : values[allowed[k].front()];
+        }
+        size_t binCount = static_cast<size_t>(std::min<uint64_t>(maxSum + 1, maxBins));
+        binWidth = static_cast<double>(maxSum + 1) / binCount;
+
+        std::vector<double> previous(binCount, 0.0);
+        std::vector<double> current(binCount, 0.0);
+        previous[0] = 1.0;
+        for (unsigned int k = 0; k < positions; ++k) {
+            std::fill(current.begin(), current.end(), 0.0);
+            auto shiftBy = [&](uint64_t value) {
+                double shift = value / binWidth;
+                size_t whole = static_cast<size_t>(shift);
+                double fraction = shift - whole;
+                for (size_t j = 0; j + whole < binCount; ++j) {
+                    if (previous[j] == 0.0) {
+                        continue;
+                    }
+                    current[j + whole] += previous[j] * (1.0 - fraction);
+                    if (j + whole + 1 < binCount) {
+                        current[j + whole + 1] += previous[j] * fraction;
+                    }
+                }
+            };
+            if (allowed.empty()) {
+                for (uint64_t value : values) {
+                    shiftBy(value);
+                }
+            } else {
+                for (SymbolId id : allowed[k]) {
+                    shiftBy(values[id]);
+                }
+            }
+            previous.swap(current);
+        }
+
+        cumulative.assign(binCount + 1, 0.0);
+        for (size_t b = 0; b < binCount; ++b) {
+            cumulative[b + 1] = cumulative[b] + previous[b];
+        }
+    }
+
+    /**
+     * @brief Sequences with a sum of at most x, interpolated inside its bin
+     */
+    double countUpTo(double x) const {
+        double position = (x + 1.0) / binWidth;
+        if (position <= 0.0) {
+            return 0.0;
+        }
+        size_t bin = static_cast<size_t>(position);
+        if (bin + 1 >= cumulative.size()) {
+            return cumulative.back();
+        }
+        return cumulative[bin] + (position - bin) * (cumulative[bin + 1] - cumulative[bin]);
+    }
+
+private:
+    double binWidth;
+    std::vector<double> cumulative; // cumulative[b] = sequences in bins below b
+};
+
+} // namespace
+
+MeetInTheMiddleStrategy::MeetInTheMiddleStrategy(double maxMemoryGB)
+    : maxMemoryGB(maxMemoryGB) {
+}
+
+std::string MeetInTheMiddleStrategy::getCacheTag() const {
+    if (constraints.empty()) {
+        return getName();
+    }
+    return getName() + ";constraints=" + constraints.describe();
+}
+
+bool MeetInTheMiddleStrategy::decrypt(
+    const mpz_class& targetSum,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const SolutionVisitor& visit) {
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    bool completed = true;
+    combinationsChecked = 0;
+    memoryUsed = 0;
+    metrics.reset(getName());
+
+    if (table.empty() || targetSum < 0) {
+        return completed;
+    }
+
+    // Half tables hold 64-bit sums; wider tables go to the backtracking kernels
+    if (table.widthFor(maxLength) != ValueWidth::Native64) {
+        BacktrackingStrategy fallback;
+        fallback.setSearchControl(control);
+        fallback.setConstraints(constraints);
+        completed = fallback.decrypt(targetSum, table, minLength, maxLength, visit);
+        absorbMetrics(fallback, true);
+    } else if (targetSum <= table.getMaxValue() * maxLength) {
+        const std::vector<uint64_t>& values = table.getNativeValues<uint64_t>();
+        uint64_t target = toNative<uint64_t>(targetSum);
+        PositionConstraints positions;
+
+        for (unsigned int length = minLength; length <= maxLength; ++length) {
+            uint64_t lowest = values.back() * length;
+            uint64_t highest = values.front() * length;
+            const PositionConstraints* restriction = nullptr;
+            if (!constraints.empty()) {
+                if (!constraints.resolve(table, length, positions)) {
+                    continue;
+                }
+                lowest = 0;
+                highest = 0;
+                for (const std::vector<SymbolId>& allowed : positions.allowed) {
+                    lowest += values[allowed.back()];
+                    highest += values[allowed.front()];
+                }
+                restriction = &positions;
+            }
+
+            // Early pruning: check if target is achievable with this length
+            if (target > highest || target < lowest) {
+                continue;
+            }
+            auto lengthStart = std::chrono::high_resolution_clock::now();
+            size_t recordsBefore = combinationsChecked;
+            uint64_t solutionsBefore = metrics.solutions;
+            completed = decryptLength(target, table, length, visit, restriction);
+            recordLength(length, lengthStart, combinationsChecked - recordsBefore,
+                         metrics.solutions - solutionsBefore);
+            if (!completed) {
+                break;
+            }
+        }
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+    finishMetrics();
+
+    return completed;
+}
+
+bool MeetInTheMiddleStrategy::decryptLength(
+    uint64_t targetSum,
+    const LookupTable& table,
+    unsigned int length,
+    const SolutionVisitor& visit,
+    const PositionConstraints* positions) {
+
+    const std::vector<uint64_t>& values = table.getNativeValues<uint64_t>();
+
+    unsigned int firstPositions = length / 2;
+    unsigned int secondPositions = length - firstPositions;
+
+    // Packed symbol indices are base-c numbers and must fit in 64 bits
+    if (!packedIndexFits(values.size(), secondPositions)) {
+        BacktrackingStrategy fallback;
+        fallback.setSearchControl(control);
+        if (positions) {
+            fallback.setConstraints(constraints);
+        }
+        bool completed = fallback.decrypt(fromNative(targetSum), table, length, length, visit);
+        absorbMetrics(fallback, false);
+        return completed;
+    }
+
+    // Range and size of each half, over the symbols its positions allow
+    uint64_t firstMin = values.back() * firstPositions;
+    uint64_t firstMax = values.front() * firstPositions;
+    uint64_t secondMin = values.back() * secondPositions;
+    uint64_t secondMax = values.front() * secondPositions;
+    double firstCount = std::pow(static_cast<double>(values.size()), firstPositions);
+    double secondCount = std::pow(static_cast<double>(values.size()), secondPositions);
+    std::vector<std::vector<SymbolId>> firstAllowed;
+    std::vector<std::vector<SymbolId>> secondAllowed;
+    const PositionConstraints* required = nullptr;
+    if (positions) {
+        firstAllowed.assign(positions->allowed.begin(), positions->allowed.begin() + firstPositions);
+        secondAllowed.assign(positions->allowed.begin() + firstPositions, positions->allowed.end());
+        firstMin = firstMax = secondMin = secondMax = 0;
+        firstCount = secondCount = 1.0;
+        for (const std::vector<SymbolId>& allowed : firstAllowed) {
+            firstMin += values[allowed.back()];
+            firstMax += values[allowed.front()];
+            firstCount *= static_cast<double>(allowed.size());
+        }
+        for (const std::vector<SymbolId>& allowed : secondAllowed) {
+            secondMin += values[allowed.back()];
+            secondMax += values[allowed.front()];
+            secondCount *= static_cast<double>(allowed.size());
+        }
+        if (positions->requirements != 0) {
+            required = positions;
+        }
+    }
+
+    // Sum windows: each half must leave a remainder the other half can produce
+    uint64_t firstLow = targetSum > secondMax ? targetSum - secondMax : 0;
+    uint64_t firstHigh = std::min(targetSum - secondMin, firstMax);
+    uint64_t secondLow = targetSum > firstMax ? targetSum - firstMax : 0;
+    uint64_t secondHigh = std::min(targetSum - firstMin, secondMax);
+
+    uint64_t buckets = bucketCount(firstCount, secondCount);
+    if (buckets > 1 && !spillDirectory.empty() && !positions) {
+        return decryptLengthExternal(targetSum, table, {firstPositions, firstLow, firstHigh},
+                                     {secondPositions, secondLow, secondHigh}, visit);
+    }
+
+    // Buckets split the first half's sum window into ranges; the first-half sums in
+    // [low, high] pair only with second-half sums in [target - high, target - low]
+    double firstPeak = firstCount;
+    double secondPeak = secondCount;
+    std::vector<uint64_t> bounds = bucketBounds(values, firstAllowed, secondAllowed, firstPositions,
+                                                secondPositions, targetSum, firstLow, firstHigh, buckets,
+                                                firstPeak, secondPeak);
+
+    // Buffers sized for the largest bucket up front, scratch included, so none regrows
+    std::vector<PartialSum> firstHalf;
+    std::vector<PartialSum> secondHalf;
+    std::vector<PartialSum> scratch;
+    firstHalf.reserve(static_cast<size_t>(firstPeak * 1.1) + 16);
+    secondHalf.reserve(static_cast<size_t>(secondPeak * 1.1) + 16);
+    scratch.reserve(std::max(firstHalf.capacity(), secondHalf.capacity()));
+
+    for (uint64_t bucket = 0; bucket < buckets; ++bucket) {
+        if (control) {
+            control->setLengthFraction(static_cast<double>(bucket) / buckets);
+        }
+        if (bounds[bucket] >= bounds[bucket + 1]) {
+            continue;
+        }
+        firstHalf.clear();
+        secondHalf.clear();
+
+        uint64_t low = bounds[bucket];
+        uint64_t high = bounds[bucket + 1] - 1;
+        uint64_t pairLow = std::max(targetSum - high, secondLow);
+        uint64_t pairHigh = std::min(targetSum - low, secondHigh);
+        if (positions) {
+            generateConstrainedPartialSums(values, firstAllowed, low, high, firstHalf);
+            generateConstrainedPartialSums(values, secondAllowed, pairLow, pairHigh, secondHalf);
+        } else {
+            generatePartialSums(values, firstPositions, low, high, firstHalf);
+            generatePartialSums(values, secondPositions, pairLow, pairHigh, secondHalf);
+        }
+
+        // Sorting over the whole windows gives every bucket the same number of passes,
+        // so the buffers keep their roles instead of trading capacity between buckets
+        radixSortPartialSums(firstHalf, scratch, firstLow, firstHigh);
+        radixSortPartialSums(secondHalf, scratch, secondLow, secondHigh);
+
+        combinationsChecked += firstHalf.size() + secondHalf.size();
+        metrics.recordsGenerated += firstHalf.size() + secondHalf.size();
+        size_t bytesInUse = (firstHalf.capacity() + secondHalf.capacity() + scratch.capacity())
+                            * sizeof(PartialSum);
+        memoryUsed = std::max(memoryUsed, bytesInUse);
+        if (pollControl(firstHalf.size() + secondHalf.size())) {
+            return false;
+        }
+
+        if (!findMatches(firstHalf, secondHalf, targetSum, table, firstPositions, secondPositions,
+                         visit, required)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool MeetInTheMiddleStrategy::decryptLengthExternal(
+    uint64_t targetSum,
+    const LookupTable& table,
+    const HalfSplit& first,
+    const HalfSplit& second,
+    const SolutionVisitor& visit) {
+
+    const std::vector<uint64_t>& values = table.getNativeValues<uint64_t>();
+    size_t budget = static_cast<size_t>(std::max(maxMemoryGB, 0.0) * 1024.0 * 1024.0 * 1024.0);
+
+    // Generation: a partition buffer plus its radix-sort scratch
+    size_t partitionRecords = budget > radixCountBytes
+                                  ? (budget - radixCountBytes) / (2 * sizeof(PartialSum)) : 0;
+    std::vector<std::unique_ptr<SortedRun>> firstRuns;
+    std::vector<std::unique_ptr<SortedRun>> secondRuns;
+    uint64_t records = spillHalf(values, first.positions, first.low, first.high, false,
+                                 partitionRecords, spillDirectory, firstRuns, memoryUsed);
+    records += spillHalf(values, second.positions, second.low, second.high, true,
+                         partitionRecords, spillDirectory, secondRuns, memoryUsed);
+    combinationsChecked += records;
+    metrics.recordsGenerated += records;
+    metrics.bytesSpilled += records * sizeof(PartialSum);
+    if (pollControl(records)) {
+        return false;
+    }
+
+    // Merging: one read block per open run; too many runs are first merged into fewer
+    size_t blockBytes = minBlockRecords * sizeof(PartialSum) + runOverheadBytes;
+    size_t maxOpenRuns = std::max<size_t>(budget / blockBytes, 4);
+    if (firstRuns.size() + secondRuns.size() > maxOpenRuns) {
+        size_t fanIn = std::max<size_t>(maxOpenRuns / 2 - 1, 2);
+        size_t passBlock = (budget - (fanIn + 1) * runOverheadBytes) / ((fanIn + 1) * sizeof(PartialSum));
+        metrics.bytesSpilled += reduceRuns(firstRuns, spillDirectory, false, fanIn, passBlock);
+        metrics.bytesSpilled += reduceRuns(secondRuns, spillDirectory, true, fanIn, passBlock);
+    }
+
+    std::vector<const SortedRun*> firstInputs;
+    std::vector<const SortedRun*> secondInputs;
+    for (const auto& run : firstRuns) {
+        firstInputs.push_back(run.get());
+    }
+    for (const auto& run : secondRuns) {
+        secondInputs.push_back(run.get());
+    }
+    size_t openRuns = std::max<size_t>(firstInputs.size() + secondInputs.size(), 1);
+    size_t blockRecords = budget > openRuns * runOverheadBytes
+                              ? (budget - openRuns * runOverheadBytes) / (openRuns * sizeof(PartialSum)) : 0;
+    blockRecords = std::min(blockRecords, maxBlockRecords);
+
+    // Same walk as findMatches(): the first half ascending, the second descending
+    RunMerger firstStream(firstInputs, false, blockRecords);
+    RunMerger secondStream(secondInputs, true, blockRecords);
+    memoryUsed = std::max(memoryUsed, firstStream.memoryBytes() + secondStream.memoryBytes());
+
+    const uint64_t symbolCount = table.size();
+    std::vector<SymbolId> symbols(first.positions + second.positions);
+    std::string password;
+    std::vector<PartialSum> firstGroup;
+    std::vector<PartialSum> secondGroup;
+    size_t steps = 0;
+
+    while (firstStream.valid() && secondStream.valid()) {
+        if ((++steps & SearchControl::pollMask) == 0 && pollControl(SearchControl::pollInterval)) {
+            return false;
+        }
+        uint64_t sum = firstStream.current().sum + secondStream.current().sum;
+        if (sum < targetSum) {
+            firstStream.advance();
+        } else if (sum > targetSum) {
+            secondStream.advance();
+        } else {
+            // Equal runs on both sides: every pairing is a solution
+            firstGroup.clear();
+            secondGroup.clear();
+            for (uint64_t s = firstStream.current().sum; firstStream.valid() && firstStream.current().sum == s;
+                 firstStream.advance()) {
+                firstGroup.push_back(firstStream.current());
+            }
+            for (uint64_t s = secondStream.current().sum; secondStream.valid() && secondStream.current().sum == s;
+                 secondStream.advance()) {
+                secondGroup.push_back(secondStream.current());
+            }
+
+            for (const PartialSum& a : firstGroup) {
+                unpackSymbols(a.packed, first.positions, symbolCount, symbols.data());
+                for (const PartialSum& b : secondGroup) {
+                    unpackSymbols(b.packed, second.positions, symbolCount, symbols.data() + first.positions);
+                    table.spell(symbols.data(), symbols.size(), password);
+                    ++metrics.solutions;
+                    if (!visit(password)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool MeetInTheMiddleStrategy::findMatches(
+    const std::vector<PartialSum>& firstHalf,
+    const std::vector<PartialSum>& secondHalf,
+    uint64_t targetSum,
+    const LookupTable& table,
+    unsigned int firstPositions,
+    unsigned int secondPositions,
+    const SolutionVisitor& visit,
+    const PositionConstraints* required) {
+
+    if (firstHalf.empty() || secondHalf.empty()) {
+        return true;
+    }
+
+    const uint64_t symbolCount = table.size();
+    std::vector<SymbolId> symbols(firstPositions + secondPositions);
+    std::string password;
+
+    // Start at the smallest first-half sum the second half can complete, and at
+    // the largest second-half sum that fits next to it
+    uint64_t secondMax = secondHalf.back().sum;
+    size_t i = 0;
+    if (targetSum > secondMax) {
+        i = std::lower_bound(firstHalf.begin(), firstHalf.end(), targetSum - secondMax,
+                             [](const PartialSum& record, uint64_t sum) { return record.sum < sum; })
+            - firstHalf.begin();
+    }
+    if (i == firstHalf.size() || firstHalf[i].sum > targetSum) {
+        return true;
+    }
+    size_t j = std::upper_bound(secondHalf.begin(), secondHalf.end(), targetSum - firstHalf[i].sum,
+                                [](uint64_t sum, const PartialSum& record) { return sum < record.sum; })
+               - secondHalf.begin();
+
+    // Walk the first half upwards and the second half downwards
+    size_t steps = 0;
+    while (i < firstHalf.size() && j > 0) {
+        if ((++steps & SearchControl::pollMask) == 0 && pollControl(SearchControl::pollInterval)) {
+            return false;
+        }
+        uint64_t sum = firstHalf[i].sum + secondHalf[j - 1].sum;
+
+        if (sum < targetSum) {
+            ++i;
+        } else if (sum > targetSum) {
+            --j;
+        } else {
+            // Equal runs on both sides: every pairing is a solution
+            size_t firstEnd = i;
+            while (firstEnd < firstHalf.size() && firstHalf[firstEnd].sum == firstHalf[i].sum) {
+                ++firstEnd;
+            }
+            size_t secondBegin = j - 1;
+            while (secondBegin > 0 && secondHalf[secondBegin - 1].sum == secondHalf[j - 1].sum) {
+                --secondBegin;
+            }
+
+            for (size_t a = i; a < firstEnd; ++a) {
+                unpackSymbols(firstHalf[a].packed, firstPositions, symbolCount, symbols.data());
+                for (size_t b = secondBegin; b < j; ++b) {
+                    unpackSymbols(secondHalf[b].packed, secondPositions, symbolCount, symbols.data() + firstPositions);
+                    if (required && !required->satisfied(symbols.data(), symbols.size())) {
+                        continue;
+                    }
+                    table.spell(symbols.data(), symbols.size(), password);
+                    ++metrics.solutions;
+                    if (!visit(password)) {
+                        return false;
+                    }
+                }
+            }
+
+            i = firstEnd;
+            j = secondBegin;
+        }
+    }
+
+    return true;
+}
+
+bool MeetInTheMiddleStrategy::decryptBatch(
+    const std::vector<mpz_class>& targetSums,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const BatchSolutionVisitor& visit) {
+
+    if (table.empty()) {
+        return true;
+    }
+
+    // Wider tables and constrained searches are decrypted one target at a time
+    if (table.widthFor(maxLength) != ValueWidth::Native64 || !constraints.empty()) {
+        return DecryptionStrategy::decryptBatch(targetSums, table, minLength, maxLength, visit);
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    bool completed = true;
+    combinationsChecked = 0;
+    memoryUsed = 0;
+    metrics.reset(getName());
+
+    const std::vector<uint64_t>& values = table.getNativeValues<uint64_t>();
+    const mpz_class maxReachable = table.getMaxValue() * maxLength;
+
+    std::vector<std::pair<uint64_t, size_t>> requests;
+    requests.reserve(targetSums.size());
+    for (size_t i = 0; i < targetSums.size(); ++i) {
+        if (targetSums[i] >= 0 && targetSums[i] <= maxReachable) {
+            requests.emplace_back(toNative<uint64_t>(targetSums[i]), i);
+        }
+    }
+    std::sort(requests.begin(), requests.end());
+
+    std::vector<std::pair<uint64_t, size_t>> live;
+    for (unsigned int length = minLength; length <= maxLength && completed; ++length) {
+        // Only the targets this length can produce
+        auto first = std::lower_bound(requests.begin(), requests.end(),
+                                      std::make_pair(values.back() * length, size_t(0)));
+        auto last = std::upper_bound(first, requests.end(),
+                                     std::make_pair(values.front() * length, SIZE_MAX));
+        if (first == last) {
+            continue;
+        }
+
+        auto lengthStart = std::chrono::high_resolution_clock::now();
+        size_t recordsBefore = combinationsChecked;
+        uint64_t solutionsBefore = metrics.solutions;
+        live.assign(first, last);
+        completed = decryptBatchLength(live, table, length, visit);
+        recordLength(length, lengthStart, combinationsChecked - recordsBefore,
+                     metrics.solutions - solutionsBefore);
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+    finishMetrics();
+
+    return completed;
+}
+
+bool MeetInTheMiddleStrategy::decryptBatchLength(
+    const std::vector<std::pair<uint64_t, size_t>>& requests,
+    const LookupTable& table,
+    unsigned int length,
+    const BatchSolutionVisitor& visit) {
+
+    const std::vector<uint64_t>& values = table.getNativeValues<uint64_t>();
+    const uint64_t minVal = values.back();
+    const uint64_t maxVal = values.front();
+
+    unsigned int firstPositions = length / 2;
+    unsigned int secondPositions = length - firstPositions;
+    bool shareTables = packedIndexFits(values.size(), secondPositions) &&
+                       bucketCount(values.size(), firstPositions, secondPositions) == 1;
+
+    std::vector<PartialSum> firstHalf;
+    std::vector<PartialSum> secondHalf;
+    if (shareTables) {
+        // Sum windows covering every target of the batch
+        uint64_t lowest = requests.front().first;
+        uint64_t highest = requests.back().first;
+        uint64_t firstLow = lowest > maxVal * secondPositions ? lowest - maxVal * secondPositions : 0;
+        uint64_t firstHigh = std::min(highest - minVal * secondPositions, maxVal * firstPositions);
+        uint64_t secondLow = lowest > maxVal * firstPositions ? lowest - maxVal * firstPositions : 0;
+        uint64_t secondHigh = std::min(highest - minVal * firstPositions, maxVal * secondPositions);
+
+        std::vector<PartialSum> scratch;
+        generatePartialSums(values, firstPositions, firstLow, firstHigh, firstHalf);
+        generatePartialSums(values, secondPositions, secondLow, secondHigh, secondHalf);
+        radixSortPartialSums(firstHalf, scratch, firstLow, firstHigh);
+        radixSortPartialSums(secondHalf, scratch, secondLow, secondHigh);
+
+        combinationsChecked += firstHalf.size() + secondHalf.size();
+        metrics.recordsGenerated += firstHalf.size() + secondHalf.size();
+        size_t bytesInUse = (firstHalf.capacity() + secondHalf.capacity() + scratch.capacity())
+                            * sizeof(PartialSum);
+        memoryUsed = std::max(memoryUsed, bytesInUse);
+        if (pollControl(firstHalf.size() + secondHalf.size())) {
+            return false;
+        }
+    }
+
+    // Every run of equal targets is solved once and reported to all its indices
+    for (size_t begin = 0; begin < requests.size();) {
+        size_t end = begin;
+        while (end < requests.size() && requests[end].first == requests[begin].first) {
+            ++end;
+        }
+
+        SolutionVisitor forward = [&](const std::string& candidate) {
+            for (size_t k = begin; k < end; ++k) {
+                if (!visit(requests[k].second, candidate)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        bool keepGoing;
+        if (shareTables) {
+            keepGoing = findMatches(firstHalf, secondHalf, requests[begin].first, table,
+                                    firstPositions, secondPositions, forward);
+        } else {
+            keepGoing = decryptLength(requests[begin].first, table, length, forward);
+        }
+        if (!keepGoing) {
+            return false;
+        }
+
+        begin = end;
+    }
+
+    return true;
+}
+
+std::vector<uint64_t> MeetInTheMiddleStrategy::bucketBounds(
+    const std::vector<uint64_t>& values,
+    const std::vector<std::vector<SymbolId>>& firstAllowed,
+    const std::vector<std::vector<SymbolId>>& secondAllowed,
+    unsigned int firstPositions,
+    unsigned int secondPositions,
+    uint64_t targetSum,
+    uint64_t firstLow,
+    uint64_t firstHigh,
+    uint64_t buckets,
+    double& firstPeak,
+    double& secondPeak) const {
+
+    std::vector<uint64_t> bounds(buckets + 1, firstLow);
+    bounds[buckets] = firstHigh + 1;
+    if (buckets == 1 || firstLow > firstHigh) {
+        return bounds;
+    }
+
+    // Weight of the first-sum range [firstLow, x]: its first-half records plus twice the
+    // second-half records they pair with (one array plus the sort scratch, as in bucketCount())
+    const size_t maxBins = static_cast<size_t>(std::min<uint64_t>(std::max<uint64_t>(4096, 64 * buckets),
+                                                                  size_t(1) << 20));
+    SumDistribution first(values, firstAllowed, firstPositions, maxBins);
+    SumDistribution second(values, secondAllowed, secondPositions, maxBins);
+    const double target = static_cast<double>(targetSum);
+    const double firstBefore = first.countUpTo(static_cast<double>(firstLow) - 1.0);
+    const double secondTop = second.countUpTo(target - firstLow);
+    auto weightUpTo = [&](uint64_t x) {
+        return first.countUpTo(static_cast<double>(x)) - firstBefore +
+               2.0 * (secondTop - second.countUpTo(target - x - 1.0));
+    };
+
+    // Bucket b starts at the smallest sum whose range reaches b / buckets of the weight
+    const double total = weightUpTo(firstHigh);
+    for (uint64_t b = 1; b < buckets; ++b) {
+        double wanted = total * b / buckets;
+        uint64_t low = bounds[b - 1];
+        uint64_t high = firstHigh + 1;
+        while (low < high) {
+            uint64_t middle = low + (high - low) / 2;
+            if (weightUpTo(middle) >= wanted) {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+        bounds[b] = low;
+    }
+
+    // Largest estimated bucket of each half
+    firstPeak = 0.0;
+    secondPeak = 0.0;
+    for (uint64_t b = 0; b < buckets; ++b) {
+        if (bounds[b] >= bounds[b + 1]) {
+            continue;
+        }
+        double low = static_cast<double>(bounds[b]);
+        double high = static_cast<double>(bounds[b + 1] - 1);
+        firstPeak = std::max(firstPeak, first.countUpTo(high) - first.countUpTo(low - 1.0));
+        secondPeak = std::max(secondPeak, second.countUpTo(target - low) - second.countUpTo(target - high - 1.0));
+    }
+    return bounds;
+}
+
+uint64_t MeetInTheMiddleStrategy::bucketCount(
+    size_t symbolCount,
+    unsigned int firstPositions,
+    unsigned int secondPositions) const {
+
+    return bucketCount(std::pow(static_cast<double>(symbolCount), firstPositions),
+                       std::pow(static_cast<double>(symbolCount), secondPositions));
+}
+
+uint64_t MeetInTheMiddleStrategy::bucketCount(double firstCount, double secondCount) const {
+    // Both halves plus one radix-sort scratch buffer, in the worst case
+    double bytesNeeded = (firstCount + 2.0 * secondCount) * sizeof(PartialSum);
+    double budget = std::max(maxMemoryGB, 0.0) * 1024.0 * 1024.0 * 1024.0;
+    if (budget > 0.0 && bytesNeeded > budget) {
+        return static_cast<uint64_t>(std::ceil(bytesNeeded / budget));
+    }
+    return 1;
+}
@@ -0,0 +1,87 @@
+#include "multiset.h"
+#include "utf8.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+bool isAscii(const std::string& text) {
+    return std::all_of(text.begin(), text.end(), [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+}
+
+/**
+ * @brief Code points of a multiset in ascending order
+ */
+std::vector<std::string> sortedCodePoints(const std::string& multiset) {
+    std::vector<std::string> codePoints;
+    if (!splitUtf8(multiset, codePoints)) {
+        throw std::invalid_argument("Multiset is not valid UTF-8");
+    }
+    // Byte order of UTF-8 sequences is code point order
+    std::sort(codePoints.begin(), codePoints.end());
+    return codePoints;
+}
+
+/**
+ * @brief Multinomial coefficient of the runs of equal elements in a sorted sequence
+ */
+template <typename Sequence>
+mpz_class countOrderings(const Sequence& sorted) {
+    // Choose the positions of each run of equal characters in turn
+    mpz_class count = 1;
+    mpz_class ways;
+    unsigned long placed = 0;
+    for (size_t begin = 0; begin < sorted.size();) {
+        size_t end = begin;
+        while (end < sorted.size() && sorted[end] == sorted[begin]) {
+            ++end;
+        }
+        placed += end - begin;
+        mpz_bin_uiui(ways.get_mpz_t(), placed, end - begin);
+        count *= ways;
+        begin = end;
+    }
+    return count;
+}
+
+} // namespace
+
+mpz_class permutationCount(const std::string& multiset) {
+    if (isAscii(multiset)) {
+        std::string sorted = multiset;
+        std::sort(sorted.begin(), sorted.end());
+        return countOrderings(sorted);
+    }
+    return countOrderings(sortedCodePoints(multiset));
+}
+
+bool forEachPermutation(const std::string& multiset, const SolutionVisitor& visit) {
+    if (isAscii(multiset)) {
+        std::string ordering = multiset;
+        std::sort(ordering.begin(), ordering.end());
+
+        // next_permutation skips orderings that only swap equal characters
+        do {
+            if (!visit(ordering)) {
+                return false;
+            }
+        } while (std::next_permutation(ordering.begin(), ordering.end()));
+
+        return true;
+    }
+
+    // Multi-byte characters are permuted as whole code points
+    std::vector<std::string> ordering = sortedCodePoints(multiset);
+    std::string text;
+    do {
+        text.clear();
+        for (const std::string& codePoint : ordering) {
+            text += codePoint;
+        }
+        if (!visit(text)) {
+            return false;
+        }
+    } while (std::next_permutation(ordering.begin(), ordering.end()));
+
+    return true;
+}
@@ -0,0 +1,40 @@
+#include "pair_sum_table.h"
+#include <algorithm>
+
+std::shared_ptr<const PairSumTable> PairSumTable::build(const std::vector<uint64_t>& values) {
+    std::shared_ptr<PairSumTable> table(new PairSumTable());
+    table->values = values;
+
+    std::vector<std::pair<uint64_t, Pair>> entries;
+    entries.reserve(values.size() * values.size());
+    for (uint32_t i = 0; i < values.size(); ++i) {
+        for (uint32_t j = 0; j < values.size(); ++j) {
+            entries.push_back({values[i] + values[j], Pair{i, j}});
+        }
+    }
+
+    // Group by sum, keeping the table's symbol order within a group
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    table->pairs.reserve(entries.size());
+    table->ranges.reserve(entries.size());
+    for (size_t begin = 0; begin < entries.size();) {
+        size_t end = begin;
+        while (end < entries.size() && entries[end].first == entries[begin].first) {
+            table->pairs.push_back(entries[end].second);
+            ++end;
+        }
+        table->ranges[entries[begin].first] = {static_cast<uint32_t>(begin), static_cast<uint32_t>(end)};
+        begin = end;
+    }
+
+    return table;
+}
+
+size_t PairSumTable::getMemoryBytes() const {
+    // Hash nodes carry a next pointer and the cached hash besides the entry
+    size_t nodeBytes = sizeof(std::pair<const uint64_t, std::pair<uint32_t, uint32_t>>) + 2 * sizeof(void*);
+    return values.capacity() * sizeof(uint64_t) + pairs.capacity() * sizeof(Pair) +
+           ranges.size() * nodeBytes + ranges.bucket_count() * sizeof(void*);
+}
@@ -0,0 +1,230 @@
+#include "partial_sums.h"
+#include <algorithm>
+
+namespace {
+
+/**
+ * State shared by the recursive partial sum generator
+ */
+struct PartialSumGenerator {
+    const std::vector<uint64_t>& values;
+    const std::vector<uint64_t>& powers; // powers[k] = c^k
+    unsigned int positions;
+    uint64_t lowSum;
+    uint64_t highSum;
+    std::vector<PartialSum>& out;
+
+    void run(unsigned int depth, uint64_t sum, uint64_t packed) {
+        if (depth == positions) {
+            if (sum >= lowSum && sum <= highSum) {
+                out.push_back({sum, packed});
+            }
+            return;
+        }
+
+        unsigned int remaining = positions - depth - 1;
+        uint64_t minRest = values.back() * remaining;
+        uint64_t maxRest = values.front() * remaining;
+
+        for (size_t i = 0; i < values.size(); ++i) {
+            uint64_t newSum = sum + values[i];
+
+            // Too large even if every remaining position takes the smallest
+            // value; later values are smaller and may still fit
+            if (newSum + minRest > highSum) {
+                continue;
+            }
+            // Too small even with the largest remaining values; later values
+            // are smaller still
+            if (newSum + maxRest < lowSum) {
+                break;
+            }
+
+            run(depth + 1, newSum, packed + i * powers[depth]);
+        }
+    }
+};
+
+/**
+ * State of the generator over per-position allowed symbols
+ */
+struct ConstrainedPartialSumGenerator {
+    const std::vector<uint64_t>& values;
+    const std::vector<std::vector<SymbolId>>& allowed;
+    const std::vector<uint64_t>& powers;    // powers[k] = c^k
+    const std::vector<uint64_t>& minSuffix; // minSuffix[k] = smallest sum of positions k and later
+    const std::vector<uint64_t>& maxSuffix; // maxSuffix[k] = largest sum of positions k and later
+    uint64_t lowSum;
+    uint64_t highSum;
+    std::vector<PartialSum>& out;
+
+    void run(unsigned int depth, uint64_t sum, uint64_t packed) {
+        if (depth == allowed.size()) {
+            if (sum >= lowSum && sum <= highSum) {
+                out.push_back({sum, packed});
+            }
+            return;
+        }
+
+        // Allowed ids ascend, so their values descend as in the unconstrained generator
+        for (SymbolId id : allowed[depth]) {
+            uint64_t newSum = sum + values[id];
+            if (newSum + minSuffix[depth + 1] > highSum) {
+                continue;
+            }
+            if (newSum + maxSuffix[depth + 1] < lowSum) {
+                break;
+            }
+
+            run(depth + 1, newSum, packed + id * powers[depth]);
+        }
+    }
+};
+
+} // namespace
+
+bool packedIndexFits(size_t symbolCount, unsigned int positions) {
+    uint64_t limit = UINT64_MAX;
+    for (unsigned int k = 0; k < positions; ++k) {
+        if (symbolCount == 0) {
+            return true;
+        }
+        limit /= symbolCount;
+        if (limit == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void generatePartialSums(
+    const std::vector<uint64_t>& values,
+    unsigned int positions,
+    uint64_t lowSum,
+    uint64_t highSum,
+    std::vector<PartialSum>& out) {
+
+    if (values.empty() || lowSum > highSum) {
+        return;
+    }
+
+    std::vector<uint64_t> powers(positions + 1, 1);
+    for (unsigned int k = 1; k <= positions; ++k) {
+        powers[k] = powers[k - 1] * values.size();
+    }
+
+    PartialSumGenerator generator{values, powers, positions, lowSum, highSum, out};
+    generator.run(0, 0, 0);
+}
+
+void generateConstrainedPartialSums(
+    const std::vector<uint64_t>& values,
+    const std::vector<std::vector<SymbolId>>& allowed,
+    uint64_t lowSum,
+    uint64_t highSum,
+    std::vector<PartialSum>& out) {
+
+    if (values.empty() || lowSum > highSum) {
+        return;
+    }
+
+    size_t positions = allowed.size();
+    std::vector<uint64_t> powers(positions + 1, 1);
+    std::vector<uint64_t> minSuffix(positions + 1, 0);
+    std::vector<uint64_t> maxSuffix(positions + 1, 0);
+    for (size_t k = 1; k <= positions; ++k) {
+        powers[k] = powers[k - 1] * values.size();
+    }
+    for (size_t k = positions; k-- > 0;) {
+        if (allowed[k].empty()) {
+            return;
+        }
+        minSuffix[k] = minSuffix[k + 1] + values[allowed[k].back()];
+        maxSuffix[k] = maxSuffix[k + 1] + values[allowed[k].front()];
+    }
+
+    ConstrainedPartialSumGenerator generator{values, allowed, powers, minSuffix, maxSuffix,
+                                             lowSum, highSum, out};
+    generator.run(0, 0, 0);
+}
+
+void generatePartialSumsWithPrefix(
+    const std::vector<uint64_t>& values,
+    unsigned int positions,
+    const std::vector<uint32_t>& prefix,
+    uint64_t lowSum,
+    uint64_t highSum,
+    std::vector<PartialSum>& out) {
+
+    if (values.empty() || lowSum > highSum || prefix.size() > positions) {
+        return;
+    }
+
+    std::vector<uint64_t> powers(positions + 1, 1);
+    for (unsigned int k = 1; k <= positions; ++k) {
+        powers[k] = powers[k - 1] * values.size();
+    }
+
+    uint64_t sum = 0;
+    uint64_t packed = 0;
+    for (size_t k = 0; k < prefix.size(); ++k) {
+        sum += values[prefix[k]];
+        packed += prefix[k] * powers[k];
+    }
+
+    // Skip prefixes no completion can bring into the window
+    unsigned int remaining = positions - static_cast<unsigned int>(prefix.size());
+    if (sum + values.back() * remaining > highSum || sum + values.front() * remaining < lowSum) {
+        return;
+    }
+
+    PartialSumGenerator generator{values, powers, positions, lowSum, highSum, out};
+    generator.run(static_cast<unsigned int>(prefix.size()), sum, packed);
+}
+
+void radixSortPartialSums(
+    std::vector<PartialSum>& entries,
+    std::vector<PartialSum>& scratch,
+    uint64_t minSum,
+    uint64_t maxSum) {
+
+    constexpr unsigned int digitBits = 16;
+    constexpr size_t digitCount = size_t(1) << digitBits;
+
+    if (entries.size() < 2 || maxSum <= minSum) {
+        return;
+    }
+
+    // Only as many 16-bit passes as the key range needs
+    uint64_t range = maxSum - minSum;
+    unsigned int passes = 0;
+    while (range > 0) {
+        ++passes;
+        range >>= digitBits;
+    }
+
+    scratch.resize(entries.size());
+    std::vector<size_t> counts(digitCount);
+
+    for (unsigned int pass = 0; pass < passes; ++pass) {
+        unsigned int shift = pass * digitBits;
+        std::fill(counts.begin(), counts.end(), 0);
+
+        for (const PartialSum& entry : entries) {
+            ++counts[((entry.sum - minSum) >> shift) & (digitCount - 1)];
+        }
+
+        size_t offset = 0;
+        for (size_t& count : counts) {
+            size_t current = count;
+            count = offset;
+            offset += current;
+        }
+
+        for (const PartialSum& entry : entries) {
+            scratch[counts[((entry.sum - minSum) >> shift) & (digitCount - 1)]++] = entry;
+        }
+
+        entries.swap(scratch);
+    }
+}
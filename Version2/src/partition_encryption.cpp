@@ -1,10 +1,50 @@
 #include "partition_encryption.h"
+#include "result_cache.h"
+#include "utf8.h"
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
 #include <iostream>
 #include <algorithm>
 
+namespace {
+
+/**
+ * @brief Keeps a copy of a search's candidates for the result cache, up to its entry limit
+ */
+class CandidateRecorder {
+public:
+    explicit CandidateRecorder(size_t maxBytes) : maxBytes(maxBytes) {}
+
+    void add(const std::string& candidate) {
+        if (overflowed) {
+            return;
+        }
+        bytes += ResultCache::entryBytes(candidate);
+        if (bytes > maxBytes) {
+            // Too large to cache: stop paying for the copy
+            overflowed = true;
+            std::vector<std::string>().swap(candidates);
+            return;
+        }
+        candidates.push_back(candidate);
+    }
+
+    void storeIn(ResultCache& cache, const std::string& key) const {
+        if (!overflowed) {
+            cache.store(key, candidates);
+        }
+    }
+
+private:
+    size_t maxBytes;
+    size_t bytes = 0;
+    bool overflowed = false;
+    std::vector<std::string> candidates;
+};
+
+} // namespace
+
 PartitionEncryption::PartitionEncryption(const std::string& lookupTablePath) {
     // Initialize constants
     constantC = mpz_class("426609638937"); // Large constant as mentioned in README
@@ -15,10 +55,26 @@ PartitionEncryption::PartitionEncryption(const std::string& lookupTablePath) {
     loadLookupTable(lookupTablePath);
     
     std::cout << "Partition Encryption System initialized with " 
-              << charToPartition.size() << " characters." << std::endl;
+              << symbolToPartition.size() << " characters." << std::endl;
 }
 
 void PartitionEncryption::loadLookupTable(const std::string& filePath) {
+    // Compiled tables carry the derived data; nothing to parse or sort
+    if (LookupTable::isCompiled(filePath)) {
+        preparedTable = LookupTable::load(filePath);
+        if (preparedTable.getMaxLength() != maxPasswordLength) {
+            preparedTable = LookupTable(preparedTable.getSymbolToPartition(), maxPasswordLength);
+        }
+        symbolToPartition = preparedTable.getSymbolToPartition();
+        for (const auto& entry : symbolToPartition) {
+            partitionToSymbol[entry.second] = entry.first;
+        }
+        bulkEncoder = BulkEncoder(preparedTable, constantC, minPasswordLength, maxPasswordLength);
+        std::cout << "Loaded " << symbolToPartition.size()
+                  << " character-to-partition mappings (compiled)." << std::endl;
+        return;
+    }
+
     std::ifstream file(filePath);
     if (!file.is_open()) {
         throw std::runtime_error("Could not open lookup table file: " + filePath);
@@ -45,56 +101,75 @@ void PartitionEncryption::loadLookupTable(const std::string& filePath) {
         
         if (std::getline(ss, characterStr, ',') && std::getline(ss, partitionValueStr)) {
             if (!characterStr.empty()) {
-                char character = characterStr[0];
+                // One UTF-8 code point per entry; anything longer used to be truncated
+                if (!isSingleCodePoint(characterStr)) {
+                    throw std::runtime_error("Lookup table entry \"" + characterStr +
+                                             "\" is not a single UTF-8 character");
+                }
                 mpz_class partitionValue(partitionValueStr);
                 
-                charToPartition[character] = partitionValue;
-                partitionToChar[partitionValue] = character;
+                symbolToPartition[characterStr] = partitionValue;
+                partitionToSymbol[partitionValue] = characterStr;
             }
         }
     }
     
     file.close();
     
-    if (charToPartition.empty()) {
+    if (symbolToPartition.empty()) {
         throw std::runtime_error("No valid entries found in lookup table file");
     }
     
-    std::cout << "Loaded " << charToPartition.size() 
+    // Precompute sorted values, symbol ids, bounds and the native integer width once
+    preparedTable = LookupTable(symbolToPartition, maxPasswordLength);
+    bulkEncoder = BulkEncoder(preparedTable, constantC, minPasswordLength, maxPasswordLength);
+    
+    std::cout << "Loaded " << symbolToPartition.size() 
               << " character-to-partition mappings." << std::endl;
 }
 
-void PartitionEncryption::validatePassword(const std::string& password) const {
-    if (password.length() < minPasswordLength) {
+std::vector<SymbolId> PartitionEncryption::validatePassword(const std::string& password) const {
+    std::vector<SymbolId> symbols;
+    bool known = preparedTable.parse(password, symbols);
+
+    // Without a full parse, count code points (or bytes of malformed text) for the length checks
+    std::vector<std::string> codePoints;
+    bool wellFormed = known || splitUtf8(password, codePoints);
+    size_t length = known ? symbols.size() : wellFormed ? codePoints.size() : password.length();
+
+    if (length < minPasswordLength) {
         throw std::invalid_argument("Password too short. Minimum length: " + 
                                   std::to_string(minPasswordLength));
     }
     
-    if (password.length() > maxPasswordLength) {
+    if (length > maxPasswordLength) {
         throw std::invalid_argument("Password too long. Maximum length: " + 
                                   std::to_string(maxPasswordLength));
     }
     
     // Check if all characters are in the lookup table
-    for (char c : password) {
-        if (charToPartition.find(c) == charToPartition.end()) {
-            throw std::invalid_argument("Character '" + std::string(1, c) + 
-                                      "' not found in lookup table");
+    if (!known) {
+        if (!wellFormed) {
+            throw std::invalid_argument("Password is not valid UTF-8");
+        }
+        for (const std::string& c : codePoints) {
+            if (preparedTable.findSymbol(c) == maxSymbolCount) {
+                throw std::invalid_argument("Character '" + c + "' not found in lookup table");
+            }
         }
     }
+    return symbols;
 }
 
 mpz_class PartitionEncryption::encrypt(const std::string& password) {
-    validatePassword(password);
+    std::vector<SymbolId> symbols = validatePassword(password);
     
     mpz_class K = 0;
     
     // Sum partition numbers for each character
-    for (char c : password) {
-        auto it = charToPartition.find(c);
-        if (it != charToPartition.end()) {
-            K += it->second;
-        }
+    const std::vector<mpz_class>& values = preparedTable.getSortedValues();
+    for (SymbolId symbol : symbols) {
+        K += values[symbol];
     }
     
     // Add constant C to get final encrypted value Z
@@ -107,6 +182,17 @@ mpz_class PartitionEncryption::encrypt(const std::string& password) {
     return Z;
 }
 
+size_t PartitionEncryption::encryptBatch(
+    const char* data,
+    const size_t* offsets,
+    size_t count,
+    uint64_t* out,
+    EncryptStatus* status,
+    unsigned int threads) {
+
+    return bulkEncoder.encrypt(data, offsets, count, out, status, threads);
+}
+
 std::vector<std::string> PartitionEncryption::decrypt(
     const mpz_class& encryptedValue, 
     std::shared_ptr<DecryptionStrategy> strategy) {
@@ -128,14 +214,32 @@ std::vector<std::string> PartitionEncryption::decrypt(
     
     auto startTime = std::chrono::high_resolution_clock::now();
     
-    // Use the strategy to decrypt
-    std::vector<std::string> results = strategy->decrypt(
-        K, charToPartition, minPasswordLength, maxPasswordLength);
+    // Use the strategy to decrypt, unless the cache already has the answer
+    std::vector<std::string> results;
+    bool cached = false;
+    if (resultCache) {
+        std::string key = cacheKey(K, *strategy);
+        cached = resultCache->lookup(key, results);
+        if (!cached) {
+            // A search its control cancelled or timed out is partial and must not be cached
+            bool completed = strategy->decrypt(K, preparedTable, minPasswordLength, maxPasswordLength,
+                                               [&](const std::string& candidate) {
+                results.push_back(candidate);
+                return true;
+            });
+            if (completed) {
+                resultCache->store(key, results);
+            }
+        }
+    } else {
+        results = strategy->decrypt(K, preparedTable, minPasswordLength, maxPasswordLength);
+    }
     
     auto endTime = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
     
-    std::cout << "Decryption completed in " << duration.count() << " ms." << std::endl;
+    std::cout << "Decryption completed in " << duration.count() << " ms"
+              << (cached ? " (from the result cache)." : ".") << std::endl;
     std::cout << "Found " << results.size() << " possible solution(s)." << std::endl;
     
     if (!results.empty()) {
@@ -145,12 +249,237 @@ std::vector<std::string> PartitionEncryption::decrypt(
         }
     }
     
-    // Display performance metrics
-    std::cout << strategy->getPerformanceMetrics() << std::endl;
+    // Display performance metrics; a cache hit ran no search
+    if (!cached) {
+        std::cout << strategy->getPerformanceMetrics() << std::endl;
+    }
     
     return results;
 }
 
+bool PartitionEncryption::decrypt(
+    const mpz_class& encryptedValue,
+    std::shared_ptr<DecryptionStrategy> strategy,
+    const SolutionVisitor& visit) {
+
+    if (!strategy) {
+        throw std::invalid_argument("Strategy cannot be null");
+    }
+
+    // Calculate K = Z - C; a negative K has no candidates
+    mpz_class K = encryptedValue - constantC;
+    if (K < 0) {
+        return true;
+    }
+
+    if (!resultCache) {
+        return strategy->decrypt(K, preparedTable, minPasswordLength, maxPasswordLength, visit);
+    }
+
+    std::string key = cacheKey(K, *strategy);
+    std::vector<std::string> cached;
+    if (resultCache->lookup(key, cached)) {
+        for (const std::string& candidate : cached) {
+            if (!visit(candidate)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    CandidateRecorder recorder(resultCache->getMaxEntryBytes());
+    bool completed = strategy->decrypt(K, preparedTable, minPasswordLength, maxPasswordLength,
+                                       [&](const std::string& candidate) {
+        recorder.add(candidate);
+        return visit(candidate);
+    });
+    if (completed) {
+        recorder.storeIn(*resultCache, key);
+    }
+    return completed;
+}
+
+std::vector<std::vector<std::string>> PartitionEncryption::decryptBatch(
+    const std::vector<mpz_class>& encryptedValues,
+    std::shared_ptr<DecryptionStrategy> strategy) {
+
+    if (!strategy) {
+        throw std::invalid_argument("Strategy cannot be null");
+    }
+
+    std::cout << "Starting batch decryption of " << encryptedValues.size()
+              << " values using " << strategy->getName() << " strategy..." << std::endl;
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::vector<std::string>> results(encryptedValues.size());
+    size_t solutionCount = 0;
+    decryptBatch(encryptedValues, strategy, [&](size_t index, const std::string& candidate) {
+        results[index].push_back(candidate);
+        ++solutionCount;
+        return true;
+    });
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+
+    std::cout << "Batch decryption completed in " << duration.count() << " ms." << std::endl;
+    std::cout << "Found " << solutionCount << " possible solution(s) in total." << std::endl;
+    std::cout << strategy->getPerformanceMetrics() << std::endl;
+
+    return results;
+}
+
+bool PartitionEncryption::decryptBatch(
+    const std::vector<mpz_class>& encryptedValues,
+    std::shared_ptr<DecryptionStrategy> strategy,
+    const BatchSolutionVisitor& visit) {
+
+    if (!strategy) {
+        throw std::invalid_argument("Strategy cannot be null");
+    }
+
+    // Calculate K = Z - C for every value; negative Ks have no candidates and
+    // cached ones are replayed right away
+    std::vector<mpz_class> targets;
+    std::vector<size_t> positions; // Index in encryptedValues of each target
+    std::vector<std::string> keys; // Cache key of each target, if caching
+    targets.reserve(encryptedValues.size());
+    positions.reserve(encryptedValues.size());
+    std::vector<std::string> cached;
+    for (size_t i = 0; i < encryptedValues.size(); ++i) {
+        mpz_class K = encryptedValues[i] - constantC;
+        if (K < 0) {
+            continue;
+        }
+        if (resultCache) {
+            std::string key = cacheKey(K, *strategy);
+            if (resultCache->lookup(key, cached)) {
+                for (const std::string& candidate : cached) {
+                    if (!visit(i, candidate)) {
+                        return false;
+                    }
+                }
+                continue;
+            }
+            keys.push_back(std::move(key));
+        }
+        targets.push_back(K);
+        positions.push_back(i);
+    }
+
+    if (targets.empty()) {
+        return true;
+    }
+
+    if (!resultCache) {
+        return strategy->decryptBatch(targets, preparedTable, minPasswordLength, maxPasswordLength,
+                                      [&](size_t index, const std::string& candidate) {
+            return visit(positions[index], candidate);
+        });
+    }
+
+    std::vector<CandidateRecorder> recorders(targets.size(), CandidateRecorder(resultCache->getMaxEntryBytes()));
+    bool completed = strategy->decryptBatch(targets, preparedTable, minPasswordLength, maxPasswordLength,
+                                            [&](size_t index, const std::string& candidate) {
+        recorders[index].add(candidate);
+        return visit(positions[index], candidate);
+    });
+    if (completed) {
+        for (size_t index = 0; index < targets.size(); ++index) {
+            recorders[index].storeIn(*resultCache, keys[index]);
+        }
+    }
+    return completed;
+}
+
+std::string PartitionEncryption::cacheKey(const mpz_class& K, const DecryptionStrategy& strategy) const {
+    return ResultCache::makeKey(preparedTable.getFingerprint(), constantC, K, minPasswordLength, maxPasswordLength,
+                                strategy.getCacheTag());
+}
+
+bool DecryptionStrategy::decryptBatch(
+    const std::vector<mpz_class>& targetSums,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const BatchSolutionVisitor& visit) {
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    bool completed = true;
+    size_t totalChecked = 0;
+    size_t peakMemory = 0;
+    SearchMetrics batchMetrics;
+    batchMetrics.reset(getName());
+
+    for (size_t index = 0; index < targetSums.size() && completed; ++index) {
+        completed = decrypt(targetSums[index], table, minLength, maxLength,
+                            [&](const std::string& candidate) {
+            return visit(index, candidate);
+        });
+
+        totalChecked += combinationsChecked;
+        peakMemory = std::max(peakMemory, memoryUsed);
+        batchMetrics.merge(metrics);
+    }
+
+    // Report the whole batch rather than its last target
+    auto endTime = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+    combinationsChecked = totalChecked;
+    memoryUsed = peakMemory;
+    metrics = batchMetrics;
+    finishMetrics();
+
+    return completed;
+}
+
+void DecryptionStrategy::finishMetrics() {
+    metrics.milliseconds = duration.count() / 1000.0;
+    metrics.nodes = combinationsChecked;
+    metrics.peakBytes = memoryUsed;
+}
+
+void DecryptionStrategy::recordLength(
+    unsigned int length,
+    std::chrono::high_resolution_clock::time_point lengthStart,
+    size_t nodes,
+    size_t solutions) {
+
+    auto lengthEnd = std::chrono::high_resolution_clock::now();
+    double milliseconds = std::chrono::duration<double, std::milli>(lengthEnd - lengthStart).count();
+    metrics.addLength(length, milliseconds, nodes, solutions);
+    if (control && !control->stopRequested()) {
+        control->finishLength(length);
+    }
+}
+
+void DecryptionStrategy::absorbMetrics(const DecryptionStrategy& delegate, bool withLengths) {
+    combinationsChecked += delegate.combinationsChecked;
+    memoryUsed = std::max(memoryUsed, delegate.memoryUsed);
+    if (withLengths) {
+        metrics.merge(delegate.metrics);
+        return;
+    }
+    SearchMetrics counters = delegate.metrics;
+    counters.lengths.clear();
+    metrics.merge(counters);
+}
+
+std::vector<std::string> DecryptionStrategy::decrypt(
+    const mpz_class& targetSum,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength) {
+
+    std::vector<std::string> results;
+    decrypt(targetSum, table, minLength, maxLength, [&results](const std::string& candidate) {
+        results.push_back(candidate);
+        return true;
+    });
+    return results;
+}
+
 std::string DecryptionStrategy::getPerformanceMetrics() const {
     double durationMs = duration.count() / 1000.0;
     double memoryKB = memoryUsed / 1024.0;
@@ -0,0 +1,104 @@
+#include "reachability_index.h"
+#include <algorithm>
+
+namespace {
+
+size_t rowWords(uint64_t span, unsigned int r) {
+    // Row r holds the sums minVal*r .. maxVal*r, i.e. span*r + 1 bits
+    return static_cast<size_t>((span * r) / 64 + 1);
+}
+
+/**
+ * dst |= src << shift, where dst is large enough to hold every shifted bit
+ */
+void shiftOr(uint64_t* dst, size_t dstWords, const uint64_t* src, size_t srcWords, uint64_t shift) {
+    size_t wordShift = static_cast<size_t>(shift / 64);
+    unsigned int bitShift = static_cast<unsigned int>(shift % 64);
+
+    if (bitShift == 0) {
+        for (size_t i = 0; i < srcWords && i + wordShift < dstWords; ++i) {
+            dst[i + wordShift] |= src[i];
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < srcWords && i + wordShift < dstWords; ++i) {
+        dst[i + wordShift] |= src[i] << bitShift;
+        if (i + wordShift + 1 < dstWords) {
+            dst[i + wordShift + 1] |= src[i] >> (64 - bitShift);
+        }
+    }
+}
+
+} // namespace
+
+size_t ReachabilityIndex::estimateBytes(uint64_t minVal, uint64_t maxVal, unsigned int maxLength) {
+    uint64_t span = maxVal - minVal;
+    size_t words = 0;
+    for (unsigned int r = 0; r <= maxLength; ++r) {
+        words += rowWords(span, r);
+    }
+    return words * sizeof(uint64_t);
+}
+
+std::shared_ptr<const ReachabilityIndex> ReachabilityIndex::build(
+    const std::vector<uint64_t>& values,
+    unsigned int maxLength,
+    size_t maxBytes) {
+
+    if (values.empty()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<ReachabilityIndex> index(new ReachabilityIndex());
+    index->values = values;
+    std::sort(index->values.begin(), index->values.end());
+    index->values.erase(std::unique(index->values.begin(), index->values.end()), index->values.end());
+    index->minVal = index->values.front();
+    index->maxVal = index->values.back();
+    index->maxLength = maxLength;
+
+    // Guard against span * r overflowing before checking the budget
+    uint64_t span = index->maxVal - index->minVal;
+    if (maxLength > 0 && span > (UINT64_MAX - 64) / maxLength) {
+        return nullptr;
+    }
+    if (estimateBytes(index->minVal, index->maxVal, maxLength) > maxBytes) {
+        return nullptr;
+    }
+
+    index->rowOffsets.resize(maxLength + 2);
+    index->rowOffsets[0] = 0;
+    for (unsigned int r = 0; r <= maxLength; ++r) {
+        index->rowOffsets[r + 1] = index->rowOffsets[r] + rowWords(span, r);
+    }
+    index->bits.assign(index->rowOffsets[maxLength + 1], 0);
+
+    // The empty sum is the only sum of zero values
+    index->bits[0] = 1;
+
+    // Row r = OR over values v of (row r-1 shifted by v - minVal)
+    for (unsigned int r = 1; r <= maxLength; ++r) {
+        const uint64_t* src = index->bits.data() + index->rowOffsets[r - 1];
+        uint64_t* dst = index->bits.data() + index->rowOffsets[r];
+        size_t srcWords = rowWords(span, r - 1);
+        size_t dstWords = rowWords(span, r);
+
+        for (uint64_t value : index->values) {
+            shiftOr(dst, dstWords, src, srcWords, value - index->minVal);
+        }
+    }
+
+    return index;
+}
+
+bool ReachabilityIndex::covers(const std::vector<uint64_t>& otherValues, unsigned int length) const {
+    if (length > maxLength) {
+        return false;
+    }
+
+    std::vector<uint64_t> sorted = otherValues;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    return sorted == values;
+}
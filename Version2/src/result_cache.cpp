@@ -0,0 +1,248 @@
+#include "result_cache.h"
+#include "atomic_file.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+
+const char magic[4] = {'P', 'C', 'R', 'C'};
+const uint32_t formatVersion = 1;
+
+// Fixed-width integers are stored little endian whatever the host order
+void appendInt(std::string& out, uint64_t value, unsigned int bytes) {
+    for (unsigned int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void appendBytes(std::string& out, const std::string& bytes) {
+    appendInt(out, bytes.size(), 4);
+    out += bytes;
+}
+
+void appendInteger(std::string& out, const mpz_class& value) {
+    std::string magnitude((mpz_sizeinbase(value.get_mpz_t(), 2) + 7) / 8, '\0');
+    size_t written = 0;
+    mpz_export(&magnitude[0], &written, 1, 1, 1, 0, value.get_mpz_t());
+    magnitude.resize(written);
+    out.push_back(value < 0 ? '-' : '+');
+    appendBytes(out, magnitude);
+}
+
+/**
+ * @brief Bounds-checked reader over a loaded entry file
+ */
+class Reader {
+public:
+    explicit Reader(const std::string& data) : data(data) {}
+
+    bool readInt(uint64_t& value, unsigned int bytes) {
+        if (data.size() - position < bytes) {
+            return false;
+        }
+        value = 0;
+        for (unsigned int i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(data[position++])) << (8 * i);
+        }
+        return true;
+    }
+
+    bool readBytes(std::string& out, size_t length) {
+        if (data.size() - position < length) {
+            return false;
+        }
+        out.assign(data, position, length);
+        position += length;
+        return true;
+    }
+
+    bool atEnd() const { return position == data.size(); }
+
+private:
+    const std::string& data;
+    size_t position = 0;
+};
+
+} // namespace
+
+ResultCache::ResultCache(size_t maxMemoryBytes, const std::string& directory)
+    : maxMemoryBytes(maxMemoryBytes), maxEntryBytes(maxMemoryBytes / 16), directory(directory) {
+}
+
+std::string ResultCache::makeKey(
+    uint64_t tableFingerprint,
+    const mpz_class& constantC,
+    const mpz_class& target,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const std::string& strategyTag) {
+
+    std::string key;
+    appendInt(key, tableFingerprint, 8);
+    appendInteger(key, constantC);
+    appendInteger(key, target);
+    appendInt(key, minLength, 4);
+    appendInt(key, maxLength, 4);
+    appendBytes(key, strategyTag);
+    return key;
+}
+
+bool ResultCache::lookup(const std::string& key, std::vector<std::string>& candidates) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries.splice(entries.begin(), entries, it->second);
+            candidates = it->second->candidates;
+            ++stats.memoryHits;
+            return true;
+        }
+    }
+
+    std::vector<std::string> loaded;
+    bool found = !directory.empty() && readEntry(key, loaded);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!found) {
+        ++stats.misses;
+        return false;
+    }
+    ++stats.diskHits;
+
+    // Promote into the memory tier
+    size_t bytes = key.size();
+    for (const std::string& candidate : loaded) {
+        bytes += entryBytes(candidate);
+    }
+    if (bytes <= maxEntryBytes) {
+        insert(key, loaded, bytes);
+    }
+    candidates = std::move(loaded);
+    return true;
+}
+
+bool ResultCache::store(const std::string& key, const std::vector<std::string>& candidates) {
+    size_t bytes = key.size();
+    for (const std::string& candidate : candidates) {
+        bytes += entryBytes(candidate);
+    }
+    if (bytes > maxEntryBytes) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        insert(key, candidates, bytes);
+        ++stats.stores;
+    }
+    return directory.empty() || writeEntry(key, candidates);
+}
+
+void ResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    memoryBytes = 0;
+}
+
+ResultCache::Stats ResultCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+size_t ResultCache::getMemoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return memoryBytes;
+}
+
+void ResultCache::insert(const std::string& key, const std::vector<std::string>& candidates, size_t bytes) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+        memoryBytes -= it->second->bytes;
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    entries.push_front(Entry{key, candidates, bytes});
+    index.emplace(key, entries.begin());
+    memoryBytes += bytes;
+
+    while (memoryBytes > maxMemoryBytes && !entries.empty()) {
+        memoryBytes -= entries.back().bytes;
+        index.erase(entries.back().key);
+        entries.pop_back();
+        ++stats.evictions;
+    }
+}
+
+std::string ResultCache::entryPath(const std::string& key) const {
+    // FNV-1a of the key names the file; the key inside resolves collisions
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char byte : key) {
+        hash = (hash ^ byte) * 1099511628211ull;
+    }
+    std::ostringstream name;
+    name << directory << "/" << std::hex << hash << ".pcr";
+    return name.str();
+}
+
+bool ResultCache::readEntry(const std::string& key, std::vector<std::string>& candidates) const {
+    std::ifstream file(entryPath(key), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    Reader reader(data);
+    std::string header;
+    std::string storedKey;
+    uint64_t version = 0;
+    uint64_t keyLength = 0;
+    uint64_t count = 0;
+    if (!reader.readBytes(header, sizeof(magic)) || header != std::string(magic, sizeof(magic)) ||
+        !reader.readInt(version, 4) || version != formatVersion ||
+        !reader.readInt(keyLength, 4) || !reader.readBytes(storedKey, keyLength) || storedKey != key ||
+        !reader.readInt(count, 8)) {
+        return false;
+    }
+
+    std::vector<std::string> loaded;
+    loaded.reserve(std::min<uint64_t>(count, data.size() / 2));
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t length = 0;
+        std::string candidate;
+        if (!reader.readInt(length, 2) || !reader.readBytes(candidate, length)) {
+            return false;
+        }
+        loaded.push_back(std::move(candidate));
+    }
+    if (!reader.atEnd()) {
+        return false;
+    }
+    candidates = std::move(loaded);
+    return true;
+}
+
+bool ResultCache::writeEntry(const std::string& key, const std::vector<std::string>& candidates) const {
+    std::string data(magic, sizeof(magic));
+    appendInt(data, formatVersion, 4);
+    appendBytes(data, key);
+    appendInt(data, candidates.size(), 8);
+    for (const std::string& candidate : candidates) {
+        if (candidate.size() > 0xffff) {
+            return false;
+        }
+        appendInt(data, candidate.size(), 2);
+        data += candidate;
+    }
+
+    // Readers never see a torn entry; a failed write only costs the cache entry
+    try {
+        writeFileAtomically(entryPath(key), data, "cache entry");
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,237 @@
+#include "schroeppel_shamir_strategy.h"
+#include "backtracking_strategy.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+/**
+ * One pair (outer[outerIndex], inner[innerIndex]) waiting in a heap
+ */
+struct PairCursor {
+    uint64_t sum;
+    size_t outerIndex;
+    size_t innerIndex;
+};
+
+/**
+ * Streams the pairwise sums of two sorted lists in ascending or descending order
+ *
+ * The heap holds one cursor per element of the outer list, so memory is linear in
+ * the list sizes while the stream visits |outer| * |inner| pairs.
+ */
+class PairSumStream {
+public:
+    PairSumStream(const std::vector<PartialSum>& outer, const std::vector<PartialSum>& inner,
+                  bool descending)
+        : outer(outer), inner(inner), descending(descending) {
+
+        if (inner.empty()) {
+            return;
+        }
+
+        heap.reserve(outer.size());
+        size_t start = descending ? inner.size() - 1 : 0;
+        for (size_t i = 0; i < outer.size(); ++i) {
+            heap.push_back({outer[i].sum + inner[start].sum, i, start});
+        }
+        std::make_heap(heap.begin(), heap.end(), comparator());
+    }
+
+    bool empty() const { return heap.empty(); }
+    const PairCursor& top() const { return heap.front(); }
+
+    /**
+     * @brief Drop the current pair and queue its successor in the same row
+     */
+    void advance() {
+        std::pop_heap(heap.begin(), heap.end(), comparator());
+        PairCursor& cursor = heap.back();
+
+        bool hasNext = descending ? cursor.innerIndex > 0 : cursor.innerIndex + 1 < inner.size();
+        if (!hasNext) {
+            heap.pop_back();
+            return;
+        }
+
+        cursor.innerIndex = descending ? cursor.innerIndex - 1 : cursor.innerIndex + 1;
+        cursor.sum = outer[cursor.outerIndex].sum + inner[cursor.innerIndex].sum;
+        std::push_heap(heap.begin(), heap.end(), comparator());
+    }
+
+    size_t memoryBytes() const { return heap.capacity() * sizeof(PairCursor); }
+
+private:
+    // std heaps keep the "largest" element on top
+    struct Compare {
+        bool descending;
+        bool operator()(const PairCursor& a, const PairCursor& b) const {
+            return descending ? a.sum < b.sum : a.sum > b.sum;
+        }
+    };
+
+    Compare comparator() const { return Compare{descending}; }
+
+    const std::vector<PartialSum>& outer;
+    const std::vector<PartialSum>& inner;
+    bool descending;
+    std::vector<PairCursor> heap;
+};
+
+} // namespace
+
+bool SchroeppelShamirStrategy::decrypt(
+    const mpz_class& targetSum,
+    const LookupTable& table,
+    unsigned int minLength,
+    unsigned int maxLength,
+    const SolutionVisitor& visit) {
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    bool completed = true;
+    combinationsChecked = 0;
+    memoryUsed = 0;
+    metrics.reset(getName());
+
+    if (table.empty() || targetSum < 0) {
+        return completed;
+    }
+
+    // Quarter lists hold 64-bit sums; wider tables go to the backtracking kernels
+    if (table.widthFor(maxLength) != ValueWidth::Native64) {
+        BacktrackingStrategy fallback;
+        fallback.setSearchControl(control);
+        completed = fallback.decrypt(targetSum, table, minLength, maxLength, visit);
+        absorbMetrics(fallback, true);
+    } else if (targetSum <= table.getMaxValue() * maxLength) {
+        const std::vector<uint64_t>& values = table.getNativeValues<uint64_t>();
+        uint64_t target = toNative<uint64_t>(targetSum);
+
+        for (unsigned int length = minLength; length <= maxLength; ++length) {
+            // Early pruning: check if target is achievable with this length
+            if (target > values.front() * length || target < values.back() * length) {
+                continue;
+            }
+            auto lengthStart = std::chrono::high_resolution_clock::now();
+            size_t stepsBefore = combinationsChecked;
+            uint64_t solutionsBefore = metrics.solutions;
+            completed = decryptLength(target, table, length, visit);
+            recordLength(length, lengthStart, combinationsChecked - stepsBefore,
+                         metrics.solutions - solutionsBefore);
+            if (!completed) {
+                break;
+            }
+        }
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+    finishMetrics();
+
+    return completed;
+}
+
+bool SchroeppelShamirStrategy::decryptLength(
+    uint64_t targetSum,
+    const LookupTable& table,
+    unsigned int length,
+    const SolutionVisitor& visit) {
+
+    const std::vector<uint64_t>& values = table.getNativeValues<uint64_t>();
+    const uint64_t minVal = values.back();
+    const uint64_t maxVal = values.front();
+
+    // Quarter sizes: A and B make up the first half, C and D the second
+    unsigned int firstHalf = length / 2;
+    unsigned int positions[4] = {
+        firstHalf / 2,
+        firstHalf - firstHalf / 2,
+        (length - firstHalf) / 2,
+        (length - firstHalf) - (length - firstHalf) / 2
+    };
+
+    if (!packedIndexFits(values.size(), positions[3])) {
+        BacktrackingStrategy fallback;
+        fallback.setSearchControl(control);
+        bool completed = fallback.decrypt(fromNative(targetSum), table, length, length, visit);
+        absorbMetrics(fallback, false);
+        return completed;
+    }
+
+    // Each quarter must leave a remainder the other three can produce
+    std::vector<PartialSum> quarters[4];
+    std::vector<PartialSum> scratch;
+    for (int q = 0; q < 4; ++q) {
+        unsigned int others = length - positions[q];
+        uint64_t low = targetSum > maxVal * others ? targetSum - maxVal * others : 0;
+        uint64_t high = std::min(targetSum - minVal * others, maxVal * positions[q]);
+
+        generatePartialSums(values, positions[q], low, high, quarters[q]);
+        radixSortPartialSums(quarters[q], scratch, low, high);
+        metrics.recordsGenerated += quarters[q].size();
+        if (pollControl(quarters[q].size())) {
+            return false;
+        }
+    }
+
+    PairSumStream left(quarters[0], quarters[1], false);
+    PairSumStream right(quarters[2], quarters[3], true);
+
+    size_t bytesInUse = left.memoryBytes() + right.memoryBytes() + scratch.capacity() * sizeof(PartialSum);
+    for (const auto& quarter : quarters) {
+        bytesInUse += quarter.capacity() * sizeof(PartialSum);
+    }
+    memoryUsed = std::max(memoryUsed, bytesInUse);
+
+    const uint64_t symbolCount = table.size();
+    std::vector<SymbolId> symbols(length);
+    std::string password;
+    std::vector<PairCursor> leftRun;
+    std::vector<PairCursor> rightRun;
+    unsigned int offsetB = positions[0];
+    unsigned int offsetC = offsetB + positions[1];
+    unsigned int offsetD = offsetC + positions[2];
+
+    while (!left.empty() && !right.empty()) {
+        uint64_t sum = left.top().sum + right.top().sum;
+        if ((++combinationsChecked & SearchControl::pollMask) == 0 && pollControl(SearchControl::pollInterval)) {
+            return false;
+        }
+
+        if (sum < targetSum) {
+            left.advance();
+        } else if (sum > targetSum) {
+            right.advance();
+        } else {
+            // Collect the equal-sum runs of both streams; every pairing is a solution
+            uint64_t leftSum = left.top().sum;
+            uint64_t rightSum = right.top().sum;
+            leftRun.clear();
+            rightRun.clear();
+            while (!left.empty() && left.top().sum == leftSum) {
+                leftRun.push_back(left.top());
+                left.advance();
+            }
+            while (!right.empty() && right.top().sum == rightSum) {
+                rightRun.push_back(right.top());
+                right.advance();
+            }
+
+            for (const PairCursor& a : leftRun) {
+                unpackSymbols(quarters[0][a.outerIndex].packed, positions[0], symbolCount, symbols.data());
+                unpackSymbols(quarters[1][a.innerIndex].packed, positions[1], symbolCount, symbols.data() + offsetB);
+                for (const PairCursor& b : rightRun) {
+                    unpackSymbols(quarters[2][b.outerIndex].packed, positions[2], symbolCount, symbols.data() + offsetC);
+                    unpackSymbols(quarters[3][b.innerIndex].packed, positions[3], symbolCount, symbols.data() + offsetD);
+                    table.spell(symbols.data(), symbols.size(), password);
+                    ++metrics.solutions;
+                    if (!visit(password)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
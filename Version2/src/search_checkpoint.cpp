@@ -0,0 +1,103 @@
+#include "search_checkpoint.h"
+#include "atomic_file.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const char* const header = "partition-checkpoint";
+
+/**
+ * @brief Read one "key value..." line and check its key
+ * @return Stream positioned after the key
+ */
+std::istringstream expectLine(std::istream& file, const std::string& key, const std::string& path) {
+    std::string line;
+    std::string found;
+    if (!std::getline(file, line)) {
+        throw std::runtime_error("Checkpoint " + path + " ends before '" + key + "'");
+    }
+    std::istringstream fields(line);
+    if (!(fields >> found) || found != key) {
+        throw std::runtime_error("Checkpoint " + path + ": expected '" + key + "', found '" + line + "'");
+    }
+    return fields;
+}
+
+template <typename T>
+T readField(std::istream& file, const std::string& key, const std::string& path) {
+    std::istringstream fields = expectLine(file, key, path);
+    T value;
+    if (!(fields >> value)) {
+        throw std::runtime_error("Checkpoint " + path + ": invalid value for '" + key + "'");
+    }
+    return value;
+}
+
+} // namespace
+
+void SearchCheckpoint::save(const std::string& path) const {
+    writeFileAtomically(path, [this](std::ostream& file) {
+        file << header << " " << formatVersion << "\n"
+             << "target " << target.get_str() << "\n"
+             << "lengths " << minLength << " " << maxLength << "\n"
+             << "table " << std::hex << tableFingerprint << std::dec << "\n"
+             << "multiset " << multiset << "\n"
+             << "length " << length << "\n"
+             << "symbols";
+        for (uint32_t symbol : symbols) {
+            file << " " << symbol;
+        }
+        file << "\n"
+             << "nodes " << nodes << "\n"
+             << "prunes " << prunes << "\n"
+             << "solutions " << solutions << "\n"
+             << "complete " << complete << "\n";
+    }, "checkpoint file");
+}
+
+SearchCheckpoint SearchCheckpoint::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Could not open checkpoint file: " + path);
+    }
+
+    if (readField<unsigned int>(file, header, path) != formatVersion) {
+        throw std::runtime_error("Checkpoint " + path + " has an unsupported format version");
+    }
+
+    SearchCheckpoint checkpoint;
+    if (checkpoint.target.set_str(readField<std::string>(file, "target", path), 10) != 0) {
+        throw std::runtime_error("Checkpoint " + path + ": invalid value for 'target'");
+    }
+    std::istringstream lengths = expectLine(file, "lengths", path);
+    if (!(lengths >> checkpoint.minLength >> checkpoint.maxLength)) {
+        throw std::runtime_error("Checkpoint " + path + ": invalid value for 'lengths'");
+    }
+    std::istringstream table = expectLine(file, "table", path);
+    if (!(table >> std::hex >> checkpoint.tableFingerprint)) {
+        throw std::runtime_error("Checkpoint " + path + ": invalid value for 'table'");
+    }
+    checkpoint.multiset = readField<bool>(file, "multiset", path);
+    checkpoint.length = readField<unsigned int>(file, "length", path);
+    std::istringstream symbols = expectLine(file, "symbols", path);
+    for (uint32_t symbol; symbols >> symbol;) {
+        checkpoint.symbols.push_back(symbol);
+    }
+    checkpoint.nodes = readField<uint64_t>(file, "nodes", path);
+    checkpoint.prunes = readField<uint64_t>(file, "prunes", path);
+    checkpoint.solutions = readField<uint64_t>(file, "solutions", path);
+    checkpoint.complete = readField<bool>(file, "complete", path);
+
+    if (checkpoint.minLength == 0 || checkpoint.minLength > checkpoint.maxLength ||
+        checkpoint.length < checkpoint.minLength || checkpoint.length > checkpoint.maxLength ||
+        checkpoint.symbols.size() > checkpoint.length) {
+        throw std::runtime_error("Checkpoint " + path + " describes an impossible search position");
+    }
+    return checkpoint;
+}
+
+uint64_t SearchCheckpoint::fingerprint(const LookupTable& table) {
+    return table.getFingerprint();
+}
@@ -0,0 +1,226 @@
+#include "search_constraints.h"
+#include "utf8.h"
+#include <stdexcept>
+
+namespace {
+
+const size_t maxRequiredSets = 32; // Bits of PositionConstraints::requirements
+
+const char* const lowerClass = "abcdefghijklmnopqrstuvwxyz";
+const char* const upperClass = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+const char* const digitClass = "0123456789";
+const char* const specialClass = " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+void appendClass(const char* members, std::vector<std::string>& symbols) {
+    for (const char* c = members; *c; ++c) {
+        symbols.emplace_back(1, *c);
+    }
+}
+
+/**
+ * @brief Split a fragment taken literally into its code points
+ */
+std::vector<std::string> splitFragment(const std::string& fragment) {
+    std::vector<std::string> symbols;
+    if (!splitUtf8(fragment, symbols)) {
+        throw std::invalid_argument("Constraint is not valid UTF-8: " + fragment);
+    }
+    return symbols;
+}
+
+/**
+ * @brief Mark the ids of a set's symbols that the table has
+ */
+void markSymbols(const LookupTable& table, const std::vector<std::string>& symbols, std::vector<uint8_t>& marks) {
+    marks.assign(table.size(), 0);
+    for (const std::string& symbol : symbols) {
+        size_t id = table.findSymbol(symbol);
+        if (id != maxSymbolCount) {
+            marks[id] = 1;
+        }
+    }
+}
+
+} // namespace
+
+void SearchConstraints::parseSet(const std::string& text, std::vector<std::string>& symbols,
+                                 std::vector<std::string>& literals) {
+    size_t position = 0;
+    uint32_t codePoint;
+    while (position < text.size()) {
+        if (text[position] == '?') {
+            if (position + 1 == text.size()) {
+                throw std::invalid_argument("Constraint ends in '?': " + text);
+            }
+            switch (text[position + 1]) {
+                case 'l': appendClass(lowerClass, symbols); break;
+                case 'u': appendClass(upperClass, symbols); break;
+                case 'd': appendClass(digitClass, symbols); break;
+                case 's': appendClass(specialClass, symbols); break;
+                case 'a':
+                    appendClass(lowerClass, symbols);
+                    appendClass(upperClass, symbols);
+                    appendClass(digitClass, symbols);
+                    appendClass(specialClass, symbols);
+                    break;
+                case '?':
+                    symbols.emplace_back("?");
+                    literals.emplace_back("?");
+                    break;
+                default:
+                    throw std::invalid_argument("Unknown symbol class ?" + std::string(1, text[position + 1]) +
+                                                " (use ?l, ?u, ?d, ?s, ?a or ?\?)");
+            }
+            position += 2;
+            continue;
+        }
+
+        size_t start = position;
+        if (!decodeUtf8(text, position, codePoint)) {
+            throw std::invalid_argument("Constraint is not valid UTF-8: " + text);
+        }
+        symbols.emplace_back(text, start, position - start);
+        literals.emplace_back(text, start, position - start);
+    }
+}
+
+void SearchConstraints::describeCall(const std::string& name, const std::string& value) {
+    // Length-prefixed so that no two different call sequences read the same
+    description += name + ":" + std::to_string(value.size()) + ":" + value + ";";
+}
+
+SearchConstraints& SearchConstraints::setMask(const std::string& mask) {
+    std::vector<std::vector<std::string>> sets;
+    std::vector<std::string> maskLiterals;
+    size_t position = 0;
+    while (position < mask.size()) {
+        // One token per position: a class, "??" or a single code point
+        size_t start = position;
+        uint32_t codePoint;
+        if (mask[position] == '?') {
+            position += 2;
+        } else if (!decodeUtf8(mask, position, codePoint)) {
+            throw std::invalid_argument("Mask is not valid UTF-8: " + mask);
+        }
+        sets.emplace_back();
+        parseSet(mask.substr(start, position - start), sets.back(), maskLiterals);
+    }
+    if (sets.empty()) {
+        throw std::invalid_argument("Mask is empty");
+    }
+
+    maskSets = std::move(sets);
+    literals.insert(literals.end(), maskLiterals.begin(), maskLiterals.end());
+    describeCall("mask", mask);
+    return *this;
+}
+
+SearchConstraints& SearchConstraints::setPrefix(const std::string& prefix) {
+    std::vector<std::string> symbols = splitFragment(prefix);
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        positionSets.emplace_back(static_cast<int>(i), std::vector<std::string>{symbols[i]});
+        literals.push_back(symbols[i]);
+    }
+    describeCall("prefix", prefix);
+    return *this;
+}
+
+SearchConstraints& SearchConstraints::setSuffix(const std::string& suffix) {
+    std::vector<std::string> symbols = splitFragment(suffix);
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        int fromEnd = -static_cast<int>(symbols.size() - i);
+        positionSets.emplace_back(fromEnd, std::vector<std::string>{symbols[i]});
+        literals.push_back(symbols[i]);
+    }
+    describeCall("suffix", suffix);
+    return *this;
+}
+
+SearchConstraints& SearchConstraints::restrictPosition(int position, const std::string& symbols) {
+    std::vector<std::string> set;
+    std::vector<std::string> setLiterals;
+    parseSet(symbols, set, setLiterals);
+    positionSets.emplace_back(position, std::move(set));
+    literals.insert(literals.end(), setLiterals.begin(), setLiterals.end());
+    describeCall("position" + std::to_string(position), symbols);
+    return *this;
+}
+
+SearchConstraints& SearchConstraints::exclude(const std::string& symbols) {
+    std::vector<std::string> set;
+    std::vector<std::string> ignoredLiterals; // Excluding a symbol the table lacks is harmless
+    parseSet(symbols, set, ignoredLiterals);
+    excluded.insert(excluded.end(), set.begin(), set.end());
+    describeCall("exclude", symbols);
+    return *this;
+}
+
+SearchConstraints& SearchConstraints::require(const std::string& symbols) {
+    if (required.size() == maxRequiredSets) {
+        throw std::invalid_argument("At most 32 symbol sets can be required");
+    }
+    std::vector<std::string> set;
+    std::vector<std::string> setLiterals;
+    parseSet(symbols, set, setLiterals);
+    required.push_back(std::move(set));
+    literals.insert(literals.end(), setLiterals.begin(), setLiterals.end());
+    describeCall("require", symbols);
+    return *this;
+}
+
+bool SearchConstraints::resolve(const LookupTable& table, unsigned int length, PositionConstraints& out) const {
+    for (const std::string& symbol : literals) {
+        if (table.findSymbol(symbol) == maxSymbolCount) {
+            throw std::invalid_argument("Constraint symbol '" + symbol + "' is not in the lookup table");
+        }
+    }
+    if (length == 0 || (!maskSets.empty() && maskSets.size() != length)) {
+        return false;
+    }
+
+    // Intersect everything that applies to a position, one mark per symbol id
+    std::vector<std::vector<uint8_t>> marks(length, std::vector<uint8_t>(table.size(), 1));
+    std::vector<uint8_t> set;
+    for (unsigned int p = 0; p < maskSets.size(); ++p) {
+        markSymbols(table, maskSets[p], set);
+        for (size_t id = 0; id < set.size(); ++id) {
+            marks[p][id] &= set[id];
+        }
+    }
+    for (const auto& positionSet : positionSets) {
+        long p = positionSet.first >= 0 ? positionSet.first : static_cast<long>(length) + positionSet.first;
+        if (p < 0 || p >= static_cast<long>(length)) {
+            return false; // A fragment longer than the password
+        }
+        markSymbols(table, positionSet.second, set);
+        for (size_t id = 0; id < set.size(); ++id) {
+            marks[p][id] &= set[id];
+        }
+    }
+    markSymbols(table, excluded, set);
+
+    out.allowed.assign(length, std::vector<SymbolId>());
+    for (unsigned int p = 0; p < length; ++p) {
+        for (size_t id = 0; id < table.size(); ++id) {
+            if (marks[p][id] && !set[id]) {
+                out.allowed[p].push_back(static_cast<SymbolId>(id));
+            }
+        }
+        if (out.allowed[p].empty()) {
+            return false;
+        }
+    }
+
+    out.requirementBits.assign(table.size(), 0);
+    out.requirements = 0;
+    for (size_t r = 0; r < required.size(); ++r) {
+        markSymbols(table, required[r], set);
+        for (size_t id = 0; id < set.size(); ++id) {
+            if (set[id]) {
+                out.requirementBits[id] |= uint32_t(1) << r;
+            }
+        }
+        out.requirements |= uint32_t(1) << r;
+    }
+    return true;
+}
@@ -0,0 +1,180 @@
+#include "search_metrics.h"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+/**
+ * @brief Quote a string for JSON or a Prometheus label value
+ */
+std::string quote(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (c == '\n') {
+            quoted += "\\n";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+} // namespace
+
+void SearchMetrics::reset(const std::string& strategyName) {
+    *this = SearchMetrics();
+    strategy = strategyName;
+}
+
+void SearchMetrics::merge(const SearchMetrics& other) {
+    nodes += other.nodes;
+    solutions += other.solutions;
+    peakBytes = std::max(peakBytes, other.peakBytes);
+    recordsGenerated += other.recordsGenerated;
+    bytesSpilled += other.bytesSpilled;
+    boundPrunes += other.boundPrunes;
+    reachabilityPrunes += other.reachabilityPrunes;
+
+    if (nodesPerDepth.size() < other.nodesPerDepth.size()) {
+        nodesPerDepth.resize(other.nodesPerDepth.size(), 0);
+    }
+    for (size_t depth = 0; depth < other.nodesPerDepth.size(); ++depth) {
+        nodesPerDepth[depth] += other.nodesPerDepth[depth];
+    }
+
+    for (const LengthMetrics& entry : other.lengths) {
+        addLength(entry.length, entry.milliseconds, entry.nodes, entry.solutions);
+    }
+}
+
+void SearchMetrics::addLength(unsigned int length, double lengthMilliseconds, uint64_t lengthNodes,
+                              uint64_t lengthSolutions) {
+    auto entry = std::find_if(lengths.begin(), lengths.end(),
+                              [length](const LengthMetrics& e) { return e.length == length; });
+    if (entry == lengths.end()) {
+        lengths.push_back(LengthMetrics());
+        entry = lengths.end() - 1;
+        entry->length = length;
+    }
+    entry->milliseconds += lengthMilliseconds;
+    entry->nodes += lengthNodes;
+    entry->solutions += lengthSolutions;
+}
+
+double SearchMetrics::nodesPerSecond() const {
+    return milliseconds > 0.0 ? nodes / (milliseconds / 1000.0) : 0.0;
+}
+
+double SearchMetrics::solutionsPerSecond() const {
+    return milliseconds > 0.0 ? solutions / (milliseconds / 1000.0) : 0.0;
+}
+
+std::string SearchMetrics::toJson() const {
+    std::ostringstream json;
+    json << "{\"strategy\":" << quote(strategy)
+         << ",\"duration_ms\":" << milliseconds
+         << ",\"nodes\":" << nodes
+         << ",\"nodes_per_second\":" << nodesPerSecond()
+         << ",\"solutions\":" << solutions
+         << ",\"solutions_per_second\":" << solutionsPerSecond()
+         << ",\"peak_bytes\":" << peakBytes
+         << ",\"records_generated\":" << recordsGenerated
+         << ",\"bytes_spilled\":" << bytesSpilled
+         << ",\"prunes\":{\"bound\":" << boundPrunes
+         << ",\"reachability\":" << reachabilityPrunes << "}"
+         << ",\"nodes_per_depth\":[";
+    for (size_t depth = 0; depth < nodesPerDepth.size(); ++depth) {
+        json << (depth ? "," : "") << nodesPerDepth[depth];
+    }
+    json << "],\"lengths\":[";
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        const LengthMetrics& entry = lengths[i];
+        json << (i ? "," : "")
+             << "{\"length\":" << entry.length
+             << ",\"duration_ms\":" << entry.milliseconds
+             << ",\"nodes\":" << entry.nodes
+             << ",\"solutions\":" << entry.solutions << "}";
+    }
+    json << "]}";
+    return json.str();
+}
+
+std::string SearchMetrics::toPrometheus(const std::string& prefix) const {
+    std::ostringstream text;
+    std::string label = "strategy=" + quote(strategy);
+
+    auto gauge = [&](const std::string& name, const std::string& help) {
+        text << "# HELP " << prefix << "_" << name << " " << help << "\n"
+             << "# TYPE " << prefix << "_" << name << " gauge\n";
+    };
+
+    gauge("duration_seconds", "Wall time of the last decryption");
+    text << prefix << "_duration_seconds{" << label << "} " << milliseconds / 1000.0 << "\n";
+
+    gauge("nodes", "Search nodes visited by the last decryption");
+    text << prefix << "_nodes{" << label << "} " << nodes << "\n";
+
+    gauge("nodes_per_second", "Search node throughput of the last decryption");
+    text << prefix << "_nodes_per_second{" << label << "} " << nodesPerSecond() << "\n";
+
+    gauge("solutions", "Candidates found by the last decryption");
+    text << prefix << "_solutions{" << label << "} " << solutions << "\n";
+
+    gauge("peak_bytes", "Peak working memory of the last decryption");
+    text << prefix << "_peak_bytes{" << label << "} " << peakBytes << "\n";
+
+    gauge("records_generated", "Partial-sum records built by the last decryption");
+    text << prefix << "_records_generated{" << label << "} " << recordsGenerated << "\n";
+
+    gauge("bytes_spilled", "Run-file bytes written to disk by the last decryption");
+    text << prefix << "_bytes_spilled{" << label << "} " << bytesSpilled << "\n";
+
+    gauge("prunes", "Subtrees cut by the last decryption, by reason");
+    text << prefix << "_prunes{" << label << ",reason=\"bound\"} " << boundPrunes << "\n"
+         << prefix << "_prunes{" << label << ",reason=\"reachability\"} " << reachabilityPrunes << "\n";
+
+    if (!nodesPerDepth.empty()) {
+        gauge("depth_nodes", "Search nodes of the last decryption by prefix length");
+        for (size_t depth = 0; depth < nodesPerDepth.size(); ++depth) {
+            text << prefix << "_depth_nodes{" << label << ",depth=\"" << depth << "\"} "
+                 << nodesPerDepth[depth] << "\n";
+        }
+    }
+
+    if (!lengths.empty()) {
+        gauge("length_duration_seconds", "Wall time spent on each password length");
+        for (const LengthMetrics& entry : lengths) {
+            text << prefix << "_length_duration_seconds{" << label << ",length=\"" << entry.length
+                 << "\"} " << entry.milliseconds / 1000.0 << "\n";
+        }
+        gauge("length_solutions", "Candidates found for each password length");
+        for (const LengthMetrics& entry : lengths) {
+            text << prefix << "_length_solutions{" << label << ",length=\"" << entry.length
+                 << "\"} " << entry.solutions << "\n";
+        }
+    }
+
+    return text.str();
+}
+
+void MetricCounters::addTo(SearchMetrics& metrics) const {
+#if PARTITION_ENABLE_METRICS
+    size_t used = maxDepth;
+    while (used > 0 && nodesPerDepth[used - 1] == 0) {
+        --used;
+    }
+    if (metrics.nodesPerDepth.size() < used) {
+        metrics.nodesPerDepth.resize(used, 0);
+    }
+    for (size_t depth = 0; depth < used; ++depth) {
+        metrics.nodesPerDepth[depth] += nodesPerDepth[depth];
+    }
+    metrics.boundPrunes += boundPrunes;
+    metrics.reachabilityPrunes += reachabilityPrunes;
+#else
+    (void)metrics;
+#endif
+}
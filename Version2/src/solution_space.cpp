@@ -0,0 +1,410 @@
+#include "solution_space.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * @brief Index of the first value not larger than need in a descending list
+ */
+size_t firstAtMost(const std::vector<uint64_t>& values, uint64_t need) {
+    return std::lower_bound(values.begin(), values.end(), need, std::greater<uint64_t>()) - values.begin();
+}
+
+/**
+ * @brief Add x to sum
+ * @return False if the unsigned addition wrapped around
+ */
+template <typename Count>
+bool addChecked(Count& sum, const Count& x) {
+    sum += x;
+    return sum >= x;
+}
+
+template <typename Count>
+Count narrow(const mpz_class& value) {
+    return toNative<Count>(value);
+}
+
+template <>
+mpz_class narrow<mpz_class>(const mpz_class& value) {
+    return value;
+}
+
+template <typename Count>
+mpz_class widen(const Count& value) {
+    return fromNative<Count>(value);
+}
+
+template <>
+mpz_class widen<mpz_class>(const mpz_class& value) {
+    return value;
+}
+
+} // namespace
+
+template <>
+std::vector<std::vector<uint64_t>>& SolutionSpace::rows<uint64_t>() {
+    return rows64;
+}
+
+template <>
+const std::vector<std::vector<uint64_t>>& SolutionSpace::rows<uint64_t>() const {
+    return rows64;
+}
+
+#ifdef PARTITION_HAVE_INT128
+template <>
+std::vector<std::vector<uint128_t>>& SolutionSpace::rows<uint128_t>() {
+    return rows128;
+}
+
+template <>
+const std::vector<std::vector<uint128_t>>& SolutionSpace::rows<uint128_t>() const {
+    return rows128;
+}
+#endif
+
+template <>
+std::vector<std::vector<mpz_class>>& SolutionSpace::rows<mpz_class>() {
+    return rowsGmp;
+}
+
+template <>
+const std::vector<std::vector<mpz_class>>& SolutionSpace::rows<mpz_class>() const {
+    return rowsGmp;
+}
+
+SolutionSpace::SolutionSpace(const mpz_class& targetSum,
+                             const LookupTable& table,
+                             unsigned int minLength,
+                             unsigned int maxLength)
+    : minLength(minLength), maxLength(maxLength) {
+    if (table.empty()) {
+        throw std::invalid_argument("Lookup table is empty");
+    }
+    if (minLength == 0 || minLength > maxLength || maxLength > table.getMaxLength()) {
+        throw std::invalid_argument("Invalid length range for solution space");
+    }
+    if (table.widthFor(maxLength) != ValueWidth::Native64) {
+        throw std::runtime_error("Solution space needs sums that fit in 64 bits");
+    }
+
+    values = table.getNativeValues<uint64_t>();
+    symbolTable = table;
+    minVal = values.back();
+    maxVal = values.front();
+    lengthCounts.assign(maxLength - minLength + 1, 0);
+
+    // A negative or oversized target simply has no solutions
+    if (targetSum < 0 || targetSum > mpz_class(maxVal) * maxLength) {
+        return;
+    }
+    target = toNative<uint64_t>(targetSum);
+
+    // Row r only needs the sums left after placing maxLength - r symbols or fewer
+    rowStart.assign(maxLength, 0);
+    for (unsigned int r = 0; r < maxLength; ++r) {
+        uint64_t placedMax = maxVal * (maxLength - r);
+        rowStart[r] = std::max(minVal * r, target > placedMax ? target - placedMax : 0);
+    }
+
+    // Counts grow with length, so try the cheapest width first and widen on overflow
+    if (buildRows<uint64_t>()) {
+        countWidth = ValueWidth::Native64;
+    }
+#ifdef PARTITION_HAVE_INT128
+    else if (buildRows<uint128_t>()) {
+        countWidth = ValueWidth::Native128;
+    }
+#endif
+    else {
+        buildRows<mpz_class>();
+        countWidth = ValueWidth::Arbitrary;
+    }
+
+    for (const mpz_class& count : lengthCounts) {
+        total += count;
+    }
+}
+
+template <typename Count>
+bool SolutionSpace::buildRows() {
+    std::vector<std::vector<Count>>& table = rows<Count>();
+    table.assign(maxLength, std::vector<Count>());
+
+    for (unsigned int r = 0; r < maxLength; ++r) {
+        uint64_t rowEnd = std::min(maxVal * r, target);
+        if (rowStart[r] > rowEnd) {
+            continue; // No sum in the band; every lookup reads zero
+        }
+        std::vector<Count>& row = table[r];
+        row.resize(rowEnd - rowStart[r] + 1, Count(0));
+        if (r == 0) {
+            row[0] = 1;
+            continue;
+        }
+
+        // Like the reachability index: add one shifted copy of row r-1 per value
+        const std::vector<Count>& previous = table[r - 1];
+        if (previous.empty()) {
+            continue;
+        }
+        uint64_t previousStart = rowStart[r - 1];
+        uint64_t previousEnd = previousStart + previous.size() - 1;
+        bool overflow = false;
+        for (uint64_t value : values) {
+            uint64_t from = std::max(rowStart[r], previousStart + value);
+            uint64_t to = std::min(rowEnd, previousEnd + value);
+            if (from > to) {
+                continue;
+            }
+            Count* out = &row[from - rowStart[r]];
+            const Count* in = &previous[from - value - previousStart];
+            for (uint64_t n = to - from + 1, k = 0; k < n; ++k) {
+                overflow |= !addChecked(out[k], in[k]);
+            }
+        }
+        if (overflow) {
+            table.clear();
+            return false;
+        }
+    }
+
+    for (unsigned int length = minLength; length <= maxLength; ++length) {
+        Count count = 0;
+        if (!sumChildren<Count>(length, target, count)) {
+            table.clear();
+            return false;
+        }
+        lengthCounts[length - minLength] = widen<Count>(count);
+    }
+    return true;
+}
+
+template <typename Count>
+bool SolutionSpace::sumChildren(unsigned int r, uint64_t need, Count& sum) const {
+    const std::vector<Count>& row = rows<Count>()[r - 1];
+    uint64_t lo = rowStart[r - 1];
+    if (row.empty() || need < lo) {
+        return true;
+    }
+    uint64_t hi = lo + row.size() - 1;
+    for (size_t i = firstAtMost(values, need - lo); i < values.size(); ++i) {
+        uint64_t rest = need - values[i];
+        if (rest > hi) {
+            break; // Values only get smaller from here
+        }
+        if (!addChecked(sum, row[rest - lo])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Count>
+const Count* SolutionSpace::ways(unsigned int r, uint64_t need) const {
+    const std::vector<Count>& row = rows<Count>()[r];
+    if (need < rowStart[r] || need - rowStart[r] >= row.size()) {
+        return nullptr;
+    }
+    return &row[need - rowStart[r]];
+}
+
+mpz_class SolutionSpace::sizeOfLength(unsigned int length) const {
+    if (length < minLength || length > maxLength) {
+        return 0;
+    }
+    return lengthCounts[length - minLength];
+}
+
+template <typename Count>
+bool SolutionSpace::walk(unsigned int r, uint64_t need, Count& offset, const Count& begin, const Count& end,
+                         std::vector<SymbolId>& path, std::string& password,
+                         const SolutionVisitor& visit) const {
+    if (r == 0) {
+        ++offset;
+        symbolTable.spell(path.data(), path.size(), password);
+        return visit(password);
+    }
+
+    const std::vector<Count>& row = rows<Count>()[r - 1];
+    uint64_t lo = rowStart[r - 1];
+    if (row.empty() || need < lo) {
+        return true;
+    }
+    uint64_t hi = lo + row.size() - 1;
+    for (size_t i = firstAtMost(values, need - lo); i < values.size(); ++i) {
+        if (offset >= end) {
+            return true;
+        }
+        uint64_t rest = need - values[i];
+        if (rest > hi) {
+            break;
+        }
+        const Count& count = row[rest - lo];
+        if (count == 0) {
+            continue;
+        }
+        if (offset + count <= begin) {
+            offset += count; // Whole subtree lies before the slice
+            continue;
+        }
+        path.push_back(static_cast<SymbolId>(i));
+        bool keepGoing = walk<Count>(r - 1, rest, offset, begin, end, path, password, visit);
+        path.pop_back();
+        if (!keepGoing) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Count>
+bool SolutionSpace::enumerateLength(unsigned int length, const mpz_class& begin, const mpz_class& end,
+                                    const SolutionVisitor& visit) const {
+    // Ranks relative to the first solution of this length always fit in Count
+    const mpz_class& count = lengthCounts[length - minLength];
+    Count first = narrow<Count>(begin < 0 ? mpz_class(0) : mpz_class(begin));
+    Count last = narrow<Count>(end > count ? count : end);
+    Count offset = 0;
+
+    std::vector<SymbolId> path;
+    path.reserve(length);
+    std::string password;
+    return walk<Count>(length, target, offset, first, last, path, password, visit);
+}
+
+bool SolutionSpace::enumerate(const mpz_class& begin, const mpz_class& end,
+                              const SolutionVisitor& visit) const {
+    mpz_class offset = 0;
+    for (unsigned int length = minLength; length <= maxLength && offset < end; ++length) {
+        const mpz_class& count = lengthCounts[length - minLength];
+        if (count == 0 || offset + count <= begin) {
+            offset += count;
+            continue;
+        }
+
+        mpz_class lengthBegin = begin - offset;
+        mpz_class lengthEnd = end - offset;
+        bool completed;
+        switch (countWidth) {
+            case ValueWidth::Native64:
+                completed = enumerateLength<uint64_t>(length, lengthBegin, lengthEnd, visit);
+                break;
+#ifdef PARTITION_HAVE_INT128
+            case ValueWidth::Native128:
+                completed = enumerateLength<uint128_t>(length, lengthBegin, lengthEnd, visit);
+                break;
+#endif
+            default:
+                completed = enumerateLength<mpz_class>(length, lengthBegin, lengthEnd, visit);
+                break;
+        }
+        if (!completed) {
+            return false;
+        }
+        offset += count;
+    }
+    return true;
+}
+
+std::string SolutionSpace::unrank(const mpz_class& index) const {
+    if (index < 0 || index >= total) {
+        throw std::out_of_range("Rank outside the solution space");
+    }
+    std::string found;
+    enumerate(index, index + 1, [&found](const std::string& password) {
+        found = password;
+        return false;
+    });
+    return found;
+}
+
+template <typename Count>
+void SolutionSpace::addPreceding(unsigned int r, uint64_t need, size_t symbol, mpz_class& offset) const {
+    for (size_t i = firstAtMost(values, need); i < symbol; ++i) {
+        const Count* count = ways<Count>(r - 1, need - values[i]);
+        if (count) {
+            offset += widen<Count>(*count);
+        }
+    }
+}
+
+mpz_class SolutionSpace::rank(const std::string& password) const {
+    std::vector<SymbolId> symbols;
+    if (!symbolTable.parse(password, symbols)) {
+        throw std::invalid_argument("Password contains a character outside the lookup table");
+    }
+    unsigned int length = static_cast<unsigned int>(symbols.size());
+    if (length < minLength || length > maxLength) {
+        throw std::invalid_argument("Password length outside the solution space");
+    }
+    if (total == 0) {
+        throw std::invalid_argument("Password does not encrypt to the target");
+    }
+
+    mpz_class offset = 0;
+    for (unsigned int shorter = minLength; shorter < length; ++shorter) {
+        offset += lengthCounts[shorter - minLength];
+    }
+
+    // Add every subtree that precedes the password's own branch at each depth
+    uint64_t need = target;
+    for (unsigned int position = 0; position < length; ++position) {
+        size_t symbol = symbols[position];
+        if (values[symbol] > need) {
+            throw std::invalid_argument("Password does not encrypt to the target");
+        }
+
+        unsigned int r = length - position;
+        switch (countWidth) {
+            case ValueWidth::Native64:
+                addPreceding<uint64_t>(r, need, symbol, offset);
+                break;
+#ifdef PARTITION_HAVE_INT128
+            case ValueWidth::Native128:
+                addPreceding<uint128_t>(r, need, symbol, offset);
+                break;
+#endif
+            default:
+                addPreceding<mpz_class>(r, need, symbol, offset);
+                break;
+        }
+        need -= values[symbol];
+    }
+    if (need != 0) {
+        throw std::invalid_argument("Password does not encrypt to the target");
+    }
+    return offset;
+}
+
+std::pair<mpz_class, mpz_class> SolutionSpace::shard(unsigned int index, unsigned int count) const {
+    if (index >= count) {
+        throw std::invalid_argument("Shard index must be below the shard count");
+    }
+    mpz_class begin = total * index / count;
+    mpz_class end = total * (index + 1) / count;
+    return {begin, end};
+}
+
+size_t SolutionSpace::getMemoryBytes() const {
+    size_t bytes = values.capacity() * sizeof(uint64_t) + symbolTable.size() * sizeof(std::string) +
+                   rowStart.capacity() * sizeof(uint64_t) + lengthCounts.capacity() * sizeof(mpz_class);
+    for (const auto& row : rows64) {
+        bytes += row.capacity() * sizeof(uint64_t);
+    }
+#ifdef PARTITION_HAVE_INT128
+    for (const auto& row : rows128) {
+        bytes += row.capacity() * sizeof(uint128_t);
+    }
+#endif
+    for (const auto& row : rowsGmp) {
+        bytes += row.capacity() * sizeof(mpz_class);
+        for (const mpz_class& count : row) {
+            bytes += mpz_size(count.get_mpz_t()) * sizeof(mp_limb_t);
+        }
+    }
+    return bytes;
+}
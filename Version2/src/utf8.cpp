@@ -0,0 +1,69 @@
+#include "utf8.h"
+
+bool decodeUtf8(const char* text, size_t size, size_t& position, uint32_t& codePoint) {
+    if (position >= size) {
+        return false;
+    }
+
+    unsigned char lead = static_cast<unsigned char>(text[position]);
+    size_t length;
+    uint32_t value;
+    uint32_t smallest; // Smallest code point that needs this many bytes
+    if (lead < 0x80) {
+        codePoint = lead;
+        ++position;
+        return true;
+    } else if ((lead & 0xe0) == 0xc0) {
+        length = 2;
+        value = lead & 0x1f;
+        smallest = 0x80;
+    } else if ((lead & 0xf0) == 0xe0) {
+        length = 3;
+        value = lead & 0x0f;
+        smallest = 0x800;
+    } else if ((lead & 0xf8) == 0xf0) {
+        length = 4;
+        value = lead & 0x07;
+        smallest = 0x10000;
+    } else {
+        return false; // Continuation byte or invalid lead
+    }
+
+    if (size - position < length) {
+        return false;
+    }
+    for (size_t i = 1; i < length; ++i) {
+        unsigned char next = static_cast<unsigned char>(text[position + i]);
+        if ((next & 0xc0) != 0x80) {
+            return false;
+        }
+        value = (value << 6) | (next & 0x3f);
+    }
+    if (value < smallest || value > 0x10ffff || (value >= 0xd800 && value <= 0xdfff)) {
+        return false;
+    }
+
+    codePoint = value;
+    position += length;
+    return true;
+}
+
+bool splitUtf8(const std::string& text, std::vector<std::string>& codePoints) {
+    codePoints.clear();
+    size_t position = 0;
+    uint32_t codePoint;
+    while (position < text.size()) {
+        size_t start = position;
+        if (!decodeUtf8(text, position, codePoint)) {
+            return false;
+        }
+        codePoints.emplace_back(text, start, position - start);
+    }
+    return true;
+}
+
+bool isSingleCodePoint(const std::string& text) {
+    size_t position = 0;
+    uint32_t codePoint;
+    return decodeUtf8(text, position, codePoint) && position == text.size();
+}
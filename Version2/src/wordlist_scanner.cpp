@@ -0,0 +1,240 @@
+#include "wordlist_scanner.h"
+#include "lookup_table.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define WORDLIST_SCANNER_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Bytes per task; chunks are extended to the next newline
+const size_t chunkBytes = size_t(4) << 20;
+
+// Lines encrypted per BulkEncoder::encryptLines() call
+const size_t linesPerBlock = 4096;
+
+/**
+ * @brief Read-only view of a whole file, mapped where possible
+ */
+class FileView {
+public:
+    explicit FileView(const std::string& path) {
+#ifdef WORDLIST_SCANNER_HAVE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open wordlist: " + path);
+        }
+        struct stat status;
+        if (::fstat(fd, &status) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not open wordlist: " + path);
+        }
+        size = static_cast<size_t>(status.st_size);
+        if (size > 0) {
+            void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Could not map wordlist: " + path);
+            }
+            mapped = static_cast<const char*>(mapping);
+#ifdef MADV_SEQUENTIAL
+            // Every chunk is read front to back once
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+#endif
+        }
+        ::close(fd);
+        data = mapped;
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("Could not open wordlist: " + path);
+        }
+        copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data = copy.data();
+        size = copy.size();
+#endif
+    }
+
+    ~FileView() {
+#ifdef WORDLIST_SCANNER_HAVE_MMAP
+        if (mapped) {
+            ::munmap(const_cast<char*>(mapped), size);
+        }
+#endif
+    }
+
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+
+    const char* data = nullptr;
+    size_t size = 0;
+
+private:
+    const char* mapped = nullptr;   // Mapping to release, if any
+    std::vector<char> copy;         // Holds the file where it cannot be mapped
+};
+
+/**
+ * @brief Keep the targets an encrypted value of this encoder can equal
+ */
+std::vector<uint64_t> nativeTargets(const std::vector<mpz_class>& targets) {
+    std::vector<uint64_t> values;
+    values.reserve(targets.size());
+    for (const mpz_class& target : targets) {
+        if (target >= 0 && mpz_sizeinbase(target.get_mpz_t(), 2) <= 64) {
+            values.push_back(toNative<uint64_t>(target));
+        }
+    }
+    return values;
+}
+
+} // namespace
+
+TargetSet::TargetSet(std::vector<uint64_t> values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    tree.assign(values.size() + 1, 0);
+    size_t next = 0;
+    fill(values, next, 1);
+
+    // Power-of-two filter with at least 16 bits per value
+    size_t bits = 64;
+    filterShift = 58;
+    while (bits < values.size() * 16) {
+        bits <<= 1;
+        --filterShift;
+    }
+    filter.assign(bits / 64, 0);
+    for (uint64_t value : values) {
+        uint64_t slot = (value * 0x9E3779B97F4A7C15ull) >> filterShift;
+        filter[slot >> 6] |= uint64_t(1) << (slot & 63);
+    }
+}
+
+void TargetSet::fill(const std::vector<uint64_t>& sorted, size_t& next, size_t k) {
+    // In-order walk of the implicit tree assigns the sorted values in order
+    if (k < tree.size()) {
+        fill(sorted, next, 2 * k);
+        tree[k] = sorted[next++];
+        fill(sorted, next, 2 * k + 1);
+    }
+}
+
+WordlistScanner::WordlistScanner(const PartitionEncryption& system, const std::vector<mpz_class>& targets)
+    : encoder(system.getBulkEncoder()), targets(nativeTargets(targets)) {
+    if (!encoder.isAvailable()) {
+        throw std::runtime_error("Wordlist scans need every encrypted value to fit in 64 bits");
+    }
+}
+
+ScanStats WordlistScanner::scanFile(const std::string& path, const ScanVisitor& visit, unsigned int threads) {
+    FileView file(path);
+    return scan(file.data, file.size, visit, threads);
+}
+
+ScanStats WordlistScanner::scan(const char* data, size_t size, const ScanVisitor& visit, unsigned int threads) {
+    auto start = std::chrono::steady_clock::now();
+    ScanStats stats;
+    std::mutex mutex;           // Guards stats and the visitor
+    bool stopped = false;
+
+    // Scan [begin, end) and hand its matches over in one piece
+    auto scanChunk = [&](size_t begin, size_t end) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopped) {
+                return;
+            }
+        }
+
+        uint64_t words = 0;
+        uint64_t encrypted = 0;
+        std::vector<std::pair<uint64_t, std::string>> matches;
+        std::vector<EncodedLine> lines(linesPerBlock);
+        for (size_t position = begin; position < end;) {
+            size_t consumed;
+            size_t count = encoder.encryptLines(data + position, end - position, lines.data(), lines.size(),
+                                                consumed);
+            for (size_t k = 0; k < count; ++k) {
+                const EncodedLine& line = lines[k];
+                if (line.length == 0) {
+                    continue;
+                }
+                ++words;
+                if (line.status != EncryptStatus::Ok) {
+                    continue;
+                }
+                ++encrypted;
+                if (targets.contains(line.encrypted)) {
+                    matches.emplace_back(line.encrypted, std::string(data + position + line.begin, line.length));
+                }
+            }
+            position += consumed;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.bytes += end - begin;
+        stats.words += words;
+        stats.encrypted += encrypted;
+        for (const auto& match : matches) {
+            if (stopped) {
+                break;
+            }
+            ++stats.matches;
+            bool keepGoing;
+            try {
+                keepGoing = visit(match.first, match.second);
+            } catch (...) {
+                // Remaining chunks return at once; the pool rethrows from wait()
+                stopped = true;
+                throw;
+            }
+            if (!keepGoing) {
+                stopped = true;
+            }
+        }
+    };
+
+    // Newline-aligned chunk boundaries
+    std::vector<std::pair<size_t, size_t>> chunks;
+    for (size_t begin = 0; begin < size;) {
+        size_t end = std::min(size, begin + chunkBytes);
+        if (end < size) {
+            const char* newline = static_cast<const char*>(std::memchr(data + end, '\n', size - end));
+            end = newline ? static_cast<size_t>(newline - data) + 1 : size;
+        }
+        chunks.emplace_back(begin, end);
+        begin = end;
+    }
+
+    if (threads == 1 || chunks.size() <= 1) {
+        for (const auto& chunk : chunks) {
+            scanChunk(chunk.first, chunk.second);
+        }
+    } else {
+        if (!pool || (threads != 0 && pool->size() != threads)) {
+            pool = std::make_shared<WorkStealingPool>(threads);
+        }
+        for (const auto& chunk : chunks) {
+            pool->submit([&scanChunk, chunk](unsigned int) { scanChunk(chunk.first, chunk.second); });
+        }
+        pool->wait();
+    }
+
+    stats.completed = !stopped;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,133 @@
+#include "work_stealing_pool.h"
+#include <algorithm>
+
+namespace {
+
+// Identifies the pool and worker running on the current thread, if any
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local unsigned int currentWorker = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    threads.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        stopping = true;
+    }
+    idleCondition.notify_all();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    pending.fetch_add(1);
+
+    unsigned int id;
+    if (currentPool == this) {
+        id = currentWorker;
+    } else {
+        id = nextWorker.fetch_add(1) % size();
+    }
+    push(id, std::move(task));
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(idleMutex);
+    doneCondition.wait(lock, [this] { return pending.load() == 0; });
+    if (failure) {
+        std::exception_ptr rethrown = failure;
+        failure = nullptr;
+        std::rethrow_exception(rethrown);
+    }
+}
+
+void WorkStealingPool::push(unsigned int id, Task task) {
+    // Count the task before it becomes visible so `queued` never underflows;
+    // taking idleMutex orders the increment against a worker about to sleep
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        queued.fetch_add(1);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workers[id]->mutex);
+        workers[id]->tasks.push_back(std::move(task));
+    }
+    idleCondition.notify_one();
+}
+
+bool WorkStealingPool::takeTask(unsigned int id, Task& task) {
+    // Own deque first, newest task (depth-first)
+    {
+        std::lock_guard<std::mutex> lock(workers[id]->mutex);
+        if (!workers[id]->tasks.empty()) {
+            task = std::move(workers[id]->tasks.back());
+            workers[id]->tasks.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Then steal the oldest task of another worker
+    for (unsigned int offset = 1; offset < size(); ++offset) {
+        Worker& victim = *workers[(id + offset) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::workerLoop(unsigned int id) {
+    currentPool = this;
+    currentWorker = id;
+
+    while (true) {
+        Task task;
+        if (takeTask(id, task)) {
+            try {
+                task(id);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(idleMutex);
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+            }
+
+            if (pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(idleMutex);
+                doneCondition.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idleMutex);
+        idleCondition.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,825 @@
+/**
+ * @file benchmark.cpp
+ * @brief Reproducible benchmark of table loading, encryption and every decryption strategy
+ *
+ * Passwords are drawn from a seeded generator, so two runs with the same options
+ * time exactly the same workload. Each strategy decrypts the same passwords for
+ * every length from 1 to --max-length and must recover the original password.
+ * The solution_space workload builds the ranking tables of the same targets and
+ * must map every password to its rank and back. The result_cache workload times
+ * repeat queries answered by the result cache, which must return the password.
+ *
+ * Options:
+ *   --table PATH          Lookup table CSV (default: data/lookup_table.csv of the source tree)
+ *   --max-length N        Longest password length to decrypt (default 5)
+ *   --samples N           Passwords per length, and rounds of the other workloads (default 15)
+ *   --seed N              Seed of the password generator (default 1)
+ *   --max-solutions N     Stop a query after this many candidates (default 100000)
+ *   --strategies A,B      Only run these strategies (see --list)
+ *   --list                Print the registered strategies and exit
+ *   --json PATH           Write the results as JSON
+ *   --baseline PATH       Compare medians with a JSON file written by an earlier run
+ *   --tolerance X         Allowed relative slowdown before flagging a regression (default 0.25)
+ *   --min-delta-ms X      Ignore slowdowns smaller than this many milliseconds (default 0.05)
+ *
+ * Only workloads with at least 5 samples are compared with the baseline; the
+ * median of fewer runs is too noisy for the tolerance. Strategy setups are a
+ * single run and are never compared. Index and spill files of the inverse-index
+ * and mitm-spill strategies go to a temporary directory removed on exit.
+ *
+ * Exit status: 0 on success, 1 if a strategy missed a password or an option is
+ * invalid, 2 if the baseline comparison found a regression.
+ */
+
+#include "partition_encryption.h"
+#include "backtracking_strategy.h"
+#include "hybrid_strategy.h"
+#include "inverse_index.h"
+#include "inverse_index_strategy.h"
+#include "mitm_strategy.h"
+#include "schroeppel_shamir_strategy.h"
+#include "result_cache.h"
+#include "solution_space.h"
+#include <dirent.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef BENCHMARK_DEFAULT_TABLE
+#define BENCHMARK_DEFAULT_TABLE "data/lookup_table.csv"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Fewer samples than this give a median too noisy to compare with a baseline
+const size_t minBaselineSamples = 5;
+
+/**
+ * @struct Options
+ * @brief Command line settings
+ */
+struct Options {
+    std::string tablePath = BENCHMARK_DEFAULT_TABLE;
+    unsigned int maxLength = 5;
+    unsigned int samples = 15;
+    uint64_t seed = 1;
+    size_t maxSolutions = 100000;
+    std::vector<std::string> strategies;     // Empty = all registered strategies
+    std::string jsonPath;
+    std::string baselinePath;
+    double tolerance = 0.25;
+    double minDeltaMs = 0.05;
+    bool list = false;
+};
+
+/**
+ * @struct StrategyEntry
+ * @brief A benchmarked strategy configuration
+ */
+struct StrategyEntry {
+    std::string key;                                              // Short name used on the command line
+    // Receives the prepared table and a scratch directory for index and spill files
+    std::function<std::unique_ptr<DecryptionStrategy>(const LookupTable&, const std::string&)> create;
+};
+
+/**
+ * @struct Result
+ * @brief Timings of one workload; key identifies it across runs
+ */
+struct Result {
+    std::string key;
+    std::string strategy;                    // Strategy name, empty for non-decryption workloads
+    unsigned int length = 0;                 // Password length, 0 for non-decryption workloads
+    size_t samples = 0;
+    double medianMs = 0.0;
+    double p99Ms = 0.0;
+    double itemsPerSecond = 0.0;             // Search nodes, or passwords for encryption
+    uint64_t solutions = 0;
+    size_t missed = 0;                       // Passwords not among the candidates
+    size_t peakBytes = 0;                    // Largest SearchMetrics::peakBytes of the workload
+    size_t peakRssKb = 0;
+};
+
+/**
+ * @brief Every strategy configuration the benchmark knows about
+ */
+std::vector<StrategyEntry> registeredStrategies() {
+    return {
+        {"backtracking", [](const LookupTable&, const std::string&) {
+            return std::unique_ptr<DecryptionStrategy>(new BacktrackingStrategy());
+        }},
+        {"backtracking-bounds", [](const LookupTable&, const std::string&) {
+            auto strategy = std::unique_ptr<BacktrackingStrategy>(new BacktrackingStrategy());
+            strategy->setReachabilityIndex(false);
+            return std::unique_ptr<DecryptionStrategy>(std::move(strategy));
+        }},
+        {"backtracking-pairs", [](const LookupTable&, const std::string&) {
+            auto strategy = std::unique_ptr<BacktrackingStrategy>(new BacktrackingStrategy());
+            strategy->setPairLookupTail(true);
+            return std::unique_ptr<DecryptionStrategy>(std::move(strategy));
+        }},
+        {"backtracking-parallel", [](const LookupTable&, const std::string&) {
+            auto strategy = std::unique_ptr<BacktrackingStrategy>(new BacktrackingStrategy());
+            strategy->setThreadCount(0);
+            return std::unique_ptr<DecryptionStrategy>(std::move(strategy));
+        }},
+        {"backtracking-multiset", [](const LookupTable&, const std::string&) {
+            auto strategy = std::unique_ptr<BacktrackingStrategy>(new BacktrackingStrategy());
+            strategy->setMultisetSearch(true);
+            return std::unique_ptr<DecryptionStrategy>(std::move(strategy));
+        }},
+        {"mitm", [](const LookupTable&, const std::string&) {
+            return std::unique_ptr<DecryptionStrategy>(new MeetInTheMiddleStrategy());
+        }},
+        // A 1 MiB budget, just above the radix-sort counters, spills every length from 5 on
+        {"mitm-spill", [](const LookupTable&, const std::string& scratch) {
+            auto strategy = std::unique_ptr<MeetInTheMiddleStrategy>(new MeetInTheMiddleStrategy(1.0 / 1024.0));
+            strategy->setSpillDirectory(scratch);
+            return std::unique_ptr<DecryptionStrategy>(std::move(strategy));
+        }},
+        {"schroeppel-shamir", [](const LookupTable&, const std::string&) {
+            return std::unique_ptr<DecryptionStrategy>(new SchroeppelShamirStrategy());
+        }},
+        {"hybrid", [](const LookupTable&, const std::string&) {
+            return std::unique_ptr<DecryptionStrategy>(new HybridStrategy());
+        }},
+        // Lengths 1..3 come from the index, longer ones from backtracking
+        {"inverse-index", [](const LookupTable& table, const std::string& scratch) {
+            std::string path = scratch + "/inverse_index.bin";
+            InverseIndex::build(table, std::min(3u, table.getMaxLength()), path);
+            return std::unique_ptr<DecryptionStrategy>(new InverseIndexStrategy(path));
+        }},
+    };
+}
+
+/**
+ * @brief Empty directory under TMPDIR (or /tmp), removed with its files when destroyed
+ */
+class ScratchDirectory {
+public:
+    ScratchDirectory() {
+        const char* base = std::getenv("TMPDIR");
+        std::string pattern = std::string(base && *base ? base : "/tmp") + "/partition_benchmark.XXXXXX";
+        std::vector<char> name(pattern.begin(), pattern.end());
+        name.push_back('\0');
+        if (!mkdtemp(name.data())) {
+            throw std::runtime_error("Cannot create a scratch directory from " + pattern);
+        }
+        path = name.data();
+    }
+
+    ~ScratchDirectory() {
+        if (DIR* directory = opendir(path.c_str())) {
+            while (dirent* entry = readdir(directory)) {
+                std::string file = entry->d_name;
+                if (file != "." && file != "..") {
+                    std::remove((path + "/" + file).c_str());
+                }
+            }
+            closedir(directory);
+        }
+        rmdir(path.c_str());
+    }
+
+    ScratchDirectory(const ScratchDirectory&) = delete;
+    ScratchDirectory& operator=(const ScratchDirectory&) = delete;
+
+    const std::string& getPath() const { return path; }
+
+private:
+    std::string path;
+};
+
+/**
+ * @brief Silences std::cout while in scope (the library logs every operation)
+ */
+class MutedStdout {
+public:
+    MutedStdout() : saved(std::cout.rdbuf(nullptr)) {}
+    ~MutedStdout() { std::cout.rdbuf(saved); }
+
+private:
+    std::streambuf* saved;
+};
+
+/**
+ * @brief Nearest-rank percentile
+ * @param values Samples (reordered)
+ * @param fraction Percentile as a fraction, e.g. 0.99
+ */
+double percentile(std::vector<double>& values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(std::ceil(fraction * values.size()));
+    return values[std::min(values.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/**
+ * @brief K of a generated password (its symbols are all in the table)
+ */
+mpz_class partitionSum(const LookupTable& table, const std::string& password) {
+    std::vector<SymbolId> symbols;
+    table.parse(password, symbols);
+    mpz_class sum = 0;
+    for (SymbolId symbol : symbols) {
+        sum += table.getSortedValues()[symbol];
+    }
+    return sum;
+}
+
+/**
+ * @brief Reset the peak RSS counter so the next reading covers one workload
+ *
+ * Linux only; elsewhere the reading stays the process-wide peak.
+ */
+void resetPeakRss() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if (clearRefs) {
+        clearRefs << "5";
+    }
+}
+
+/**
+ * @brief Peak resident set size in KiB since the last reset
+ */
+size_t peakRssKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stoul(line.substr(6));
+        }
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss);
+}
+
+std::string quote(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+/**
+ * @brief Parse the command line
+ * @throws std::invalid_argument on unknown options or missing values
+ */
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--table") {
+            options.tablePath = value();
+        } else if (arg == "--max-length") {
+            options.maxLength = static_cast<unsigned int>(std::stoul(value()));
+        } else if (arg == "--samples") {
+            options.samples = static_cast<unsigned int>(std::stoul(value()));
+        } else if (arg == "--seed") {
+            options.seed = std::stoull(value());
+        } else if (arg == "--max-solutions") {
+            options.maxSolutions = std::stoull(value());
+        } else if (arg == "--strategies") {
+            std::stringstream list(value());
+            std::string key;
+            while (std::getline(list, key, ',')) {
+                options.strategies.push_back(key);
+            }
+        } else if (arg == "--json") {
+            options.jsonPath = value();
+        } else if (arg == "--baseline") {
+            options.baselinePath = value();
+        } else if (arg == "--tolerance") {
+            options.tolerance = std::stod(value());
+        } else if (arg == "--min-delta-ms") {
+            options.minDeltaMs = std::stod(value());
+        } else if (arg == "--list") {
+            options.list = true;
+        } else {
+            throw std::invalid_argument("Unknown option " + arg);
+        }
+    }
+    if (options.maxLength == 0 || options.samples == 0) {
+        throw std::invalid_argument("--max-length and --samples must be positive");
+    }
+    return options;
+}
+
+/**
+ * @brief Median load time of the lookup table
+ */
+Result benchmarkTableLoad(const Options& options) {
+    Result result;
+    result.key = "table_load";
+    result.samples = options.samples;
+
+    std::vector<double> times;
+    resetPeakRss();
+    for (unsigned int round = 0; round < options.samples; ++round) {
+        MutedStdout muted;
+        auto start = Clock::now();
+        PartitionEncryption system(options.tablePath);
+        times.push_back(millisecondsSince(start));
+    }
+    result.p99Ms = percentile(times, 0.99);
+    result.medianMs = percentile(times, 0.5);
+    result.peakRssKb = peakRssKb();
+    return result;
+}
+
+/**
+ * @brief Encryption throughput of encrypt() and encryptBatch() on the same passwords
+ * @param passwords Random passwords of every valid length
+ */
+std::vector<Result> benchmarkEncrypt(const Options& options, PartitionEncryption& system,
+                                     const std::vector<std::string>& passwords) {
+    std::string data;
+    std::vector<size_t> offsets(1, 0);
+    for (const std::string& password : passwords) {
+        data += password;
+        offsets.push_back(data.size());
+    }
+    std::vector<uint64_t> out(passwords.size());
+    std::vector<EncryptStatus> status(passwords.size());
+
+    Result single;
+    single.key = "encrypt";
+    Result batch;
+    batch.key = "encrypt_batch";
+    std::vector<double> singleTimes;
+    std::vector<double> batchTimes;
+
+    resetPeakRss();
+    for (unsigned int round = 0; round < options.samples; ++round) {
+        MutedStdout muted;
+        auto start = Clock::now();
+        for (const std::string& password : passwords) {
+            system.encrypt(password);
+        }
+        singleTimes.push_back(millisecondsSince(start));
+    }
+    single.peakRssKb = peakRssKb();
+
+    resetPeakRss();
+    for (unsigned int round = 0; round < options.samples; ++round) {
+        auto start = Clock::now();
+        system.encryptBatch(data.data(), offsets.data(), passwords.size(), out.data(), status.data(), 1);
+        batchTimes.push_back(millisecondsSince(start));
+    }
+    batch.peakRssKb = peakRssKb();
+
+    std::vector<Result> results;
+    for (auto entry : {std::make_pair(&single, &singleTimes), std::make_pair(&batch, &batchTimes)}) {
+        Result& result = *entry.first;
+        result.samples = options.samples;
+        result.p99Ms = percentile(*entry.second, 0.99);
+        result.medianMs = percentile(*entry.second, 0.5);
+        result.itemsPerSecond = result.medianMs > 0.0 ? passwords.size() / (result.medianMs / 1000.0) : 0.0;
+        results.push_back(result);
+    }
+    return results;
+}
+
+/**
+ * @brief Build the ranking tables of each password's target, then rank and unrank it
+ * @param passwordsByLength passwordsByLength[L] holds the samples of length L
+ */
+std::vector<Result> benchmarkSolutionSpace(const Options& options, PartitionEncryption& system,
+                                           const std::vector<std::vector<std::string>>& passwordsByLength) {
+    const LookupTable& table = system.getPreparedTable();
+    std::vector<Result> results;
+
+    for (unsigned int length = 1; length <= options.maxLength; ++length) {
+        Result result;
+        result.key = "solution_space/" + std::to_string(length);
+        result.length = length;
+
+        std::vector<double> times;
+        resetPeakRss();
+        for (const std::string& password : passwordsByLength[length]) {
+            mpz_class target = partitionSum(table, password);
+
+            auto start = Clock::now();
+            SolutionSpace space(target, table, length, length);
+            bool roundTrip = space.unrank(space.rank(password)) == password;
+            times.push_back(millisecondsSince(start));
+
+            result.peakBytes = std::max(result.peakBytes, space.getMemoryBytes());
+            if (!roundTrip) {
+                ++result.missed;
+            }
+        }
+
+        result.samples = times.size();
+        result.p99Ms = percentile(times, 0.99);
+        result.medianMs = percentile(times, 0.5);
+        result.peakRssKb = peakRssKb();
+        results.push_back(result);
+    }
+    return results;
+}
+
+/**
+ * @brief Cache each password's backtracking result, then time the repeat query
+ * @param passwordsByLength passwordsByLength[L] holds the samples of length L
+ */
+std::vector<Result> benchmarkResultCache(const Options& options, PartitionEncryption& system,
+                                         const std::vector<std::vector<std::string>>& passwordsByLength) {
+    const LookupTable& table = system.getPreparedTable();
+    BacktrackingStrategy strategy(true, options.maxSolutions);
+    ResultCache cache;
+    std::vector<Result> results;
+
+    for (unsigned int length = 1; length <= options.maxLength; ++length) {
+        Result result;
+        result.key = "result_cache/" + std::to_string(length);
+        result.length = length;
+
+        std::vector<double> times;
+        resetPeakRss();
+        for (const std::string& password : passwordsByLength[length]) {
+            mpz_class target = partitionSum(table, password);
+            std::string key = ResultCache::makeKey(table.getFingerprint(), system.getConstantC(), target,
+                                                   length, length, strategy.getCacheTag());
+            cache.store(key, strategy.decrypt(target, table, length, length));
+
+            std::vector<std::string> candidates;
+            auto start = Clock::now();
+            bool hit = cache.lookup(key, candidates);
+            times.push_back(millisecondsSince(start));
+
+            result.solutions += candidates.size();
+            // Results over the entry limit are not cached and do not count as misses
+            if (hit && std::find(candidates.begin(), candidates.end(), password) == candidates.end() &&
+                candidates.size() < options.maxSolutions) {
+                ++result.missed;
+            }
+        }
+
+        result.samples = times.size();
+        result.p99Ms = percentile(times, 0.99);
+        result.medianMs = percentile(times, 0.5);
+        result.peakBytes = cache.getMemoryBytes();
+        result.peakRssKb = peakRssKb();
+        results.push_back(result);
+    }
+    return results;
+}
+
+/**
+ * @brief Decrypt the same passwords with one strategy, length by length
+ * @param scratch Directory for the strategy's index and spill files
+ * @param passwordsByLength passwordsByLength[L] holds the samples of length L
+ */
+std::vector<Result> benchmarkStrategy(const Options& options, const StrategyEntry& entry,
+                                      PartitionEncryption& system, const std::string& scratch,
+                                      const std::vector<std::vector<std::string>>& passwordsByLength) {
+    const LookupTable& table = system.getPreparedTable();
+    std::unique_ptr<DecryptionStrategy> strategy;
+    {
+        MutedStdout muted;
+        strategy = entry.create(table, scratch);
+    }
+    std::vector<Result> results;
+
+
+    // Untimed first query so lazily built indexes do not count as latency
+    resetPeakRss();
+    auto setupStart = Clock::now();
+    strategy->decrypt(partitionSum(table, passwordsByLength[options.maxLength].front()), table,
+                      options.maxLength, options.maxLength, [](const std::string&) { return false; });
+    Result setup;
+    setup.key = entry.key + "/setup";
+    setup.strategy = strategy->getName();
+    setup.samples = 1;
+    setup.medianMs = setup.p99Ms = millisecondsSince(setupStart);
+    setup.peakBytes = strategy->getMetrics().peakBytes;
+    setup.peakRssKb = peakRssKb();
+    results.push_back(setup);
+
+    for (unsigned int length = 1; length <= options.maxLength; ++length) {
+        Result result;
+        result.key = entry.key + "/" + std::to_string(length);
+        result.strategy = strategy->getName();
+        result.length = length;
+
+        std::vector<double> times;
+        double totalMs = 0.0;
+        uint64_t totalNodes = 0;
+        resetPeakRss();
+
+        for (const std::string& password : passwordsByLength[length]) {
+            mpz_class target = partitionSum(table, password);
+
+            bool found = false;
+            size_t candidates = 0;
+            auto start = Clock::now();
+            bool completed = strategy->decrypt(target, table, length, length,
+                                               [&](const std::string& candidate) {
+                found = found || candidate == password;
+                return ++candidates < options.maxSolutions;
+            });
+            double ms = millisecondsSince(start);
+
+            times.push_back(ms);
+            totalMs += ms;
+            totalNodes += strategy->getMetrics().nodes;
+            result.solutions += candidates;
+            result.peakBytes = std::max(result.peakBytes, strategy->getMetrics().peakBytes);
+            // A capped query may legitimately stop before reaching the password
+            if (!found && completed) {
+                ++result.missed;
+            }
+        }
+
+        result.samples = times.size();
+        result.p99Ms = percentile(times, 0.99);
+        result.medianMs = percentile(times, 0.5);
+        result.itemsPerSecond = totalMs > 0.0 ? totalNodes / (totalMs / 1000.0) : 0.0;
+        result.peakRssKb = peakRssKb();
+        results.push_back(result);
+    }
+    return results;
+}
+
+/**
+ * @brief The options that define the workload, as one JSON line
+ */
+std::string configJson(const Options& options) {
+    std::ostringstream json;
+    json << "  \"config\": {\"max_length\": " << options.maxLength
+         << ", \"samples\": " << options.samples
+         << ", \"seed\": " << options.seed
+         << ", \"max_solutions\": " << options.maxSolutions
+         << ", \"metrics_enabled\": " << (PARTITION_ENABLE_METRICS ? "true" : "false") << "},";
+    return json.str();
+}
+
+std::string toJson(const Options& options, const std::vector<Result>& results) {
+    std::ostringstream json;
+    json << "{\n" << configJson(options) << "\n"
+         << "  \"results\": [\n";
+    // One result per line keeps the file diffable and easy to read back
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        json << "    {\"key\": " << quote(r.key)
+             << ", \"strategy\": " << quote(r.strategy)
+             << ", \"length\": " << r.length
+             << ", \"samples\": " << r.samples
+             << ", \"median_ms\": " << r.medianMs
+             << ", \"p99_ms\": " << r.p99Ms
+             << ", \"items_per_second\": " << r.itemsPerSecond
+             << ", \"solutions\": " << r.solutions
+             << ", \"missed\": " << r.missed
+             << ", \"peak_bytes\": " << r.peakBytes
+             << ", \"peak_rss_kb\": " << r.peakRssKb << "}"
+             << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
+
+/**
+ * @brief Read key -> median_ms from a file written by toJson()
+ * @param path Baseline file
+ * @param config Receives the baseline's config line
+ * @throws std::runtime_error if the file cannot be opened
+ */
+std::map<std::string, double> loadBaseline(const std::string& path, std::string& config) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open baseline " + path);
+    }
+
+    std::map<std::string, double> medians;
+    std::string line;
+    const std::string keyField = "\"key\": \"";
+    const std::string medianField = "\"median_ms\": ";
+    while (std::getline(file, line)) {
+        if (line.find("\"config\"") != std::string::npos) {
+            config = line;
+            continue;
+        }
+        size_t keyPos = line.find(keyField);
+        size_t medianPos = line.find(medianField);
+        if (keyPos == std::string::npos || medianPos == std::string::npos) {
+            continue;
+        }
+        keyPos += keyField.size();
+        std::string key = line.substr(keyPos, line.find('"', keyPos) - keyPos);
+        medians[key] = std::stod(line.substr(medianPos + medianField.size()));
+    }
+    return medians;
+}
+
+/**
+ * @brief Print the comparison with a baseline
+ * @return Number of regressions
+ */
+size_t compareWithBaseline(const Options& options, const std::vector<Result>& results) {
+    std::string baselineConfig;
+    std::map<std::string, double> baseline = loadBaseline(options.baselinePath, baselineConfig);
+    size_t regressions = 0;
+
+    std::cout << "\nBaseline comparison (" << options.baselinePath << ", tolerance "
+              << options.tolerance * 100.0 << "%)\n";
+    if (baselineConfig != configJson(options)) {
+        std::cout << "  Warning: the baseline was recorded with different options, so the\n"
+                  << "  workloads differ:\n  " << baselineConfig << "\n";
+    }
+    for (const Result& result : results) {
+        auto it = baseline.find(result.key);
+        if (it == baseline.end()) {
+            continue;
+        }
+        double before = it->second;
+        if (result.samples < minBaselineSamples) {
+            std::cout << "  " << std::left << std::setw(28) << result.key << std::right
+                      << "  skipped (" << result.samples << " sample" << (result.samples == 1 ? "" : "s")
+                      << ")\n";
+            continue;
+        }
+        double ratio = before > 0.0 ? result.medianMs / before : 1.0;
+        bool regressed = ratio > 1.0 + options.tolerance && result.medianMs - before > options.minDeltaMs;
+        bool improved = ratio < 1.0 / (1.0 + options.tolerance) && before - result.medianMs > options.minDeltaMs;
+        regressions += regressed;
+
+        std::cout << "  " << std::left << std::setw(28) << result.key << std::right
+                  << std::setw(12) << before << " ms -> " << std::setw(12) << result.medianMs
+                  << " ms  x" << std::setprecision(3) << ratio << std::setprecision(6)
+                  << (regressed ? "  REGRESSION" : improved ? "  improved" : "") << "\n";
+    }
+    return regressions;
+}
+
+void printResult(const Result& r) {
+    std::cout << std::left << std::setw(28) << r.key << std::right
+              << std::setw(12) << std::fixed << std::setprecision(3) << r.medianMs
+              << std::setw(12) << r.p99Ms
+              << std::setw(16) << std::setprecision(0) << r.itemsPerSecond
+              << std::setw(12) << r.solutions
+              << std::setw(12) << r.peakRssKb
+              << (r.missed ? "  MISSED " + std::to_string(r.missed) : "") << "\n"
+              << std::defaultfloat << std::setprecision(6);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<StrategyEntry> strategies;
+    for (const StrategyEntry& entry : registeredStrategies()) {
+        if (options.list) {
+            std::cout << entry.key << "\n";
+        } else if (options.strategies.empty() ||
+                   std::find(options.strategies.begin(), options.strategies.end(), entry.key) !=
+                       options.strategies.end()) {
+            strategies.push_back(entry);
+        }
+    }
+    if (options.list) {
+        return 0;
+    }
+    if (strategies.size() < std::max<size_t>(options.strategies.size(), 1)) {
+        std::cerr << "Error: unknown strategy in --strategies (see --list)" << std::endl;
+        return 1;
+    }
+
+    try {
+        std::unique_ptr<PartitionEncryption> system;
+        {
+            MutedStdout muted;
+            system.reset(new PartitionEncryption(options.tablePath));
+        }
+        const LookupTable& table = system->getPreparedTable();
+        if (options.maxLength > system->getPreparedTable().getMaxLength()) {
+            throw std::invalid_argument("--max-length exceeds the maximum password length");
+        }
+
+        // Same seed, same passwords: lengths 1..maxLength for decryption, then
+        // mixed lengths for the encryption workloads
+        std::mt19937_64 rng(options.seed);
+        std::uniform_int_distribution<size_t> pickSymbol(0, table.size() - 1);
+        auto randomPassword = [&](unsigned int length) {
+            std::vector<SymbolId> symbols(length);
+            for (SymbolId& symbol : symbols) {
+                symbol = static_cast<SymbolId>(pickSymbol(rng));
+            }
+            std::string password;
+            table.spell(symbols.data(), symbols.size(), password);
+            return password;
+        };
+
+        std::vector<std::vector<std::string>> passwordsByLength(options.maxLength + 1);
+        for (unsigned int length = 1; length <= options.maxLength; ++length) {
+            for (unsigned int i = 0; i < options.samples; ++i) {
+                passwordsByLength[length].push_back(randomPassword(length));
+            }
+        }
+        std::uniform_int_distribution<unsigned int> pickLength(1, system->getPreparedTable().getMaxLength());
+        std::vector<std::string> encryptWorkload;
+        for (int i = 0; i < 20000; ++i) {
+            encryptWorkload.push_back(randomPassword(pickLength(rng)));
+        }
+
+        std::cout << std::left << std::setw(28) << "workload" << std::right
+                  << std::setw(12) << "median ms" << std::setw(12) << "p99 ms"
+                  << std::setw(16) << "items/s" << std::setw(12) << "solutions"
+                  << std::setw(12) << "rss KiB" << "\n";
+
+        std::vector<Result> results;
+        results.push_back(benchmarkTableLoad(options));
+        printResult(results.back());
+        for (const Result& result : benchmarkEncrypt(options, *system, encryptWorkload)) {
+            results.push_back(result);
+            printResult(result);
+        }
+
+        size_t missed = 0;
+        for (const Result& result : benchmarkSolutionSpace(options, *system, passwordsByLength)) {
+            results.push_back(result);
+            printResult(result);
+            missed += result.missed;
+        }
+        for (const Result& result : benchmarkResultCache(options, *system, passwordsByLength)) {
+            results.push_back(result);
+            printResult(result);
+            missed += result.missed;
+        }
+        ScratchDirectory scratch;
+        for (const StrategyEntry& entry : strategies) {
+            for (const Result& result : benchmarkStrategy(options, entry, *system, scratch.getPath(),
+                                                          passwordsByLength)) {
+                results.push_back(result);
+                printResult(result);
+                missed += result.missed;
+            }
+        }
+
+        if (!options.jsonPath.empty()) {
+            std::ofstream json(options.jsonPath);
+            if (!json) {
+                throw std::runtime_error("Cannot write " + options.jsonPath);
+            }
+            json << toJson(options, results);
+        }
+
+        size_t regressions = options.baselinePath.empty() ? 0 : compareWithBaseline(options, results);
+
+        if (missed > 0) {
+            std::cerr << "Error: " << missed << " password(s) were not recovered" << std::endl;
+            return 1;
+        }
+        if (regressions > 0) {
+            std::cerr << regressions << " regression(s) against the baseline" << std::endl;
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file checkpoint_batch_test.cpp
+ * @brief Check that batch decryption leaves the checkpoint of an earlier decrypt() alone
+ *
+ * A BacktrackingStrategy with a checkpoint file decrypts one target, which writes
+ * a completed checkpoint, then decrypts a batch of other targets. The checkpoint
+ * file must be byte-for-byte unchanged and still resumable. Files are written to
+ * a fresh temporary directory that is removed afterwards.
+ *
+ * Usage: checkpoint_batch_test [--table PATH]
+ *
+ * Exit status: 0 if the checkpoint survived every batch, 1 otherwise.
+ */
+
+#include "partition_encryption.h"
+#include "backtracking_strategy.h"
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef CHECKPOINT_TEST_DEFAULT_TABLE
+#define CHECKPOINT_TEST_DEFAULT_TABLE "data/lookup_table.csv"
+#endif
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream bytes;
+    bytes << in.rdbuf();
+    return bytes.str();
+}
+
+/**
+ * @brief Create an empty directory under TMPDIR (or /tmp)
+ */
+std::string makeTemporaryDirectory() {
+    const char* base = std::getenv("TMPDIR");
+    std::string pattern = std::string(base && *base ? base : "/tmp") + "/checkpoint_batch_test.XXXXXX";
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+    if (!mkdtemp(name.data())) {
+        throw std::runtime_error("Cannot create a temporary directory from " + pattern);
+    }
+    return name.data();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string tablePath = CHECKPOINT_TEST_DEFAULT_TABLE;
+    if (argc == 3 && std::string(argv[1]) == "--table") {
+        tablePath = argv[2];
+    } else if (argc != 1) {
+        std::cerr << "Usage: checkpoint_batch_test [--table PATH]" << std::endl;
+        return 1;
+    }
+
+    std::string directory;
+    size_t failures = 0;
+    try {
+        std::ostringstream muted;
+        std::streambuf* stdoutBuffer = std::cout.rdbuf(muted.rdbuf());
+        PartitionEncryption system(tablePath);
+        std::cout.rdbuf(stdoutBuffer);
+        const LookupTable& table = system.getPreparedTable();
+
+        directory = makeTemporaryDirectory();
+        const std::string path = directory + "/search.checkpoint";
+
+        BacktrackingStrategy strategy(true, 1000);
+        strategy.setCheckpoint(path, std::chrono::milliseconds(0));
+        const std::vector<mpz_class> batch = {100000, 200000, 12345, 100000};
+
+        for (unsigned int maxLength = 1; maxLength <= 4; ++maxLength) {
+            mpz_class target = table.getMaxValue() * maxLength / 2;
+            strategy.decrypt(target, table, 1, maxLength, [](const std::string&) { return true; });
+            std::string before = readFile(path);
+
+            strategy.decryptBatch(batch, table, 1, maxLength, [](size_t, const std::string&) { return true; });
+            if (readFile(path) != before) {
+                std::cerr << "FAIL: decryptBatch() up to length " << maxLength
+                          << " rewrote the checkpoint of decrypt(" << target.get_str() << ")" << std::endl;
+                ++failures;
+                continue;
+            }
+
+            try {
+                strategy.resume(path, table, [](const std::string&) { return true; });
+            } catch (const std::exception& e) {
+                std::cerr << "FAIL: checkpoint of decrypt(" << target.get_str() << ") is not resumable after "
+                          << "decryptBatch() up to length " << maxLength << ": " << e.what() << std::endl;
+                ++failures;
+            }
+        }
+
+        std::remove(path.c_str());
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        failures = std::max<size_t>(failures, 1);
+    }
+    if (!directory.empty()) {
+        rmdir(directory.c_str());
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " checkpoint check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "Checkpoints survived every batch" << std::endl;
+    return 0;
+}
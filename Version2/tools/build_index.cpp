@@ -0,0 +1,75 @@
+/**
+ * @file build_index.cpp
+ * @brief Build the inverse index file used by InverseIndexStrategy
+ *
+ * Enumerates every password of length 1..--max-length, sorts them by sum and
+ * writes the index for the given lookup table. Build once per table; the index
+ * refuses to open against any other table.
+ *
+ * Usage: build_index [--table PATH] [--max-length N] OUTPUT
+ *   --table PATH          Lookup table CSV (default: data/lookup_table.csv of the source tree)
+ *   --max-length N        Longest password length to index (default 4)
+ *
+ * Exit status: 0 on success, 1 on invalid options or a failed build.
+ */
+
+#include "partition_encryption.h"
+#include "inverse_index.h"
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#ifndef BUILD_INDEX_DEFAULT_TABLE
+#define BUILD_INDEX_DEFAULT_TABLE "data/lookup_table.csv"
+#endif
+
+int main(int argc, char** argv) {
+    std::string tablePath = BUILD_INDEX_DEFAULT_TABLE;
+    unsigned int maxLength = 4;
+    std::string outputPath;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--table") {
+                tablePath = value();
+            } else if (arg == "--max-length") {
+                maxLength = static_cast<unsigned int>(std::stoul(value()));
+            } else if (arg.size() > 1 && arg[0] == '-') {
+                throw std::invalid_argument("Unknown option " + arg);
+            } else if (outputPath.empty()) {
+                outputPath = arg;
+            } else {
+                throw std::invalid_argument("More than one output file given");
+            }
+        }
+        if (outputPath.empty()) {
+            throw std::invalid_argument("Usage: build_index [--table PATH] [--max-length N] OUTPUT");
+        }
+
+        PartitionEncryption system(tablePath);
+        if (maxLength == 0 || maxLength > system.getPreparedTable().getMaxLength()) {
+            throw std::invalid_argument("--max-length must be between 1 and the maximum password length");
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        InverseIndex::build(system.getPreparedTable(), maxLength, outputPath);
+        InverseIndex index(outputPath, system.getPreparedTable());
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Wrote " << outputPath << ": lengths 1-" << maxLength << ", "
+                  << index.getFileBytes() << " bytes in " << seconds << " s" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
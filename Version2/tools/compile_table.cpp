@@ -0,0 +1,63 @@
+/**
+ * @file compile_table.cpp
+ * @brief Convert a CSV lookup table into the compiled binary format
+ *
+ * The compiled table stores the symbols in sort order with their values, native
+ * values, width and fingerprint, so PartitionEncryption loads it without parsing
+ * or sorting. Any path accepted by PartitionEncryption may be given in place of a
+ * CSV file, including a compiled table.
+ *
+ * Usage: compile_table [--max-length N] INPUT OUTPUT
+ *   --max-length N        Longest password length the width is chosen for (default 20)
+ *
+ * Exit status: 0 on success, 1 on invalid options or a failed conversion.
+ */
+
+#include "partition_encryption.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    unsigned int maxLength = 20;
+    std::vector<std::string> paths;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--max-length") {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                maxLength = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg.size() > 1 && arg[0] == '-') {
+                throw std::invalid_argument("Unknown option " + arg);
+            } else {
+                paths.push_back(arg);
+            }
+        }
+        if (paths.size() != 2) {
+            throw std::invalid_argument("Usage: compile_table [--max-length N] INPUT OUTPUT");
+        }
+        if (maxLength == 0) {
+            throw std::invalid_argument("--max-length must be positive");
+        }
+
+        PartitionEncryption system(paths[0]);
+        LookupTable table(system.getLookupTable(), maxLength);
+        table.save(paths[1]);
+
+        // Read it back so a broken file is reported here rather than at load time
+        LookupTable check = LookupTable::load(paths[1]);
+        if (check.getFingerprint() != table.getFingerprint()) {
+            throw std::runtime_error("Compiled table does not read back identically");
+        }
+        std::cout << "Wrote " << paths[1] << ": " << table.size() << " symbols, max length "
+                  << maxLength << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file generate_table.cpp
+ * @brief Generate a lookup table of partition numbers for an alphabet
+ *
+ * Character i of the alphabet is assigned p(first + i * step), computed with the
+ * pentagonal recurrence. The table is written as CSV, or in the compiled binary
+ * format when --format compiled is given or OUTPUT ends in ".ptab".
+ *
+ * Usage: generate_table [options] OUTPUT
+ *        generate_table --value N
+ *   --alphabet CHARS      Characters (UTF-8) in value order (default a-z, A-Z, 0-9)
+ *   --first N             Argument of the first character's value (default 1)
+ *   --step N              Distance between consecutive arguments (default 1)
+ *   --threads N           Worker threads, 0 = all hardware threads (default 0)
+ *   --format csv|compiled Output format (default: by extension, else csv)
+ *   --max-length N        Longest password length of a compiled table (default 20)
+ *   --value N             Print p(N) and exit
+ *
+ * Exit status: 0 on success, 1 on invalid options or a failed write.
+ */
+
+#include "lookup_table.h"
+#include "partition_numbers.h"
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+size_t parseCount(const std::string& option, const std::string& value) {
+    size_t used = 0;
+    unsigned long long parsed = std::stoull(value, &used);
+    if (used != value.size()) {
+        throw std::invalid_argument("Invalid value for " + option + ": " + value);
+    }
+    return static_cast<size_t>(parsed);
+}
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() &&
+           text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    size_t first = 1;
+    size_t step = 1;
+    unsigned int threads = 0;
+    std::string format;
+    unsigned int maxLength = 20;
+    bool printValue = false;
+    size_t valueArgument = 0;
+    std::vector<std::string> paths;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--alphabet" || arg == "--first" || arg == "--step" || arg == "--threads" ||
+                arg == "--format" || arg == "--max-length" || arg == "--value") {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                std::string value = argv[++i];
+                if (arg == "--alphabet") {
+                    alphabet = value;
+                } else if (arg == "--first") {
+                    first = parseCount(arg, value);
+                } else if (arg == "--step") {
+                    step = parseCount(arg, value);
+                } else if (arg == "--threads") {
+                    threads = static_cast<unsigned int>(parseCount(arg, value));
+                } else if (arg == "--format") {
+                    format = value;
+                } else if (arg == "--max-length") {
+                    maxLength = static_cast<unsigned int>(parseCount(arg, value));
+                } else {
+                    printValue = true;
+                    valueArgument = parseCount(arg, value);
+                }
+            } else if (arg.size() > 1 && arg[0] == '-') {
+                throw std::invalid_argument("Unknown option " + arg);
+            } else {
+                paths.push_back(arg);
+            }
+        }
+
+        if (printValue) {
+            std::vector<mpz_class> p = partitionNumbers(valueArgument, threads);
+            std::cout << p[valueArgument].get_str() << std::endl;
+            return 0;
+        }
+
+        if (paths.size() != 1) {
+            throw std::invalid_argument("Usage: generate_table [options] OUTPUT | generate_table --value N");
+        }
+        if (format.empty()) {
+            format = endsWith(paths[0], ".ptab") ? "compiled" : "csv";
+        }
+        if (format != "csv" && format != "compiled") {
+            throw std::invalid_argument("--format must be csv or compiled");
+        }
+        if (maxLength == 0) {
+            throw std::invalid_argument("--max-length must be positive");
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::unordered_map<std::string, mpz_class> symbolToPartition = partitionAlphabet(alphabet, first, step, threads);
+        if (format == "csv") {
+            writeLookupTableCsv(alphabet, symbolToPartition, paths[0]);
+        } else {
+            LookupTable(symbolToPartition, maxLength).save(paths[0]);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Wrote " << paths[0] << ": " << symbolToPartition.size() << " symbols, p("
+                  << first << ") to p(" << first + (symbolToPartition.size() - 1) * step << "), "
+                  << seconds << " s" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file scan_wordlist.cpp
+ * @brief Find the words of a wordlist that encrypt to known Z values
+ *
+ * Loads the target Z values (one decimal value per line), scans the wordlist
+ * with WordlistScanner and prints one "Z<TAB>word" line per match to stdout.
+ * A summary goes to stderr.
+ *
+ * Usage: scan_wordlist [--table PATH] [--threads N] TARGETS WORDLIST
+ *   --table PATH          Lookup table CSV (default: data/lookup_table.csv of the source tree)
+ *   --threads N           Scan threads (default 0 = all hardware threads)
+ *
+ * Exit status: 0 on success, 1 on invalid options, unreadable files or malformed targets.
+ */
+
+#include "partition_encryption.h"
+#include "wordlist_scanner.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef SCAN_WORDLIST_DEFAULT_TABLE
+#define SCAN_WORDLIST_DEFAULT_TABLE "data/lookup_table.csv"
+#endif
+
+namespace {
+
+/**
+ * @brief Read one decimal Z value per line, skipping blank lines
+ */
+std::vector<mpz_class> readTargets(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Could not open targets: " + path);
+    }
+    std::vector<mpz_class> targets;
+    std::string line;
+    size_t number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) {
+            continue;
+        }
+        size_t last = line.find_last_not_of(" \t\r");
+        mpz_class value;
+        if (value.set_str(line.substr(first, last - first + 1), 10) != 0) {
+            throw std::invalid_argument("Malformed Z value on line " + std::to_string(number) + " of " + path);
+        }
+        targets.push_back(value);
+    }
+    return targets;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string tablePath = SCAN_WORDLIST_DEFAULT_TABLE;
+    unsigned int threads = 0;
+    std::vector<std::string> paths;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--table") {
+                tablePath = value();
+            } else if (arg == "--threads") {
+                threads = static_cast<unsigned int>(std::stoul(value()));
+            } else if (arg.size() > 1 && arg[0] == '-') {
+                throw std::invalid_argument("Unknown option " + arg);
+            } else {
+                paths.push_back(arg);
+            }
+        }
+        if (paths.size() != 2) {
+            throw std::invalid_argument("Usage: scan_wordlist [--table PATH] [--threads N] TARGETS WORDLIST");
+        }
+
+        // The system reports loading on stdout, which carries the matches
+        std::streambuf* output = std::cout.rdbuf(std::cerr.rdbuf());
+        PartitionEncryption system(tablePath);
+        std::cout.rdbuf(output);
+        WordlistScanner scanner(system, readTargets(paths[0]));
+
+        std::string line;
+        ScanStats stats = scanner.scanFile(paths[1], [&](uint64_t encrypted, const std::string& word) {
+            line = std::to_string(encrypted);
+            line += '\t';
+            line += word;
+            line += '\n';
+            std::fwrite(line.data(), 1, line.size(), stdout);
+            return true;
+        }, threads);
+        std::fflush(stdout);
+
+        double megabytes = stats.bytes / (1024.0 * 1024.0);
+        std::cerr << "Scanned " << stats.words << " words (" << megabytes << " MiB, "
+                  << stats.encrypted << " valid) against " << scanner.getTargets().size() << " targets in "
+                  << stats.seconds << " s";
+        if (stats.seconds > 0.0) {
+            std::cerr << " (" << megabytes / stats.seconds << " MiB/s)";
+        }
+        std::cerr << ": " << stats.matches << " matches" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}